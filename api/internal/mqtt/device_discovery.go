@@ -3,6 +3,7 @@ package mqtt
 import (
 	"context"
 	"encoding/json"
+	"sync"
 	"time"
 
 	"github.com/google/uuid"
@@ -18,6 +19,23 @@ type DeviceDiscoveryHandler struct {
 	publisher   *Publisher
 	lineService LineService
 	logger      *zap.Logger
+
+	// Newest lifecycle message seen per device (birth/death ordering)
+	lifecycleMu   sync.Mutex
+	lifecycleSeqs map[string]lifecycleSeq
+}
+
+// lifecycleSeq orders lifecycle messages: boot_seq first, then session_seq
+type lifecycleSeq struct {
+	boot    uint32
+	session uint32
+}
+
+func (s lifecycleSeq) before(other lifecycleSeq) bool {
+	if s.boot != other.boot {
+		return s.boot < other.boot
+	}
+	return s.session < other.session
 }
 
 // LineService defines the interface for line operations
@@ -33,10 +51,11 @@ func NewDeviceDiscoveryHandler(
 	logger *zap.Logger,
 ) *DeviceDiscoveryHandler {
 	return &DeviceDiscoveryHandler{
-		deviceRepo:  deviceRepo,
-		publisher:   publisher,
-		lineService: lineService,
-		logger:      logger,
+		deviceRepo:    deviceRepo,
+		publisher:     publisher,
+		lineService:   lineService,
+		logger:        logger,
+		lifecycleSeqs: make(map[string]lifecycleSeq),
 	}
 }
 
@@ -119,13 +138,42 @@ func (h *DeviceDiscoveryHandler) HandleDeviceStatus(client mqtt.Client, msg mqtt
 		EthernetConnected bool    `json:"ethernet_connected"`
 		AssignedLine      *string `json:"assigned_line"`
 		Timestamp         int64   `json:"timestamp"`
+		Replayed          bool    `json:"replayed"`
+		Keyframe          *bool   `json:"keyframe"`
+		Event             string  `json:"event"`
 	}
 
-	if err := json.Unmarshal(msg.Payload(), &status); err != nil {
+	if err := decodePayload(msg.Payload(), &status); err != nil {
 		h.logger.Error("Failed to parse device status", zap.Error(err))
 		return
 	}
 
+	// Older firmware replayed queued line states on this topic - they describe
+	// the past and must not override the current status
+	if status.Replayed {
+		h.logger.Debug("Ignoring replayed line state on status topic",
+			zap.String("device_mac", status.DeviceID),
+			zap.String("line_state", status.LineState))
+		return
+	}
+
+	// Older firmware sent birth/death messages on this topic (retained) -
+	// current firmware uses devices/{MAC}/lifecycle
+	if status.Event != "" {
+		h.logger.Debug("Ignoring lifecycle message on status topic",
+			zap.String("device_mac", status.DeviceID),
+			zap.String("event", status.Event))
+		return
+	}
+
+	// Older firmware sent status deltas (only the changed fields, usually no
+	// line_state) on this topic - current firmware uses devices/{MAC}/status-delta
+	if status.Keyframe != nil && !*status.Keyframe {
+		h.logger.Debug("Ignoring status delta on status topic",
+			zap.String("device_mac", status.DeviceID))
+		return
+	}
+
 	// Update last_seen timestamp
 	_, err := h.deviceRepo.GetDeviceByMAC(status.DeviceID)
 	if err != nil {
@@ -218,7 +266,7 @@ func (h *DeviceDiscoveryHandler) HandleInputChange(client mqtt.Client, msg mqtt.
 		Timestamp int64  `json:"timestamp"`
 	}
 
-	if err := json.Unmarshal(msg.Payload(), &inputChange); err != nil {
+	if err := decodePayload(msg.Payload(), &inputChange); err != nil {
 		h.logger.Error("Failed to parse input change", zap.Error(err))
 		return
 	}
@@ -248,6 +296,101 @@ func (h *DeviceDiscoveryHandler) HandleInputChange(client mqtt.Client, msg mqtt.
 	// For example: all inputs HIGH = line running, any LOW = line stopped
 }
 
+// HandleDeviceLifecycle processes birth (retained, on connect) and death
+// (retained last will, or sent on a clean disconnect) messages and sets the
+// device online or offline. A message older than one already seen - by
+// boot_seq, then session_seq - is ignored, so a late death from a previous
+// session cannot mark a reconnected device offline.
+func (h *DeviceDiscoveryHandler) HandleDeviceLifecycle(client mqtt.Client, msg mqtt.Message) {
+	var lifecycle struct {
+		DeviceID   string `json:"device_id"`
+		Event      string `json:"event"`
+		Online     bool   `json:"online"`
+		BootSeq    uint32 `json:"boot_seq"`
+		SessionSeq uint32 `json:"session_seq"`
+	}
+
+	if err := json.Unmarshal(msg.Payload(), &lifecycle); err != nil {
+		h.logger.Error("Failed to parse device lifecycle message", zap.Error(err))
+		return
+	}
+
+	if lifecycle.DeviceID == "" {
+		h.logger.Warn("Device lifecycle message missing device_id",
+			zap.String("topic", msg.Topic()))
+		return
+	}
+
+	seq := lifecycleSeq{boot: lifecycle.BootSeq, session: lifecycle.SessionSeq}
+	h.lifecycleMu.Lock()
+	last, seen := h.lifecycleSeqs[lifecycle.DeviceID]
+	stale := seen && seq.before(last)
+	if !stale {
+		h.lifecycleSeqs[lifecycle.DeviceID] = seq
+	}
+	h.lifecycleMu.Unlock()
+
+	if stale {
+		h.logger.Debug("Ignoring out-of-order lifecycle message",
+			zap.String("device_mac", lifecycle.DeviceID),
+			zap.String("event", lifecycle.Event),
+			zap.Uint32("boot_seq", lifecycle.BootSeq),
+			zap.Uint32("session_seq", lifecycle.SessionSeq))
+		return
+	}
+
+	status := domain.DeviceStatusOffline
+	if lifecycle.Online {
+		status = domain.DeviceStatusOnline
+	}
+
+	if err := h.deviceRepo.UpdateDeviceStatus(lifecycle.DeviceID, status); err != nil {
+		h.logger.Error("Failed to update device status from lifecycle message",
+			zap.String("device_mac", lifecycle.DeviceID),
+			zap.Error(err))
+		return
+	}
+
+	h.logger.Info("Device lifecycle",
+		zap.String("device_mac", lifecycle.DeviceID),
+		zap.String("event", lifecycle.Event),
+		zap.Uint32("boot_seq", lifecycle.BootSeq),
+		zap.Uint32("session_seq", lifecycle.SessionSeq))
+}
+
+// HandleDeviceEvent processes events a device queued while offline and replays
+// after reconnecting. They are history only: the line's current status comes
+// from devices/{MAC}/status, so nothing here changes it.
+func (h *DeviceDiscoveryHandler) HandleDeviceEvent(client mqtt.Client, msg mqtt.Message) {
+	var event struct {
+		DeviceID   string `json:"device_id"`
+		Seq        uint32 `json:"seq"`
+		Event      string `json:"event"`
+		LineState  string `json:"line_state"`
+		Channel    int    `json:"channel"`
+		State      bool   `json:"state"`
+		Timestamp  int64  `json:"timestamp"`
+		TimeSynced bool   `json:"time_synced"`
+		PrevBoot   bool   `json:"prev_boot"`
+	}
+
+	if err := decodePayload(msg.Payload(), &event); err != nil {
+		h.logger.Error("Failed to parse device event", zap.Error(err))
+		return
+	}
+
+	h.logger.Info("Replayed device event",
+		zap.String("device_mac", event.DeviceID),
+		zap.Uint32("seq", event.Seq),
+		zap.String("event", event.Event),
+		zap.String("line_state", event.LineState),
+		zap.Int("channel", event.Channel),
+		zap.Bool("state", event.State),
+		zap.Int64("device_timestamp", event.Timestamp),
+		zap.Bool("time_synced", event.TimeSynced),
+		zap.Bool("prev_boot", event.PrevBoot))
+}
+
 // StartStaleDeviceMonitor starts a background task to mark stale devices offline
 func (h *DeviceDiscoveryHandler) StartStaleDeviceMonitor() {
 	ticker := time.NewTicker(1 * time.Minute)
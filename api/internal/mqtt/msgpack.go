@@ -0,0 +1,199 @@
+package mqtt
+
+import (
+	"encoding/binary"
+	"encoding/json"
+	"errors"
+	"fmt"
+	"math"
+)
+
+// Devices publish status, status-delta, input-change and events payloads as
+// JSON, or as MessagePack when their payload_format is "msgpack". Both carry
+// the same fields, so a MessagePack payload is converted to JSON and decoded
+// into the same structs.
+
+var errMsgpackTruncated = errors.New("msgpack: unexpected end of payload")
+
+// decodePayload unmarshals a device payload (JSON or MessagePack) into v
+func decodePayload(payload []byte, v interface{}) error {
+	if !isMsgpackMap(payload) {
+		return json.Unmarshal(payload, v)
+	}
+
+	value, rest, err := decodeMsgpack(payload)
+	if err != nil {
+		return err
+	}
+	if len(rest) != 0 {
+		return fmt.Errorf("msgpack: %d trailing bytes", len(rest))
+	}
+
+	converted, err := json.Marshal(value)
+	if err != nil {
+		return fmt.Errorf("msgpack: %w", err)
+	}
+	return json.Unmarshal(converted, v)
+}
+
+// isMsgpackMap reports whether the payload starts with a MessagePack map
+// (fixmap, map 16, map 32). A JSON object starts with '{', which MessagePack
+// would read as a bare integer - never a device message.
+func isMsgpackMap(payload []byte) bool {
+	if len(payload) == 0 {
+		return false
+	}
+	b := payload[0]
+	return (b >= 0x80 && b <= 0x8f) || b == 0xde || b == 0xdf
+}
+
+// decodeMsgpack decodes one value and returns the remaining bytes. Maps become
+// map[string]interface{}, arrays []interface{}; extension types are rejected.
+func decodeMsgpack(data []byte) (interface{}, []byte, error) {
+	if len(data) == 0 {
+		return nil, nil, errMsgpackTruncated
+	}
+
+	b := data[0]
+	data = data[1:]
+
+	switch {
+	case b <= 0x7f: // positive fixint
+		return int64(b), data, nil
+	case b >= 0xe0: // negative fixint
+		return int64(int8(b)), data, nil
+	case b >= 0x80 && b <= 0x8f: // fixmap
+		return decodeMsgpackMap(data, int(b&0x0f))
+	case b >= 0x90 && b <= 0x9f: // fixarray
+		return decodeMsgpackArray(data, int(b&0x0f))
+	case b >= 0xa0 && b <= 0xbf: // fixstr
+		return decodeMsgpackString(data, int(b&0x1f))
+	}
+
+	switch b {
+	case 0xc0:
+		return nil, data, nil
+	case 0xc2:
+		return false, data, nil
+	case 0xc3:
+		return true, data, nil
+	case 0xc4, 0xc5, 0xc6: // bin 8/16/32 - carried as a string
+		n, rest, err := msgpackLength(data, b-0xc4)
+		if err != nil {
+			return nil, nil, err
+		}
+		return decodeMsgpackString(rest, n)
+	case 0xca:
+		if len(data) < 4 {
+			return nil, nil, errMsgpackTruncated
+		}
+		return float64(math.Float32frombits(binary.BigEndian.Uint32(data))), data[4:], nil
+	case 0xcb:
+		if len(data) < 8 {
+			return nil, nil, errMsgpackTruncated
+		}
+		return math.Float64frombits(binary.BigEndian.Uint64(data)), data[8:], nil
+	case 0xcc, 0xcd, 0xce, 0xcf: // uint 8/16/32/64
+		size := 1 << (b - 0xcc)
+		if len(data) < size {
+			return nil, nil, errMsgpackTruncated
+		}
+		return msgpackUint(data[:size]), data[size:], nil
+	case 0xd0, 0xd1, 0xd2, 0xd3: // int 8/16/32/64
+		size := 1 << (b - 0xd0)
+		if len(data) < size {
+			return nil, nil, errMsgpackTruncated
+		}
+		u := msgpackUint(data[:size])
+		shift := 64 - 8*uint(size)
+		return int64(u<<shift) >> shift, data[size:], nil
+	case 0xd9, 0xda, 0xdb: // str 8/16/32
+		n, rest, err := msgpackLength(data, b-0xd9)
+		if err != nil {
+			return nil, nil, err
+		}
+		return decodeMsgpackString(rest, n)
+	case 0xdc, 0xdd: // array 16/32
+		n, rest, err := msgpackLength(data, b-0xdc+1)
+		if err != nil {
+			return nil, nil, err
+		}
+		return decodeMsgpackArray(rest, n)
+	case 0xde, 0xdf: // map 16/32
+		n, rest, err := msgpackLength(data, b-0xde+1)
+		if err != nil {
+			return nil, nil, err
+		}
+		return decodeMsgpackMap(rest, n)
+	}
+
+	return nil, nil, fmt.Errorf("msgpack: unsupported type 0x%02x", b)
+}
+
+// msgpackLength reads a big-endian length of 1, 2 or 4 bytes (sizeClass 0, 1, 2)
+func msgpackLength(data []byte, sizeClass byte) (int, []byte, error) {
+	size := 1 << sizeClass
+	if len(data) < size {
+		return 0, nil, errMsgpackTruncated
+	}
+	n := msgpackUint(data[:size])
+	if n > uint64(math.MaxInt32) {
+		return 0, nil, fmt.Errorf("msgpack: length %d too large", n)
+	}
+	return int(n), data[size:], nil
+}
+
+func msgpackUint(data []byte) uint64 {
+	var u uint64
+	for _, b := range data {
+		u = u<<8 | uint64(b)
+	}
+	return u
+}
+
+func decodeMsgpackString(data []byte, n int) (interface{}, []byte, error) {
+	if len(data) < n {
+		return nil, nil, errMsgpackTruncated
+	}
+	return string(data[:n]), data[n:], nil
+}
+
+func decodeMsgpackArray(data []byte, n int) (interface{}, []byte, error) {
+	if n > len(data) { // Every element takes at least one byte
+		return nil, nil, errMsgpackTruncated
+	}
+	array := make([]interface{}, 0, n)
+	for i := 0; i < n; i++ {
+		value, rest, err := decodeMsgpack(data)
+		if err != nil {
+			return nil, nil, err
+		}
+		array = append(array, value)
+		data = rest
+	}
+	return array, data, nil
+}
+
+func decodeMsgpackMap(data []byte, n int) (interface{}, []byte, error) {
+	if 2*n > len(data) { // Every key and value takes at least one byte
+		return nil, nil, errMsgpackTruncated
+	}
+	object := make(map[string]interface{}, n)
+	for i := 0; i < n; i++ {
+		key, rest, err := decodeMsgpack(data)
+		if err != nil {
+			return nil, nil, err
+		}
+		name, ok := key.(string)
+		if !ok {
+			return nil, nil, fmt.Errorf("msgpack: map key of type %T", key)
+		}
+		value, rest, err := decodeMsgpack(rest)
+		if err != nil {
+			return nil, nil, err
+		}
+		object[name] = value
+		data = rest
+	}
+	return object, data, nil
+}
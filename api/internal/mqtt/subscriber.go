@@ -96,6 +96,14 @@ func (s *Subscriber) Start() error {
 			topic:   "devices/+/input-change",
 			handler: s.deviceDiscoveryHandler.HandleInputChange,
 		},
+		{
+			topic:   "devices/+/lifecycle",
+			handler: s.deviceDiscoveryHandler.HandleDeviceLifecycle,
+		},
+		{
+			topic:   "devices/+/events",
+			handler: s.deviceDiscoveryHandler.HandleDeviceEvent,
+		},
 	}
 	s.subMu.Unlock()
 
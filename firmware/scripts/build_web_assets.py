@@ -0,0 +1,101 @@
+"""Compress the configuration UI (webui/) into a PROGMEM header.
+
+Runs before every PlatformIO build (extra_scripts in platformio.ini) and can
+also be run by hand:  python scripts/build_web_assets.py
+
+Each file in webui/ becomes one gzip blob in src/wifi/web_assets_data.h with
+its URL path, content type and a strong ETag (hash of the compressed bytes).
+The output is deterministic (gzip mtime 0) and only rewritten when it
+changes, so unchanged assets keep their ETag and do not trigger a rebuild.
+
+URL paths: index.html -> /, <name>.html -> /<name>, anything else -> /<file>
+"""
+
+import gzip
+import hashlib
+import os
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO (SCons)
+    PROJECT_DIR = env.subst("$PROJECT_DIR")  # noqa: F821
+except NameError:
+    PROJECT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+SOURCE_DIR = os.path.join(PROJECT_DIR, "webui")
+OUTPUT_PATH = os.path.join(PROJECT_DIR, "src", "wifi", "web_assets_data.h")
+
+CONTENT_TYPES = {
+    ".html": "text/html",
+    ".css": "text/css",
+    ".js": "application/javascript",
+    ".json": "application/json",
+    ".svg": "image/svg+xml",
+    ".ico": "image/x-icon",
+}
+
+
+def url_path(filename):
+    name, ext = os.path.splitext(filename)
+    if filename == "index.html":
+        return "/"
+    if ext == ".html":
+        return "/" + name
+    return "/" + filename
+
+
+def to_c_array(data):
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append("    " + ", ".join("0x%02x" % b for b in data[i:i + 16]) + ",")
+    return "\n".join(lines)
+
+
+def build():
+    files = sorted(f for f in os.listdir(SOURCE_DIR)
+                   if os.path.splitext(f)[1] in CONTENT_TYPES)
+
+    out = [
+        "// Generated by scripts/build_web_assets.py from webui/ - do not edit",
+        "#pragma once",
+        "",
+    ]
+    table = []
+    raw_total = 0
+    gz_total = 0
+
+    for index, filename in enumerate(files):
+        with open(os.path.join(SOURCE_DIR, filename), "rb") as f:
+            raw = f.read()
+        data = gzip.compress(raw, compresslevel=9, mtime=0)
+        etag = hashlib.sha256(data).hexdigest()[:16]
+        raw_total += len(raw)
+        gz_total += len(data)
+
+        out.append("// %s (%d bytes, %d gzipped)" % (filename, len(raw), len(data)))
+        out.append("static const uint8_t WEB_ASSET_%d[] PROGMEM = {" % index)
+        out.append(to_c_array(data))
+        out.append("};")
+        out.append("")
+        table.append('    { "%s", "%s", WEB_ASSET_%d, %d, "\\"%s\\"" },'
+                     % (url_path(filename), CONTENT_TYPES[os.path.splitext(filename)[1]],
+                        index, len(data), etag))
+
+    out.append("static const WebAsset WEB_ASSET_TABLE[] = {")
+    out.extend(table)
+    out.append("};")
+    out.append("")
+
+    content = "\n".join(out)
+    try:
+        with open(OUTPUT_PATH, "r") as f:
+            if f.read() == content:
+                return
+    except OSError:
+        pass
+
+    with open(OUTPUT_PATH, "w") as f:
+        f.write(content)
+    print("Web assets: %d files, %d bytes -> %d gzipped" % (len(files), raw_total, gz_total))
+
+
+build()
@@ -0,0 +1,159 @@
+"""Load test for the device web server - checks main loop latency under load.
+
+Opens N concurrent keep-alive clients against a running device and has them
+fetch the UI pages, assets (half of them revalidated with If-None-Match) and
+/api/info for a fixed time. A separate monitor polls /status once a second
+and records loop.max_us, the longest loop() iteration since its previous
+poll. The run fails if any second exceeds the latency budget.
+
+    python scripts/http_load_test.py 192.168.1.50
+    python scripts/http_load_test.py 192.168.1.50 --clients 20 --duration 60 --budget-ms 20
+
+Python 3 standard library only. Not part of the build.
+"""
+
+import argparse
+import http.client
+import json
+import random
+import sys
+import threading
+import time
+
+PATHS = ["/", "/wifi", "/mqtt", "/device", "/style.css", "/app.js", "/api/info"]
+
+
+class Stats:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.latencies = []
+        self.statuses = {}
+        self.errors = 0
+        self.reconnects = 0
+
+    def record(self, status, seconds):
+        with self.lock:
+            self.latencies.append(seconds)
+            self.statuses[status] = self.statuses.get(status, 0) + 1
+
+    def error(self):
+        with self.lock:
+            self.errors += 1
+
+
+def client(host, port, deadline, timeout, stats):
+    conn = http.client.HTTPConnection(host, port, timeout=timeout)
+    etags = {}
+
+    while time.monotonic() < deadline:
+        path = random.choice(PATHS)
+        headers = {"Accept-Encoding": "gzip"}
+        if path in etags and random.random() < 0.5:
+            headers["If-None-Match"] = etags[path]
+
+        start = time.monotonic()
+        try:
+            conn.request("GET", path, headers=headers)
+            response = conn.getresponse()
+            response.read()
+            stats.record(response.status, time.monotonic() - start)
+            if response.getheader("ETag"):
+                etags[path] = response.getheader("ETag")
+        except (OSError, http.client.HTTPException):
+            # Server closed an idle keep-alive connection (LRU) or timed out
+            stats.error()
+            conn.close()
+            conn = http.client.HTTPConnection(host, port, timeout=timeout)
+            with stats.lock:
+                stats.reconnects += 1
+
+    conn.close()
+
+
+def get_status(host, port, timeout):
+    conn = http.client.HTTPConnection(host, port, timeout=timeout)
+    try:
+        conn.request("GET", "/status")
+        return json.loads(conn.getresponse().read())
+    finally:
+        conn.close()
+
+
+def monitor(host, port, deadline, timeout, samples):
+    while time.monotonic() < deadline:
+        time.sleep(1.0)
+        try:
+            status = get_status(host, port, timeout)
+            samples.append((status["loop"]["max_us"], status["http"]["connections"]))
+        except (OSError, http.client.HTTPException, ValueError, KeyError):
+            samples.append(None)
+
+
+def percentile(values, fraction):
+    if not values:
+        return 0.0
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * fraction))]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("host", help="device IP address or hostname")
+    parser.add_argument("--port", type=int, default=80)
+    parser.add_argument("--clients", type=int, default=20)
+    parser.add_argument("--duration", type=float, default=30.0, help="seconds")
+    parser.add_argument("--budget-ms", type=float, default=20.0,
+                        help="maximum loop() iteration time allowed")
+    parser.add_argument("--timeout", type=float, default=10.0, help="per-request timeout (s)")
+    args = parser.parse_args()
+
+    # Baseline (also resets the device's loop maximum)
+    baseline = get_status(args.host, args.port, args.timeout)
+    print("Device %s, loop max before test: %d us"
+          % (baseline["device_id"], baseline["loop"]["max_us"]))
+
+    stats = Stats()
+    samples = []
+    deadline = time.monotonic() + args.duration
+
+    threads = [threading.Thread(target=client,
+                                args=(args.host, args.port, deadline, args.timeout, stats))
+               for _ in range(args.clients)]
+    threads.append(threading.Thread(target=monitor,
+                                    args=(args.host, args.port, deadline, args.timeout, samples)))
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+
+    requests = len(stats.latencies)
+    print("\n%d clients, %.0f s: %d requests (%.1f/s), %d errors, %d reconnects"
+          % (args.clients, args.duration, requests, requests / args.duration,
+             stats.errors, stats.reconnects))
+    print("Status codes: %s" % ", ".join("%d x%d" % item for item in sorted(stats.statuses.items())))
+    print("Request latency: p50 %.0f ms, p95 %.0f ms, max %.0f ms"
+          % (percentile(stats.latencies, 0.5) * 1000, percentile(stats.latencies, 0.95) * 1000,
+             max(stats.latencies, default=0) * 1000))
+
+    loop_samples = [s for s in samples if s is not None]
+    missed = len(samples) - len(loop_samples)
+    budget_us = args.budget_ms * 1000
+    over = [s for s in loop_samples if s[0] > budget_us]
+    worst = max((s[0] for s in loop_samples), default=0)
+    peak_connections = max((s[1] for s in loop_samples), default=0)
+
+    print("Main loop: worst iteration %d us (budget %d us), %d/%d seconds over budget"
+          % (worst, budget_us, len(over), len(loop_samples)))
+    print("Open connections (peak sampled): %d" % peak_connections)
+    if missed:
+        print("Monitor: %d /status polls failed" % missed)
+
+    if not loop_samples or over:
+        print("FAIL")
+        return 1
+    print("PASS")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
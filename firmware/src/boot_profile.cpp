@@ -0,0 +1,47 @@
+#include "boot_profile.h"
+#include <esp_timer.h>
+
+BootProfile::BootProfile()
+    : phaseCount(0) {
+    portMUX_INITIALIZE(&lock);
+}
+
+void BootProfile::mark(const char* phase) {
+    uint32_t ms = (uint32_t)(esp_timer_get_time() / 1000);
+    bool recorded = false;
+
+    portENTER_CRITICAL(&lock);
+    bool known = false;
+    for (uint8_t i = 0; i < phaseCount; i++) {
+        if (strcmp(phases[i].name, phase) == 0) {
+            known = true;
+            break;
+        }
+    }
+    if (!known && phaseCount < MAX_PHASES) {
+        phases[phaseCount].name = phase;
+        phases[phaseCount].ms = ms;
+        phaseCount++;
+        recorded = true;
+    }
+    portEXIT_CRITICAL(&lock);
+
+    if (recorded) {
+        Serial.printf("[boot] %s @ %lu ms\n", phase, ms);
+    }
+}
+
+const char* BootProfile::getPhaseName(uint8_t index) const {
+    return (index < phaseCount) ? phases[index].name : "";
+}
+
+uint32_t BootProfile::getPhaseMs(uint8_t index) const {
+    return (index < phaseCount) ? phases[index].ms : 0;
+}
+
+void BootProfile::print() const {
+    Serial.println("Boot phase timings:");
+    for (uint8_t i = 0; i < phaseCount; i++) {
+        Serial.printf("  %-14s %6lu ms\n", phases[i].name, phases[i].ms);
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+
+/**
+ * Boot Phase Timing
+ *
+ * Records when each boot phase completed, in ms since app start
+ * (esp_timer). Phases marked from setup() give the fast-boot pipeline
+ * timings; milestones reached later in the background (network up, MQTT
+ * connected) are marked from their callbacks. Each phase is recorded once,
+ * so repeated events (e.g. reconnects) keep the first-boot value.
+ *
+ * Reported in the device announcement.
+ */
+class BootProfile {
+public:
+    static const uint8_t MAX_PHASES = 16;
+
+    BootProfile();
+
+    // Record the end of a phase (name must be a string literal; ignored if already marked)
+    void mark(const char* phase);
+
+    // Recorded phases in the order they completed
+    uint8_t getPhaseCount() const { return phaseCount; }
+    const char* getPhaseName(uint8_t index) const;
+    uint32_t getPhaseMs(uint8_t index) const;
+
+    // Print all phases to Serial
+    void print() const;
+
+private:
+    struct Phase {
+        const char* name;
+        uint32_t ms;
+    };
+
+    Phase phases[MAX_PHASES];
+    volatile uint8_t phaseCount;
+    portMUX_TYPE lock;       // Background milestones are marked from network/MQTT callbacks
+};
@@ -16,7 +16,12 @@
 #define MQTT_TOPIC_DEVICE_PREFIX "devices/"
 #define MQTT_TOPIC_COMMAND_SUFFIX "/command"
 #define MQTT_TOPIC_STATUS_SUFFIX "/status"
+#define MQTT_TOPIC_STATUS_DELTA_SUFFIX "/status-delta"  // Status deltas between keyframes
+#define MQTT_TOPIC_RESPONSE_SUFFIX "/response"
+#define MQTT_TOPIC_LIFECYCLE_SUFFIX "/lifecycle"  // Retained birth / last will (death)
 #define MQTT_TOPIC_INPUT_SUFFIX "/input-change"
+#define MQTT_TOPIC_COUNTER_SUFFIX "/counters"
+#define MQTT_TOPIC_EVENTS_SUFFIX "/events"    // Replayed (offline-queued) events - history, never current state
 
 // Legacy topics (for backward compatibility during migration)
 #define MQTT_TOPIC_LEGACY_COMMAND "production-lines/commands/status"
@@ -29,13 +34,69 @@
 #define SUBNET "255.255.255.0"
 #define DNS_SERVER "8.8.8.8"
 
+// Time Synchronization (SNTP)
+#define NTP_SERVER "pool.ntp.org"         // Default server (set a local one via DeviceConfig)
+#define NTP_SYNC_INTERVAL 900000          // Re-sync every 15 minutes (drift estimation)
+#define TIME_DRIFT_MAX_PPM 200.0f         // Clamp for the oscillator drift estimate
+
 // Timing Configuration
-#define HEARTBEAT_INTERVAL 30000  // 30 seconds
+#define ANNOUNCEMENT_INTERVAL 60000  // Retained device announcement refresh (60s)
+#define HEARTBEAT_INTERVAL 30000  // 30 seconds (base status interval)
+#define HEARTBEAT_INTERVAL_MAX 300000  // Stretched up to 5 minutes while stable
+#define STATUS_KEYFRAME_EVERY 10  // Full status every N heartbeats, deltas in between
 #define DEBOUNCE_DELAY 50         // 50ms debounce for inputs
 #define BOOT_STABILIZATION_DELAY 100  // 100ms wait after boot for glitches to settle
+#define BOOT_SERIAL_WAIT 0            // USB CDC enumeration wait (ms) - 0 for fast boot, 1000 to see early logs
 #define INPUT_READY_DELAY 50      // Hardware stabilization before first read
                                   // Note: INPUT_GRACE_PERIOD (2s) in digital_input.cpp suppresses callbacks
 
+// Input Capture Configuration
+#define INPUT_CAPTURE_ISR true            // Timestamp edges via GPIO ISR (false = estimate from samples)
+#define INPUT_EVENT_QUEUE_SIZE 256        // ISR edge ring buffer slots (power of two)
+#define INPUT_SAMPLE_INTERVAL_US (DEBOUNCE_DELAY * 1000UL / 8)  // Polled mode: 8 samples per debounce window
+
+// I/O Task Configuration
+#define IO_TASK_PERIOD_MS 1               // Input sampling / output update period (1ms)
+#define IO_TASK_CORE 0                    // Arduino loop() runs on core 1
+#define IO_TASK_PRIORITY 10               // Above loop (1), below WiFi/LwIP
+#define IO_TASK_STACK_SIZE 4096
+#define IO_EVENT_QUEUE_LENGTH 64          // I/O -> network events
+#define IO_COMMAND_QUEUE_LENGTH 8         // Network -> I/O commands
+
+// Shared I2C Bus Configuration (TCA9554PWR outputs + SSD1306 display)
+#define I2C_BUS_FREQUENCY 400000          // Fast-mode: max rate of both TCA9554 and SSD1306
+#define I2C_BUS_TASK_CORE IO_TASK_CORE    // Output writes follow the I/O tick on the same core
+#define I2C_BUS_TASK_PRIORITY (IO_TASK_PRIORITY - 1)  // Runs as soon as the I/O tick yields
+#define I2C_BUS_TASK_STACK_SIZE 3072
+#define I2C_BUS_HIGH_QUEUE_LENGTH 16      // Output register writes
+#define I2C_BUS_LOW_QUEUE_LENGTH 48       // Display transfers (one full frame = 40 requests)
+#define I2C_BUS_MAX_DEVICES 4             // Devices with latency statistics
+
+// Device Web Server Configuration (esp_http_server task)
+#define WEB_TASK_CORE 0                   // Off the loop() core
+#define WEB_TASK_PRIORITY 3               // Below MQTT (5) and I/O (10)
+#define WEB_TASK_STACK_SIZE 7168          // Holds WEB_CHUNK_SIZE / WEB_FORM_MAX_SIZE buffers + a settings copy
+#define WEB_MAX_CONNECTIONS 8             // Open keep-alive clients (LRU one closed when full)
+#define WEB_BACKLOG 12                    // Connections waiting to be accepted
+#define WEB_REQUEST_TIMEOUT 5             // Per-request receive/send timeout (seconds)
+#define WEB_CHUNK_SIZE 1024               // Response bytes buffered per HTTP chunk (stack)
+#define WEB_FORM_MAX_SIZE 512             // Largest accepted form body
+#define WEB_DEBUG false                   // Log every request (URI, duration, heap delta) to Serial
+
+// Pulse Counter Configuration (PCNT)
+#define COUNTER_CHANNEL_MASK 0x00         // Default DIN channels in counter mode (bit 0 = DIN1, reserved)
+#define COUNTER_PCNT_LIMIT 30000          // Hardware count limit before overflow extension (< 32767)
+#define COUNTER_GLITCH_FILTER_NS 10000    // PCNT glitch filter (max ~12700ns at 80MHz APB)
+#define COUNTER_RATE_WINDOW 10000         // Parts-per-minute averaging window (10s)
+#define COUNTER_PUBLISH_INTERVAL 10000    // Periodic counter message interval (10s)
+#define COUNTER_CHECKPOINT_INTERVAL 60000 // NVS checkpoint interval (60s)
+
+// Offline Event Store Configuration (store-and-forward)
+#define EVENT_STORE_CAPACITY 2048         // Queued events held while MQTT is down (PSRAM ring)
+#define EVENT_STORE_OVERFLOW_POLICY 0     // When full: 0 = drop oldest, 1 = drop newest
+#define EVENT_REPLAY_BATCH 5              // Events replayed per interval after reconnect
+#define EVENT_REPLAY_INTERVAL 50          // Replay pacing (ms) - ~100 events/s
+
 // WiFi Configuration
 #define WIFI_AP_CHANNEL 6                 // WiFi channel for AP mode
 #define WIFI_AP_MAX_CONNECTIONS 4         // Max clients in AP mode
@@ -67,14 +128,59 @@
 #define BUTTON_LED_MAINTENANCE_PERIOD 500  // 500ms blink for maintenance
 #define BUTTON_LED_ERROR_PERIOD 200        // 200ms fast blink for error
 
+// Indicator Pattern Engine (status LED, button LED, RGB LED, buzzer)
+#define PATTERN_TICK_MS 10                 // esp_timer tick - pattern step resolution
+#define PATTERN_MAX_SLOTS 8                // Indicators driven by the engine
+#define IDENTIFY_DEFAULT_DURATION 10       // flash_identify without "duration" (seconds)
+#define IDENTIFY_MAX_DURATION 300          // Longer flash_identify requests are clamped (seconds)
+
 // MQTT Buffer Configuration
-#define MQTT_MAX_PACKET_SIZE 512          // Maximum MQTT packet size
+#define MQTT_MAX_PACKET_SIZE 1536         // esp_mqtt I/O buffer (larger publishes are queued whole, sent in parts)
+#define MQTT_MAX_PAYLOAD_SIZE 16384       // Largest outgoing payload (refused, not truncated, above)
+#define MALLOC_AUDIT_WARMUP 120000        // -DMALLOC_AUDIT: loop may allocate during the first 2 minutes
+#define MQTT_PAYLOAD_STACK_SIZE 512       // Payloads up to this size are serialized on the stack
+
+// MQTT Client Task Configuration (esp_mqtt)
+#define MQTT_TASK_PRIORITY 5              // Below I/O task (10)
+#define MQTT_TASK_STACK_SIZE 6144
+#define MQTT_KEEPALIVE 30                 // Keepalive (seconds)
+#define MQTT_BACKOFF_MIN 250              // Reconnect delay floor (ms)
+#define MQTT_BACKOFF_BASE 2000            // First retry window - doubles per failed attempt (ms)
+#define MQTT_BACKOFF_MAX 120000           // Retry window cap (ms)
+#define MQTT_POST_CONNECT_WINDOW 10000    // Announcement/replay spread after connect (ms)
+#define MQTT_NETWORK_TIMEOUT 5000         // Socket/handshake timeout inside the MQTT task (ms)
+#define MQTT_STOP_GRACE 1000              // disconnect(): let the outbox send the death message before stopping (ms)
+#define MQTT_INBOUND_QUEUE_LENGTH 4       // Commands waiting for loop()
+#define MQTT_COMMAND_MAX_LENGTH 256       // Largest accepted command payload
+#define MQTT_COMMAND_POOL_SIZE 1536       // Fixed JSON pool for one parsed command (1 KB slot pool + strings)
+#define MQTT_DOCUMENT_ARENA_SIZE 16384    // Outgoing documents of one message (e.g. status keyframe + its copy)
+#define MQTT_MESSAGE_ARENA_SIZE (MQTT_DOCUMENT_ARENA_SIZE + MQTT_MAX_PAYLOAD_SIZE + 16)  // Per-message arena (PSRAM if present) - documents + largest payload (+ block header)
+#define MQTT_KEYFRAME_POOL_SIZE 4096      // Last status keyframe (kept between messages)
+#define MQTT_REQUEST_ID_MAX_LENGTH 40     // Longest echoed request_id (longer ones are truncated)
+#define MQTT_PENDING_RESPONSES 4          // Commands waiting for the I/O task before replying
+#define MQTT_RESPONSE_TIMEOUT 2000        // Reply with an error if not applied within (ms)
+
+// MQTT QoS Policy (defaults - per device override in DeviceConfig)
+#define MQTT_QOS_STATUS 0                 // Heartbeat - superseded every 30s anyway
+#define MQTT_QOS_LINE_STATE 1             // Line state changes must arrive
+#define MQTT_QOS_INPUT 1                  // Input change events
+#define MQTT_QOS_COUNTERS 0               // Counter totals are cumulative
+#define MQTT_QOS_ANNOUNCE 1               // Retained announcement
+#define MQTT_QOS_LIFECYCLE 1              // Retained birth / last will (death) on the lifecycle topic
+#define MQTT_QOS_RESPONSE 1               // Command responses (the API waits for them)
+#define MQTT_INFLIGHT_MAX 16              // Unacknowledged QoS 1 events tracked at once
+#define MQTT_ACK_TIMEOUT 120000           // Stop tracking an event neither acknowledged nor expired from the outbox within (ms)
+
+// MQTT Payload Encoding (default - per device override in DeviceConfig)
+#define MQTT_PAYLOAD_FORMAT 0             // 0 = JSON, 1 = MessagePack (status/input/counters)
 
 // mDNS Configuration
 #define MDNS_ENABLED true                 // Enabled by default
 #define MDNS_SERVICE_NAME "_mqtt"         // Standard MQTT service name
 #define MDNS_PROTOCOL "_tcp"              // TCP protocol
 #define MDNS_DISCOVERY_TIMEOUT 5000       // 5 second discovery timeout
+#define MDNS_TASK_PRIORITY 1              // One-shot broker discovery task (blocks on the query)
+#define MDNS_TASK_STACK_SIZE 5120         // mDNS query + a settings copy
 #define MDNS_CACHE_ENABLED true           // Cache discovered brokers
 #define MDNS_CACHE_EXPIRY 3600000         // 1 hour cache validity (milliseconds)
 
@@ -82,7 +188,7 @@
 #define DISPLAY_I2C_ADDRESS 0x3C          // SSD1306 I2C address (0x3C or 0x3D)
 #define DISPLAY_WIDTH 128                 // OLED display width in pixels
 #define DISPLAY_HEIGHT 64                 // OLED display height in pixels
-#define DISPLAY_REFRESH_INTERVAL 2000     // Display refresh interval (2s)
+#define DISPLAY_REFRESH_INTERVAL 1000     // Display refresh interval (1s - unchanged pages cost no I2C)
 
 // Hardware Configuration (from platformio.ini build_flags)
 // Pin definitions are in build_flags - no need to redefine here
@@ -1,17 +1,49 @@
 #include "device_config.h"
+#include "config.h"
 
 // Global instance
 DeviceConfig deviceConfig;
 
-DeviceConfig::DeviceConfig() {
+// NVS keys and compiled defaults for the per-class MQTT QoS (indexed by MQTTMessageClass)
+static const char* QOS_KEYS[MQTT_CLASS_COUNT] = {
+    "qos_status", "qos_line", "qos_input", "qos_count", "qos_annc"
+};
+static const uint8_t QOS_DEFAULTS[MQTT_CLASS_COUNT] = {
+    MQTT_QOS_STATUS, MQTT_QOS_LINE_STATE, MQTT_QOS_INPUT, MQTT_QOS_COUNTERS, MQTT_QOS_ANNOUNCE
+};
+
+DeviceConfig::DeviceConfig()
+    : settingsLock(nullptr),
+      saveLock(nullptr) {
     memset(&settings, 0, sizeof(settings));
 }
 
 void DeviceConfig::begin() {
+    // Created before any other task runs (setup() calls begin() first)
+    settingsLock = xSemaphoreCreateRecursiveMutex();
+    saveLock = xSemaphoreCreateMutex();
+
     prefs.begin("device_cfg", false);  // false = read/write mode
     loadSettings();
 }
 
+void DeviceConfig::lock() const {
+    if (settingsLock != nullptr) {
+        xSemaphoreTakeRecursive(settingsLock, portMAX_DELAY);
+    }
+}
+
+void DeviceConfig::unlock() const {
+    if (settingsLock != nullptr) {
+        xSemaphoreGiveRecursive(settingsLock);
+    }
+}
+
+void DeviceConfig::copySettings(Settings& out) const {
+    Guard guard(*this);
+    memcpy(&out, &settings, sizeof(out));
+}
+
 void DeviceConfig::loadSettings() {
     // Load existing network settings
     prefs.getString("device_id", settings.deviceID, sizeof(settings.deviceID));
@@ -46,6 +78,21 @@ void DeviceConfig::loadSettings() {
     settings.mdnsCacheEnabled = prefs.getBool("mdns_cache", true);
     settings.mdnsCacheExpiryMs = prefs.getULong("mdns_exp", 3600000);  // 1 hour
 
+    // Load pulse counter settings
+    settings.counterChannels = prefs.getUChar("cnt_mask", COUNTER_CHANNEL_MASK);
+
+    // Load MQTT QoS policy
+    for (int i = 0; i < MQTT_CLASS_COUNT; i++) {
+        settings.mqttQoS[i] = prefs.getUChar(QOS_KEYS[i], QOS_DEFAULTS[i]);
+    }
+    settings.payloadFormat = (PayloadFormat)prefs.getUChar("payload_fmt", MQTT_PAYLOAD_FORMAT);
+
+    // Load time sync settings
+    prefs.getString("ntp_server", settings.ntpServer, sizeof(settings.ntpServer));
+    if (strlen(settings.ntpServer) == 0) {
+        strncpy(settings.ntpServer, NTP_SERVER, sizeof(settings.ntpServer) - 1);
+    }
+
     // Apply defaults if empty
     if (strlen(settings.deviceID) == 0) {
         loadDefaults();
@@ -72,36 +119,71 @@ void DeviceConfig::loadDefaults() {
     settings.mdnsTimeoutMs = 5000;
     settings.mdnsCacheEnabled = true;
     settings.mdnsCacheExpiryMs = 3600000;  // 1 hour
+
+    // Pulse counter defaults
+    settings.counterChannels = COUNTER_CHANNEL_MASK;
+
+    // MQTT QoS defaults
+    for (int i = 0; i < MQTT_CLASS_COUNT; i++) {
+        settings.mqttQoS[i] = QOS_DEFAULTS[i];
+    }
+    settings.payloadFormat = (PayloadFormat)MQTT_PAYLOAD_FORMAT;
+
+    // Time sync defaults
+    strncpy(settings.ntpServer, NTP_SERVER, sizeof(settings.ntpServer) - 1);
 }
 
 bool DeviceConfig::save() {
+    // Write a snapshot - the settings lock is not held during flash writes
+    Settings snapshot;
+    copySettings(snapshot);
+
+    if (saveLock != nullptr) {
+        xSemaphoreTake(saveLock, portMAX_DELAY);
+    }
+
     // Save existing settings
-    prefs.putString("device_id", settings.deviceID);
-    prefs.putString("mqtt_broker", settings.mqttBroker);
-    prefs.putUShort("mqtt_port", settings.mqttPort);
-    prefs.putString("mqtt_user", settings.mqttUser);
-    prefs.putString("mqtt_pass", settings.mqttPassword);
-    prefs.putBool("use_dhcp", settings.useDHCP);
-    prefs.putString("static_ip", settings.staticIP);
-    prefs.putString("gateway", settings.gateway);
-    prefs.putString("subnet", settings.subnet);
-    prefs.putString("dns", settings.dnsServer);
+    prefs.putString("device_id", snapshot.deviceID);
+    prefs.putString("mqtt_broker", snapshot.mqttBroker);
+    prefs.putUShort("mqtt_port", snapshot.mqttPort);
+    prefs.putString("mqtt_user", snapshot.mqttUser);
+    prefs.putString("mqtt_pass", snapshot.mqttPassword);
+    prefs.putBool("use_dhcp", snapshot.useDHCP);
+    prefs.putString("static_ip", snapshot.staticIP);
+    prefs.putString("gateway", snapshot.gateway);
+    prefs.putString("subnet", snapshot.subnet);
+    prefs.putString("dns", snapshot.dnsServer);
 
     // Save WiFi settings
-    prefs.putUChar("conn_mode", settings.connectionMode);
-    prefs.putBool("wifi_en", settings.wifiEnabled);
-    prefs.putString("wifi_ssid", settings.wifiSSID);
-    prefs.putString("wifi_pass", settings.wifiPassword);
-    prefs.putBool("wifi_ap", settings.wifiAPMode);
+    prefs.putUChar("conn_mode", snapshot.connectionMode);
+    prefs.putBool("wifi_en", snapshot.wifiEnabled);
+    prefs.putString("wifi_ssid", snapshot.wifiSSID);
+    prefs.putString("wifi_pass", snapshot.wifiPassword);
+    prefs.putBool("wifi_ap", snapshot.wifiAPMode);
 
     // Save mDNS settings
-    prefs.putBool("mdns_en", settings.mdnsEnabled);
-    prefs.putString("mdns_svc", settings.mdnsServiceName);
-    prefs.putString("mdns_proto", settings.mdnsProtocol);
-    prefs.putUShort("mdns_tmout", settings.mdnsTimeoutMs);
-    prefs.putBool("mdns_cache", settings.mdnsCacheEnabled);
-    prefs.putULong("mdns_exp", settings.mdnsCacheExpiryMs);
+    prefs.putBool("mdns_en", snapshot.mdnsEnabled);
+    prefs.putString("mdns_svc", snapshot.mdnsServiceName);
+    prefs.putString("mdns_proto", snapshot.mdnsProtocol);
+    prefs.putUShort("mdns_tmout", snapshot.mdnsTimeoutMs);
+    prefs.putBool("mdns_cache", snapshot.mdnsCacheEnabled);
+    prefs.putULong("mdns_exp", snapshot.mdnsCacheExpiryMs);
+
+    // Save pulse counter settings
+    prefs.putUChar("cnt_mask", snapshot.counterChannels);
+
+    // Save MQTT QoS policy
+    for (int i = 0; i < MQTT_CLASS_COUNT; i++) {
+        prefs.putUChar(QOS_KEYS[i], snapshot.mqttQoS[i]);
+    }
+    prefs.putUChar("payload_fmt", snapshot.payloadFormat);
 
+    // Save time sync settings
+    prefs.putString("ntp_server", snapshot.ntpServer);
+
+    if (saveLock != nullptr) {
+        xSemaphoreGive(saveLock);
+    }
     return true;
 }
 
@@ -109,8 +191,11 @@ bool DeviceConfig::setDeviceID(const char* id) {
     if (strlen(id) == 0 || strlen(id) >= sizeof(settings.deviceID)) {
         return false;
     }
-    strncpy(settings.deviceID, id, sizeof(settings.deviceID) - 1);
-    settings.deviceID[sizeof(settings.deviceID) - 1] = '\0';
+    {
+        Guard guard(*this);
+        strncpy(settings.deviceID, id, sizeof(settings.deviceID) - 1);
+        settings.deviceID[sizeof(settings.deviceID) - 1] = '\0';
+    }
     return save();
 }
 
@@ -118,9 +203,12 @@ bool DeviceConfig::setMQTTBroker(const char* broker, uint16_t port) {
     if (strlen(broker) == 0 || strlen(broker) >= sizeof(settings.mqttBroker)) {
         return false;
     }
-    strncpy(settings.mqttBroker, broker, sizeof(settings.mqttBroker) - 1);
-    settings.mqttBroker[sizeof(settings.mqttBroker) - 1] = '\0';
-    settings.mqttPort = port;
+    {
+        Guard guard(*this);
+        strncpy(settings.mqttBroker, broker, sizeof(settings.mqttBroker) - 1);
+        settings.mqttBroker[sizeof(settings.mqttBroker) - 1] = '\0';
+        settings.mqttPort = port;
+    }
     return save();
 }
 
@@ -128,10 +216,13 @@ bool DeviceConfig::setMQTTAuth(const char* user, const char* password) {
     if (strlen(user) >= sizeof(settings.mqttUser) || strlen(password) >= sizeof(settings.mqttPassword)) {
         return false;
     }
-    strncpy(settings.mqttUser, user, sizeof(settings.mqttUser) - 1);
-    settings.mqttUser[sizeof(settings.mqttUser) - 1] = '\0';
-    strncpy(settings.mqttPassword, password, sizeof(settings.mqttPassword) - 1);
-    settings.mqttPassword[sizeof(settings.mqttPassword) - 1] = '\0';
+    {
+        Guard guard(*this);
+        strncpy(settings.mqttUser, user, sizeof(settings.mqttUser) - 1);
+        settings.mqttUser[sizeof(settings.mqttUser) - 1] = '\0';
+        strncpy(settings.mqttPassword, password, sizeof(settings.mqttPassword) - 1);
+        settings.mqttPassword[sizeof(settings.mqttPassword) - 1] = '\0';
+    }
     return save();
 }
 
@@ -148,15 +239,18 @@ bool DeviceConfig::setStaticIP(const char* ip, const char* gateway, const char*
         return false;
     }
 
-    strncpy(settings.staticIP, ip, sizeof(settings.staticIP) - 1);
-    settings.staticIP[sizeof(settings.staticIP) - 1] = '\0';
-    strncpy(settings.gateway, gateway, sizeof(settings.gateway) - 1);
-    settings.gateway[sizeof(settings.gateway) - 1] = '\0';
-    strncpy(settings.subnet, subnet, sizeof(settings.subnet) - 1);
-    settings.subnet[sizeof(settings.subnet) - 1] = '\0';
-    strncpy(settings.dnsServer, dns, sizeof(settings.dnsServer) - 1);
-    settings.dnsServer[sizeof(settings.dnsServer) - 1] = '\0';
-    settings.useDHCP = false;
+    {
+        Guard guard(*this);
+        strncpy(settings.staticIP, ip, sizeof(settings.staticIP) - 1);
+        settings.staticIP[sizeof(settings.staticIP) - 1] = '\0';
+        strncpy(settings.gateway, gateway, sizeof(settings.gateway) - 1);
+        settings.gateway[sizeof(settings.gateway) - 1] = '\0';
+        strncpy(settings.subnet, subnet, sizeof(settings.subnet) - 1);
+        settings.subnet[sizeof(settings.subnet) - 1] = '\0';
+        strncpy(settings.dnsServer, dns, sizeof(settings.dnsServer) - 1);
+        settings.dnsServer[sizeof(settings.dnsServer) - 1] = '\0';
+        settings.useDHCP = false;
+    }
     return save();
 }
 
@@ -182,30 +276,39 @@ bool DeviceConfig::setWiFiCredentials(const char* ssid, const char* password) {
     }
 
     // Copy credentials
-    strncpy(settings.wifiSSID, ssid, sizeof(settings.wifiSSID) - 1);
-    settings.wifiSSID[sizeof(settings.wifiSSID) - 1] = '\0';
-    strncpy(settings.wifiPassword, password, sizeof(settings.wifiPassword) - 1);
-    settings.wifiPassword[sizeof(settings.wifiPassword) - 1] = '\0';
-
-    // Clear AP mode flag when credentials are set
-    settings.wifiAPMode = false;
+    {
+        Guard guard(*this);
+        strncpy(settings.wifiSSID, ssid, sizeof(settings.wifiSSID) - 1);
+        settings.wifiSSID[sizeof(settings.wifiSSID) - 1] = '\0';
+        strncpy(settings.wifiPassword, password, sizeof(settings.wifiPassword) - 1);
+        settings.wifiPassword[sizeof(settings.wifiPassword) - 1] = '\0';
+
+        // Clear AP mode flag when credentials are set
+        settings.wifiAPMode = false;
+    }
 
     Serial.println("WiFi credentials saved");
     return save();
 }
 
 bool DeviceConfig::clearWiFiCredentials() {
-    memset(settings.wifiSSID, 0, sizeof(settings.wifiSSID));
-    memset(settings.wifiPassword, 0, sizeof(settings.wifiPassword));
-    settings.wifiAPMode = true;  // Force AP mode when credentials are cleared
+    {
+        Guard guard(*this);
+        memset(settings.wifiSSID, 0, sizeof(settings.wifiSSID));
+        memset(settings.wifiPassword, 0, sizeof(settings.wifiPassword));
+        settings.wifiAPMode = true;  // Force AP mode when credentials are cleared
+    }
 
     Serial.println("WiFi credentials cleared - AP mode will activate on next boot");
     return save();
 }
 
 bool DeviceConfig::enableWiFi(bool enable) {
-    settings.wifiEnabled = enable;
-    settings.connectionMode = enable ? MODE_WIFI : MODE_ETHERNET;
+    {
+        Guard guard(*this);
+        settings.wifiEnabled = enable;
+        settings.connectionMode = enable ? MODE_WIFI : MODE_ETHERNET;
+    }
 
     Serial.printf("WiFi %s - connection mode set to %s\n",
                  enable ? "enabled" : "disabled",
@@ -227,29 +330,98 @@ ConnectionMode DeviceConfig::getConnectionMode() const {
 
 bool DeviceConfig::setMDNSDiscovery(bool enabled, const char* serviceName,
                                      const char* protocol, uint16_t timeoutMs) {
-    settings.mdnsEnabled = enabled;
+    {
+        Guard guard(*this);
+        settings.mdnsEnabled = enabled;
+
+        if (serviceName && strlen(serviceName) > 0) {
+            strncpy(settings.mdnsServiceName, serviceName, sizeof(settings.mdnsServiceName) - 1);
+            settings.mdnsServiceName[sizeof(settings.mdnsServiceName) - 1] = '\0';
+        }
+
+        if (protocol && strlen(protocol) > 0) {
+            strncpy(settings.mdnsProtocol, protocol, sizeof(settings.mdnsProtocol) - 1);
+            settings.mdnsProtocol[sizeof(settings.mdnsProtocol) - 1] = '\0';
+        }
+
+        if (timeoutMs > 0) {
+            settings.mdnsTimeoutMs = timeoutMs;
+        }
+    }
 
-    if (serviceName && strlen(serviceName) > 0) {
-        strncpy(settings.mdnsServiceName, serviceName, sizeof(settings.mdnsServiceName) - 1);
-        settings.mdnsServiceName[sizeof(settings.mdnsServiceName) - 1] = '\0';
+    Serial.printf("mDNS discovery %s\n", enabled ? "enabled" : "disabled");
+    return save();
+}
+
+bool DeviceConfig::setCounterChannels(uint8_t channelMask) {
+    // DIN1 is reserved for the control button
+    settings.counterChannels = channelMask & ~(1 << CONTROL_BUTTON_CHANNEL);
+
+    Serial.printf("Pulse counter channels set to 0x%02X (reboot to apply)\n", settings.counterChannels);
+    return save();
+}
+
+bool DeviceConfig::setMQTTQoS(MQTTMessageClass messageClass, uint8_t qos) {
+    if (messageClass >= MQTT_CLASS_COUNT || qos > 2) {
+        return false;
     }
+    settings.mqttQoS[messageClass] = qos;
+
+    Serial.printf("MQTT QoS for %s set to %d\n", messageClassToString(messageClass), qos);
+    return save();
+}
 
-    if (protocol && strlen(protocol) > 0) {
-        strncpy(settings.mdnsProtocol, protocol, sizeof(settings.mdnsProtocol) - 1);
-        settings.mdnsProtocol[sizeof(settings.mdnsProtocol) - 1] = '\0';
+const char* DeviceConfig::messageClassToString(MQTTMessageClass messageClass) {
+    switch (messageClass) {
+        case MQTT_CLASS_STATUS:     return "status";
+        case MQTT_CLASS_LINE_STATE: return "line_state";
+        case MQTT_CLASS_INPUT:      return "input";
+        case MQTT_CLASS_COUNTERS:   return "counters";
+        case MQTT_CLASS_ANNOUNCE:   return "announce";
+        default:                    return "unknown";
     }
+}
 
-    if (timeoutMs > 0) {
-        settings.mdnsTimeoutMs = timeoutMs;
+bool DeviceConfig::setPayloadFormat(PayloadFormat format) {
+    if (format != PAYLOAD_JSON && format != PAYLOAD_MSGPACK) {
+        return false;
     }
+    settings.payloadFormat = format;
 
-    Serial.printf("mDNS discovery %s\n", enabled ? "enabled" : "disabled");
+    Serial.printf("MQTT payload format set to %s\n", payloadFormatToString(format));
+    return save();
+}
+
+const char* DeviceConfig::payloadFormatToString(PayloadFormat format) {
+    return format == PAYLOAD_MSGPACK ? "msgpack" : "json";
+}
+
+bool DeviceConfig::setNTPServer(const char* server) {
+    if (strlen(server) == 0 || strlen(server) >= sizeof(settings.ntpServer)) {
+        return false;
+    }
+    {
+        Guard guard(*this);
+        strncpy(settings.ntpServer, server, sizeof(settings.ntpServer) - 1);
+        settings.ntpServer[sizeof(settings.ntpServer) - 1] = '\0';
+    }
+
+    Serial.printf("NTP server set to %s (reboot to apply)\n", settings.ntpServer);
     return save();
 }
 
 void DeviceConfig::resetToDefaults() {
+    {
+        Guard guard(*this);
+        loadDefaults();
+    }
+    if (saveLock != nullptr) {
+        xSemaphoreTake(saveLock, portMAX_DELAY);
+    }
     prefs.clear();
-    loadDefaults();
+    if (saveLock != nullptr) {
+        xSemaphoreGive(saveLock);
+    }
     save();
     Serial.println("Configuration reset to factory defaults");
 }
@@ -284,6 +456,21 @@ void DeviceConfig::printSettings() {
     Serial.printf("Timeout:         %u ms\n", settings.mdnsTimeoutMs);
     Serial.printf("Cache Enabled:   %s\n", settings.mdnsCacheEnabled ? "Yes" : "No");
     Serial.printf("Cache Expiry:    %u ms (%u min)\n", settings.mdnsCacheExpiryMs, settings.mdnsCacheExpiryMs / 60000);
+
+    // Pulse counter settings
+    Serial.println("\n--- Pulse Counters ---");
+    Serial.printf("Counter Channels: 0x%02X\n", settings.counterChannels);
+
+    // MQTT delivery policy
+    Serial.println("\n--- MQTT Delivery ---");
+    Serial.printf("Payload Format: %s\n", payloadFormatToString(settings.payloadFormat));
+    for (int i = 0; i < MQTT_CLASS_COUNT; i++) {
+        Serial.printf("%-12s QoS %d\n", messageClassToString((MQTTMessageClass)i), settings.mqttQoS[i]);
+    }
+
+    // Time sync settings
+    Serial.println("\n--- Time Sync ---");
+    Serial.printf("NTP Server:      %s\n", settings.ntpServer);
     Serial.println("============================\n");
 }
 
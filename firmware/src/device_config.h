@@ -2,6 +2,8 @@
 
 #include <Arduino.h>
 #include <Preferences.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 
 // Connection mode for network interface
 enum ConnectionMode {
@@ -9,7 +11,30 @@ enum ConnectionMode {
     MODE_WIFI = 1
 };
 
+// MQTT message classes with their own QoS level
+enum MQTTMessageClass {
+    MQTT_CLASS_STATUS = 0,      // Periodic heartbeat
+    MQTT_CLASS_LINE_STATE,      // Line state change (state-critical)
+    MQTT_CLASS_INPUT,           // Input change events
+    MQTT_CLASS_COUNTERS,        // Periodic pulse counter totals
+    MQTT_CLASS_ANNOUNCE,        // Device announcement (retained)
+    MQTT_CLASS_COUNT
+};
+
+// Encoding of status, input-change and counter payloads
+enum PayloadFormat {
+    PAYLOAD_JSON = 0,
+    PAYLOAD_MSGPACK = 1
+};
+
 // Device Configuration Manager using NVS (Non-Volatile Storage)
+//
+// Settings are read and written from several tasks (loop, web server, mDNS
+// discovery). Setters change them under a recursive mutex and save() writes a
+// snapshot to NVS outside it, so a reader never waits for flash. Readers in
+// other tasks - and loop() readers of strings a web save may change - hold a
+// Guard or take a copySettings() snapshot; single-byte fields can be read
+// directly.
 class DeviceConfig {
 public:
     struct Settings {
@@ -38,6 +63,27 @@ public:
         uint16_t mdnsTimeoutMs;          // Discovery timeout in milliseconds
         bool mdnsCacheEnabled;           // Cache discovered brokers
         uint32_t mdnsCacheExpiryMs;      // Cache expiry period in milliseconds
+
+        // Pulse Counter Configuration
+        uint8_t counterChannels;         // DIN channels in PCNT counter mode (bit 0 = DIN1)
+
+        // MQTT Delivery Configuration
+        uint8_t mqttQoS[MQTT_CLASS_COUNT];  // QoS (0-2) per message class
+        PayloadFormat payloadFormat;     // JSON or MessagePack (announcement is always JSON)
+
+        // Time Synchronization
+        char ntpServer[64];              // SNTP server (local server recommended)
+    };
+
+    // Holds the settings lock for its scope (recursive - setters may be called)
+    class Guard {
+    public:
+        explicit Guard(const DeviceConfig& config) : config(config) { config.lock(); }
+        ~Guard() { config.unlock(); }
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+    private:
+        const DeviceConfig& config;
     };
 
     DeviceConfig();
@@ -45,9 +91,12 @@ public:
     // Initialize and load settings from NVS
     void begin();
 
-    // Get current settings
+    // Get current settings (see class comment for cross-task reads)
     const Settings& getSettings() const { return settings; }
 
+    // Consistent copy of all settings (for other tasks)
+    void copySettings(Settings& out) const;
+
     // Update settings (and save to NVS)
     bool setDeviceID(const char* id);
     bool setMQTTBroker(const char* broker, uint16_t port = 1883);
@@ -68,6 +117,20 @@ public:
     bool setMDNSDiscovery(bool enabled, const char* serviceName = "_mqtt",
                           const char* protocol = "_tcp", uint16_t timeoutMs = 5000);
 
+    // Pulse counter configuration (takes effect on reboot)
+    bool setCounterChannels(uint8_t channelMask);
+
+    // MQTT QoS per message class (takes effect on next publish)
+    bool setMQTTQoS(MQTTMessageClass messageClass, uint8_t qos);
+    static const char* messageClassToString(MQTTMessageClass messageClass);
+
+    // MQTT payload encoding (takes effect on next publish)
+    bool setPayloadFormat(PayloadFormat format);
+    static const char* payloadFormatToString(PayloadFormat format);
+
+    // SNTP server (takes effect on reboot)
+    bool setNTPServer(const char* server);
+
     // Reset to factory defaults
     void resetToDefaults();
 
@@ -83,6 +146,11 @@ public:
 private:
     Preferences prefs;
     Settings settings;
+    SemaphoreHandle_t settingsLock;   // Guards settings (recursive)
+    SemaphoreHandle_t saveLock;       // Serializes NVS writes
+
+    void lock() const;
+    void unlock() const;
 
     void loadSettings();
     void loadDefaults();
@@ -3,17 +3,29 @@
 #include "network/connection_manager.h"
 #include "mqtt/mqtt_client.h"
 
-DisplayManager::DisplayManager()
-    : display(nullptr),
+// SSD1306 transfer framing
+static const uint8_t SSD1306_CONTROL_COMMAND = 0x00;
+static const uint8_t SSD1306_CONTROL_DATA = 0x40;
+static const uint8_t DISPLAY_PAGES = FrameDiff::PAGES;
+static const uint8_t DISPLAY_CHUNK_SIZE = I2CRequest::MAX_DATA - 1;  // Data bytes per request
+static_assert(DISPLAY_PAGES <= 8, "failedPages holds one bit per page");
+
+DisplayManager::DisplayManager(I2CBusManager* bus)
+    : bus(bus),
+      display(nullptr),
       networkManager(nullptr),
       mqttManager(nullptr),
       lastRefresh(0),
       bootTime(0),
       displayInitialized(false),
-      lastIPAddress(""),
-      lastNetworkConnected(false),
-      lastMQTTConnected(false),
-      lastRSSI(0) {
+      framePending(false),
+      sentFrameValid(false),
+      failedPages(0) {
+    portMUX_INITIALIZE(&failedLock);
+    for (uint8_t page = 0; page < DISPLAY_PAGES; page++) {
+        pageTransfers[page].owner = this;
+        pageTransfers[page].page = page;
+    }
 }
 
 DisplayManager::~DisplayManager() {
@@ -28,11 +40,18 @@ bool DisplayManager::begin() {
     Serial.printf("  I2C Address: 0x%02X\n", DISPLAY_I2C_ADDRESS);
     Serial.printf("  Resolution: %dx%d\n", DISPLAY_WIDTH, DISPLAY_HEIGHT);
 
-    // Create display object (using I2C bus already initialized in main.cpp)
-    display = new Adafruit_SSD1306(DISPLAY_WIDTH, DISPLAY_HEIGHT, &Wire, -1);
+    // Create display object (I2C bus already initialized by the bus manager)
+    // Same clock during and after Adafruit transfers - don't drop the shared bus to 100 kHz
+    display = new Adafruit_SSD1306(DISPLAY_WIDTH, DISPLAY_HEIGHT, &Wire, -1,
+                                   I2C_BUS_FREQUENCY, I2C_BUS_FREQUENCY);
+    bus->registerDevice(DISPLAY_I2C_ADDRESS, "ssd1306");
+
+    // Initialize display (blocking init sequence, bus held exclusively)
+    bus->lock();
+    bool initialized = display->begin(SSD1306_SWITCHCAPVCC, DISPLAY_I2C_ADDRESS, true, false);
+    bus->unlock();
 
-    // Initialize display
-    if (!display->begin(SSD1306_SWITCHCAPVCC, DISPLAY_I2C_ADDRESS)) {
+    if (!initialized) {
         Serial.println("✗ ERROR: SSD1306 allocation failed");
         Serial.println("  Check I2C wiring and address");
         delete display;
@@ -40,14 +59,14 @@ bool DisplayManager::begin() {
         return false;
     }
 
-    // Clear display
-    display->clearDisplay();
-    display->display();
-
     // Set boot time for uptime calculation
     bootTime = millis();
 
     displayInitialized = true;
+
+    // Clear display
+    display->clearDisplay();
+    pushFrame();
     Serial.println("✓ Display initialized successfully");
 
     return true;
@@ -59,18 +78,17 @@ void DisplayManager::update() {
         return;
     }
 
-    // Only refresh every DISPLAY_REFRESH_INTERVAL (2000ms)
-    if (millis() - lastRefresh < DISPLAY_REFRESH_INTERVAL) {
-        return;
+    // Retry a frame that did not fit into the bus queue, or resend failed pages
+    if (framePending || failedPages != 0) {
+        pushFrame();
     }
 
-    // Check if state has changed (optimize unnecessary refreshes)
-    if (!stateHasChanged()) {
-        lastRefresh = millis();
+    // Only refresh every DISPLAY_REFRESH_INTERVAL (1000ms)
+    if (millis() - lastRefresh < DISPLAY_REFRESH_INTERVAL) {
         return;
     }
 
-    // Refresh display content
+    // Re-render every time - unchanged pages are not transmitted
     refreshDisplay();
     lastRefresh = millis();
 }
@@ -110,7 +128,7 @@ void DisplayManager::showMessage(const char* message) {
 
     display->setCursor(x, y);
     display->println(message);
-    display->display();
+    pushFrame();
 }
 
 void DisplayManager::refreshDisplay() {
@@ -130,7 +148,9 @@ void DisplayManager::refreshDisplay() {
     if (inAPMode) {
         drawAPMode();
     } else if (networkConnected) {
-        drawIPAddress(networkManager->getIP().toString().c_str());
+        char ip[16];
+        ConnectionManager::formatIP(networkManager->getIP(), ip, sizeof(ip));
+        drawIPAddress(ip);
         drawNetworkStatus();
         drawMQTTStatus();
         drawUptime();
@@ -138,7 +158,87 @@ void DisplayManager::refreshDisplay() {
         drawNoNetwork();
     }
 
-    display->display();  // Push to hardware
+    pushFrame();  // Queue for the hardware
+}
+
+bool DisplayManager::pushFrame() {
+    const uint8_t* buffer = display->getBuffer();
+
+    // Pages whose last write failed - panel RAM no longer matches sentFrame
+    portENTER_CRITICAL(&failedLock);
+    uint8_t resend = failedPages;
+    failedPages = 0;
+    portEXIT_CRITICAL(&failedLock);
+
+    FrameDiff diff(DISPLAY_CHUNK_SIZE);
+    uint32_t requests = diff.compare(buffer, sentFrame, sentFrameValid, resend);
+
+    if (requests == 0) {
+        framePending = false;
+        return true;  // Nothing changed - no I2C traffic
+    }
+
+    if (bus->getFreeSlots(I2CBusManager::PRIORITY_LOW) < requests) {
+        framePending = true;  // Previous frame still in flight
+        portENTER_CRITICAL(&failedLock);
+        failedPages |= resend;
+        portEXIT_CRITICAL(&failedLock);
+        return false;
+    }
+
+    uint8_t packet[I2CRequest::MAX_DATA];
+
+    for (uint8_t page = 0; page < DISPLAY_PAGES; page++) {
+        if (!diff.changed(page)) {
+            continue;
+        }
+        uint8_t first = diff.firstColumn(page);
+        uint8_t last = diff.lastColumn(page);
+
+        // Address the changed columns of one page (horizontal addressing mode)
+        const uint8_t window[] = {
+            SSD1306_CONTROL_COMMAND,
+            0x22, page, page,                 // Page range
+            0x21, first, last                 // Column range
+        };
+        static_assert(sizeof(window) == FrameDiff::WINDOW_BYTES, "FrameDiff byte count");
+        PageTransfer* transfer = &pageTransfers[page];
+        bool queued = bus->submit(DISPLAY_I2C_ADDRESS, window, sizeof(window),
+                                  I2CBusManager::PRIORITY_LOW, onPageWritten, transfer);
+
+        const uint8_t* row = buffer + page * DISPLAY_WIDTH;
+        for (uint16_t column = first; column <= last; column += DISPLAY_CHUNK_SIZE) {
+            uint16_t remaining = last + 1 - column;
+            uint8_t length = remaining < DISPLAY_CHUNK_SIZE ? remaining : DISPLAY_CHUNK_SIZE;
+            packet[0] = SSD1306_CONTROL_DATA;
+            memcpy(packet + 1, row + column, length);
+            queued &= bus->submit(DISPLAY_I2C_ADDRESS, packet, length + 1,
+                                  I2CBusManager::PRIORITY_LOW, onPageWritten, transfer);
+        }
+
+        if (!queued) {
+            markPageFailed(page);
+        }
+
+        memcpy(sentFrame + page * DISPLAY_WIDTH + first, row + first, last - first + 1);
+    }
+
+    sentFrameValid = true;
+    framePending = false;
+    return true;
+}
+
+void DisplayManager::onPageWritten(void* context, bool success) {
+    if (!success) {
+        PageTransfer* transfer = static_cast<PageTransfer*>(context);
+        transfer->owner->markPageFailed(transfer->page);
+    }
+}
+
+void DisplayManager::markPageFailed(uint8_t page) {
+    portENTER_CRITICAL(&failedLock);
+    failedPages |= (1 << page);
+    portEXIT_CRITICAL(&failedLock);
 }
 
 void DisplayManager::drawIPAddress(const char* ip) {
@@ -182,8 +282,9 @@ void DisplayManager::drawUptime() {
     display->setCursor(0, 32);
 
     unsigned long uptimeSeconds = (millis() - bootTime) / 1000;
-    String uptimeStr = formatUptime(uptimeSeconds);
-    display->printf("Up: %s", uptimeStr.c_str());
+    char uptimeStr[16];
+    formatUptime(uptimeSeconds, uptimeStr, sizeof(uptimeStr));
+    display->printf("Up: %s", uptimeStr);
 }
 
 void DisplayManager::drawAPMode() {
@@ -197,7 +298,9 @@ void DisplayManager::drawAPMode() {
     display->println("SSID: ESP32-Setup");
 
     display->setCursor(0, 24);
-    display->printf("IP: %s", networkManager->getIP().toString().c_str());
+    char ip[16];
+    ConnectionManager::formatIP(networkManager->getIP(), ip, sizeof(ip));
+    display->printf("IP: %s", ip);
 
     display->setCursor(0, 36);
     display->println("Visit to configure");
@@ -225,50 +328,19 @@ void DisplayManager::drawNoNetwork() {
     // Show uptime
     display->setCursor(0, 48);
     unsigned long uptimeSeconds = (millis() - bootTime) / 1000;
-    String uptimeStr = formatUptime(uptimeSeconds);
-    display->printf("Up: %s", uptimeStr.c_str());
+    char uptimeStr[16];
+    formatUptime(uptimeSeconds, uptimeStr, sizeof(uptimeStr));
+    display->printf("Up: %s", uptimeStr);
 }
 
-String DisplayManager::formatUptime(unsigned long seconds) {
+void DisplayManager::formatUptime(unsigned long seconds, char* buffer, size_t size) {
     unsigned long hours = seconds / 3600;
     unsigned long minutes = (seconds % 3600) / 60;
     unsigned long secs = seconds % 60;
 
-    char buffer[16];
-    snprintf(buffer, sizeof(buffer), "%02lu:%02lu:%02lu", hours, minutes, secs);
-    return String(buffer);
+    snprintf(buffer, size, "%02lu:%02lu:%02lu", hours, minutes, secs);
 }
 
-String DisplayManager::formatRSSI(int rssi) {
-    char buffer[16];
-    snprintf(buffer, sizeof(buffer), "%ddBm", rssi);
-    return String(buffer);
-}
-
-bool DisplayManager::stateHasChanged() {
-    if (networkManager == nullptr || mqttManager == nullptr) {
-        return true;  // Always refresh if managers not set
-    }
-
-    // Get current state
-    String currentIP = networkManager->getIP().toString();
-    bool currentNetworkConnected = networkManager->isConnected();
-    bool currentMQTTConnected = mqttManager->isConnected();
-    int currentRSSI = networkManager->getRSSI();
-
-    // Check if anything changed
-    bool changed = (currentIP != lastIPAddress) ||
-                   (currentNetworkConnected != lastNetworkConnected) ||
-                   (currentMQTTConnected != lastMQTTConnected) ||
-                   (currentRSSI != lastRSSI);
-
-    // Update cached state
-    if (changed) {
-        lastIPAddress = currentIP;
-        lastNetworkConnected = currentNetworkConnected;
-        lastMQTTConnected = currentMQTTConnected;
-        lastRSSI = currentRSSI;
-    }
-
-    return changed;
+void DisplayManager::formatRSSI(int rssi, char* buffer, size_t size) {
+    snprintf(buffer, size, "%ddBm", rssi);
 }
@@ -3,6 +3,9 @@
 #include <Arduino.h>
 #include <Adafruit_GFX.h>
 #include <Adafruit_SSD1306.h>
+#include "config.h"
+#include "io/i2c_bus.h"
+#include "frame_diff.h"
 
 // Forward declarations
 class ConnectionManager;
@@ -21,11 +24,23 @@ class MQTTClientManager;
  * - Line 4: System uptime
  *
  * Uses non-blocking update pattern consistent with other modules.
- * Display refreshes every DISPLAY_REFRESH_INTERVAL (2000ms by default).
+ * Display refreshes every DISPLAY_REFRESH_INTERVAL (1000ms by default).
+ *
+ * Frames are rendered into the Adafruit framebuffer and handed to the shared
+ * I2C bus manager as low-priority page transfers, so output writes are never
+ * stuck behind a 1 KB frame. Only display init talks to Wire directly.
+ *
+ * Partial refresh: the last transmitted frame is kept, and only the changed
+ * column range of each changed 8-pixel page is sent (FrameDiff). An uptime
+ * tick costs one page window (14 bytes per digit) instead of the 1 KB frame.
+ *
+ * Page transfers report back from the bus task: a failed write marks its page
+ * failed, and the next update resends that whole page, so a NACK does not
+ * leave the panel out of step with sentFrame.
  */
 class DisplayManager {
 public:
-    DisplayManager();
+    DisplayManager(I2CBusManager* bus);
     ~DisplayManager();
 
     /**
@@ -60,6 +75,7 @@ public:
     void showMessage(const char* message);
 
 private:
+    I2CBusManager* bus;
     Adafruit_SSD1306* display;
     ConnectionManager* networkManager;
     MQTTClientManager* mqttManager;
@@ -67,16 +83,32 @@ private:
     unsigned long lastRefresh;
     unsigned long bootTime;
     bool displayInitialized;
+    bool framePending;      // Rendered frame not yet queued (bus queue was full)
 
-    // Display state tracking (for change detection)
-    String lastIPAddress;
-    bool lastNetworkConnected;
-    bool lastMQTTConnected;
-    int lastRSSI;
+    // Frame as last queued to the panel (for dirty-page detection)
+    uint8_t sentFrame[DISPLAY_WIDTH * DISPLAY_HEIGHT / 8];
+    bool sentFrameValid;    // False until the first full frame (panel RAM unknown)
+
+    // Completion context of one page's transfers (passed to the bus task)
+    struct PageTransfer {
+        DisplayManager* owner;
+        uint8_t page;
+    };
+    PageTransfer pageTransfers[DISPLAY_HEIGHT / 8];
+    volatile uint8_t failedPages;   // Bit per page, set by the bus task on a failed write
+    portMUX_TYPE failedLock;
+
+    // I2C completion callback (bus task) - flags the page for a full resend
+    static void onPageWritten(void* context, bool success);
+    void markPageFailed(uint8_t page);
 
     // Refresh display content based on current state
     void refreshDisplay();
 
+    // Queue changed pages of the framebuffer on the I2C bus
+    // (all of them, or nothing if the queue is full)
+    bool pushFrame();
+
     // Helper functions for rendering specific information
     void drawIPAddress(const char* ip);
     void drawNetworkStatus();
@@ -85,8 +117,7 @@ private:
     void drawAPMode();
     void drawNoNetwork();
 
-    // Utility functions
-    String formatUptime(unsigned long seconds);
-    String formatRSSI(int rssi);
-    bool stateHasChanged();
+    // Utility functions (format into a caller buffer - no heap Strings)
+    void formatUptime(unsigned long seconds, char* buffer, size_t size);
+    void formatRSSI(int rssi, char* buffer, size_t size);
 };
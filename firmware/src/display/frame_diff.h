@@ -0,0 +1,87 @@
+#pragma once
+
+#include <Arduino.h>
+#include "config.h"
+
+/**
+ * Frame Diff
+ *
+ * Works out which part of an SSD1306 frame has to be sent: for every 8-pixel
+ * page, the column range that differs from the frame last sent. Each changed
+ * page costs one window command plus its columns split into data chunks.
+ *
+ * Pure computation on two framebuffers (no I2C), so DisplayManager::pushFrame
+ * and the host tests use the same code.
+ */
+class FrameDiff {
+public:
+    static const uint8_t PAGES = DISPLAY_HEIGHT / 8;
+    static const uint8_t WINDOW_BYTES = 7;  // Control byte + page range + column range
+
+    /**
+     * @param chunkSize Data bytes per transfer (one control byte is added to each)
+     */
+    explicit FrameDiff(uint8_t chunkSize) : chunkSize(chunkSize), requests(0), bytes(0) {
+        for (uint8_t page = 0; page < PAGES; page++) {
+            first[page] = 1;
+            last[page] = 0;
+        }
+    }
+
+    /**
+     * Compare a frame against the one last sent
+     * @param current Frame to send (DISPLAY_WIDTH bytes per page)
+     * @param sent Frame last sent to the panel
+     * @param sentValid False if the panel RAM is unknown - every page is sent in full
+     * @param fullPages Bit per page to send in full regardless of sent (e.g. failed writes)
+     * @return Number of bus transfers needed (0 = nothing changed)
+     */
+    uint32_t compare(const uint8_t* current, const uint8_t* sent, bool sentValid, uint8_t fullPages) {
+        requests = 0;
+        bytes = 0;
+
+        for (uint8_t page = 0; page < PAGES; page++) {
+            const uint8_t* now = current + page * DISPLAY_WIDTH;
+            const uint8_t* before = sent + page * DISPLAY_WIDTH;
+            int lo = 0;
+            int hi = DISPLAY_WIDTH - 1;
+
+            if (sentValid && !(fullPages & (1 << page))) {
+                while (lo < DISPLAY_WIDTH && now[lo] == before[lo]) lo++;
+                while (hi >= lo && now[hi] == before[hi]) hi--;
+            }
+
+            if (lo > hi) {
+                first[page] = 1;
+                last[page] = 0;
+                continue;
+            }
+
+            first[page] = (uint8_t)lo;
+            last[page] = (uint8_t)hi;
+            uint32_t columns = hi - lo + 1;
+            uint32_t chunks = (columns + chunkSize - 1) / chunkSize;
+            requests += 1 + chunks;
+            bytes += WINDOW_BYTES + columns + chunks;
+        }
+        return requests;
+    }
+
+    bool changed(uint8_t page) const { return first[page] <= last[page]; }
+    uint8_t firstColumn(uint8_t page) const { return first[page]; }
+    uint8_t lastColumn(uint8_t page) const { return last[page]; }
+
+    /**
+     * Totals of the last compare(): bus transfers, and bytes written to the
+     * panel (control bytes included, I2C address bytes not)
+     */
+    uint32_t getRequests() const { return requests; }
+    uint32_t getBytes() const { return bytes; }
+
+private:
+    uint8_t chunkSize;
+    uint8_t first[PAGES];   // Changed column range per page (first > last = unchanged)
+    uint8_t last[PAGES];
+    uint32_t requests;
+    uint32_t bytes;
+};
@@ -2,7 +2,7 @@
 
 #include <Arduino.h>
 #include "state/line_state.h"
-#include "digital_output.h"
+#include "pattern_engine.h"
 
 /**
  * Button LED Controller
@@ -17,24 +17,18 @@
  * - ERROR state: Fast blinking (200ms on/off)
  * - UNKNOWN state: Off
  *
- * Uses non-blocking pattern system similar to DeviceIdentification.
+ * Patterns are played by the shared PatternEngine (no update() polling).
  */
 class ButtonLED {
 public:
-    ButtonLED(DigitalOutputManager* outputMgr);
+    ButtonLED(PatternEngine* patternEngine);
 
     /**
      * Initialize button LED
-     * Ensures EXIO5 is configured as output
+     * Registers EXIO5 with the pattern engine (LED off)
      */
     void begin();
 
-    /**
-     * Update LED state based on pattern (call in main loop)
-     * Non-blocking pattern generation
-     */
-    void update();
-
     /**
      * Set LED pattern based on production line state
      * @param state Current production line state
@@ -47,14 +41,8 @@ public:
     void setLED(bool on);
 
 private:
-    DigitalOutputManager* outputs;
+    PatternEngine* patterns;
+    int8_t slot;
 
     LineState currentState;
-    bool ledState;                   // Current physical LED state (on/off)
-    unsigned long lastToggle;        // Last pattern toggle time
-    uint16_t currentPeriod;          // Current pattern half-period (ms)
-
-    // Pattern timing constants (LED channel defined in config.h)
-    static const uint16_t PATTERN_MAINTENANCE_PERIOD = 500;  // 500ms blink
-    static const uint16_t PATTERN_ERROR_PERIOD = 200;        // 200ms fast blink
 };
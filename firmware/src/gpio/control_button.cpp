@@ -22,18 +22,14 @@ void ControlButton::handleButtonChange(bool newPressed) {
         pressed = true;
         pressStartTime = millis();
         longPressTriggered = false;
-        Serial.println("Control button pressed");
     }
     else if (!newPressed && pressed) {
         // Button just released
         pressed = false;
         uint32_t pressDuration = millis() - pressStartTime;
 
-        Serial.printf("Control button released after %lu ms\n", pressDuration);
-
         // If released before long press threshold, it's a short press
         if (!longPressTriggered && pressDuration < LONG_PRESS_DURATION) {
-            Serial.println("Short press detected");
             if (shortPressCallback != nullptr) {
                 shortPressCallback();
             }
@@ -49,7 +45,6 @@ void ControlButton::update() {
 
         if (currentDuration >= LONG_PRESS_DURATION) {
             longPressTriggered = true;
-            Serial.println("Long press detected (5 seconds) - Maintenance mode");
 
             if (longPressCallback != nullptr) {
                 longPressCallback();
@@ -1,5 +1,13 @@
 #include "digital_input.h"
-#include "config.h"
+#include <esp_timer.h>
+#include <soc/gpio_reg.h>
+
+// DIN CH1-8 must map to consecutive GPIOs for the single-register read
+#if (DIN_PIN_2 != DIN_PIN_1 + 1) || (DIN_PIN_3 != DIN_PIN_1 + 2) || (DIN_PIN_4 != DIN_PIN_1 + 3) || \
+    (DIN_PIN_5 != DIN_PIN_1 + 4) || (DIN_PIN_6 != DIN_PIN_1 + 5) || (DIN_PIN_7 != DIN_PIN_1 + 6) || \
+    (DIN_PIN_8 != DIN_PIN_1 + 7) || (DIN_PIN_8 > 31)
+#error "DIN_PIN_1..DIN_PIN_8 must be consecutive GPIOs within GPIO_IN_REG (GPIO0-31)"
+#endif
 
 // Grace period to suppress boot-time input-change messages
 // During this period, inputs are read and state is tracked, but callbacks are suppressed
@@ -12,16 +20,23 @@ const uint8_t DigitalInputManager::DIN_PINS[8] = {
     DIN_PIN_5, DIN_PIN_6, DIN_PIN_7, DIN_PIN_8
 };
 
+// Static instance pointer for ISR
+DigitalInputManager* DigitalInputManager::instance = nullptr;
+
 DigitalInputManager::DigitalInputManager()
-    : debounceDelay(DEBOUNCE_DELAY),
-      changeCallback(nullptr),
+    : inputMask(0),
       bootStabilized(false),
-      bootTime(0) {
+      bootTime(0),
+      isrCapture(INPUT_CAPTURE_ISR),
+      excludedMask(0),
+      suppressedChanges(0),
+      lastSampleUs(0),
+      changeCallback(nullptr) {
+
+    instance = this;
 
     for (int i = 0; i < 8; i++) {
-        inputState[i] = false;
-        lastReading[i] = false;
-        lastDebounceTime[i] = 0;
+        lastEdgeUs[i] = 0;
     }
 }
 
@@ -32,12 +47,34 @@ void DigitalInputManager::begin() {
         pinMode(DIN_PINS[i], INPUT_PULLUP);
     }
 
+    // Attach edge ISRs - edges during boot stabilization are discarded in update()
+    if (isrCapture) {
+        for (int i = 0; i < 8; i++) {
+            attachInterruptArg(DIN_PINS[i], onEdgeISR, (void*)(uintptr_t)i, CHANGE);
+        }
+    }
+
     bootTime = millis();
 
-    Serial.println("Digital inputs initialized (GPIO4-11) with INPUT_PULLUP");
+    Serial.printf("Digital inputs initialized (GPIO4-11) with INPUT_PULLUP, %s capture\n",
+                 isrCapture ? "ISR" : "polled");
     Serial.println("WARNING: Waiting for boot stabilization due to ESP32-S3 power-up glitches");
 }
 
+inline uint8_t DigitalInputManager::readAllPins() {
+    return (REG_READ(GPIO_IN_REG) >> DIN_PIN_1) & 0xFF;
+}
+
+void IRAM_ATTR DigitalInputManager::onEdgeISR(void* arg) {
+    uint8_t channel = (uint8_t)(uintptr_t)arg;
+    uint64_t now = esp_timer_get_time();
+
+    // Direct register read - digitalRead() is not guaranteed to be in IRAM
+    uint8_t level = (REG_READ(GPIO_IN_REG) >> DIN_PINS[channel]) & 0x01;
+
+    instance->edgeQueue.push(channel, level, now);
+}
+
 void DigitalInputManager::update() {
     // Wait for boot stabilization period to avoid power-up glitches
     // ESP32-S3 Datasheet: GPIO1-20 have 60µs low-level glitches during power-up
@@ -48,70 +85,109 @@ void DigitalInputManager::update() {
         bootStabilized = true;
         Serial.println("Digital inputs ready - boot stabilization complete");
 
+        // Discard glitch edges captured during stabilization, then seed
+        // the debouncer from the current pin levels
+        InputEdgeEvent discarded;
+        while (edgeQueue.pop(discarded)) {
+        }
+
+        uint64_t seedUs = esp_timer_get_time();
+        inputMask = readAllPins();
+        debouncer.reset(inputMask);
+        lastSampleUs = seedUs;
+        for (int i = 0; i < 8; i++) {
+            lastEdgeUs[i] = seedUs;
+        }
+
         // Debug: Print initial input states
         Serial.print("Initial input states: ");
         for (int i = 0; i < 8; i++) {
-            Serial.printf("CH%d=%d ", i+1, inputState[i] ? 1 : 0);
+            Serial.printf("CH%d=%d ", i+1, (inputMask >> i) & 0x01);
         }
         Serial.println();
+        return;
     }
 
-    // Read and debounce all inputs
-    for (int i = 0; i < 8; i++) {
-        bool reading = digitalRead(DIN_PINS[i]);
+    uint64_t nowUs = esp_timer_get_time();
 
-        // Check if reading changed
-        if (reading != lastReading[i]) {
-            Serial.printf("[DEBUG] CH%d reading changed: %d -> %d\n", i+1, lastReading[i], reading);
-            lastDebounceTime[i] = millis();
+    if (isrCapture) {
+        // Captured edges only timestamp changes - the register samples below
+        // decide them. The last edge per channel starts its stable period.
+        InputEdgeEvent event;
+        while (edgeQueue.pop(event)) {
+            lastEdgeUs[event.channel] = event.timestampUs;
         }
+    }
+
+    if (nowUs - lastSampleUs >= INPUT_SAMPLE_INTERVAL_US) {
+        lastSampleUs = nowUs;
+        sample(nowUs);
+    }
+}
+
+void DigitalInputManager::sample(uint64_t nowUs) {
+    uint8_t changed = debouncer.sample(readAllPins());
+    inputMask = debouncer.getState();
+
+    if (changed == 0) {
+        return;
+    }
+
+    // Vertical counters do not record when each edge happened - estimate it as
+    // the first of the SAMPLES consecutive samples that confirmed the change
+    uint64_t estimateUs = nowUs - (uint64_t)(VerticalDebouncer::SAMPLES - 1) * INPUT_SAMPLE_INTERVAL_US;
 
-        // If stable for debounce delay, update state
-        if ((millis() - lastDebounceTime[i]) > debounceDelay) {
-            // Check if state actually changed
-            if (reading != inputState[i]) {
-                Serial.printf("[DEBUG] CH%d state change confirmed after debounce\n", i+1);
-                inputState[i] = reading;
-                notifyChange(i, reading);
+    // ISR mode: the captured edge is exact if it falls inside the confirming
+    // window (one extra interval of slack for sampling jitter); otherwise the
+    // edge was lost (queue overflow) and the estimate is used
+    uint64_t windowStartUs = nowUs - (uint64_t)(VerticalDebouncer::SAMPLES + 1) * INPUT_SAMPLE_INTERVAL_US;
+
+    for (int i = 0; i < 8; i++) {
+        if (changed & (1 << i)) {
+            uint64_t edgeUs = estimateUs;
+            if (isrCapture && lastEdgeUs[i] >= windowStartUs && lastEdgeUs[i] <= nowUs) {
+                edgeUs = lastEdgeUs[i];
             }
+            notifyChange(i, (inputMask >> i) & 0x01, edgeUs);
         }
-
-        lastReading[i] = reading;
     }
 }
 
 bool DigitalInputManager::getInput(uint8_t channel) {
     if (channel >= 8) return false;
-    return inputState[channel];
+    return (inputMask >> channel) & 0x01;
 }
 
-uint8_t DigitalInputManager::getAllInputs() {
-    uint8_t state = 0;
-    for (int i = 0; i < 8; i++) {
-        if (inputState[i]) {
-            state |= (1 << i);
+void DigitalInputManager::setCallback(InputChangeCallback callback) {
+    changeCallback = callback;
+}
+
+void DigitalInputManager::setExcludedChannels(uint8_t channelMask) {
+    excludedMask = channelMask;
+
+    if (isrCapture) {
+        for (int i = 0; i < 8; i++) {
+            if (excludedMask & (1 << i)) {
+                detachInterrupt(DIN_PINS[i]);
+            }
         }
     }
-    return state;
 }
 
-void DigitalInputManager::setCallback(InputChangeCallback callback) {
-    changeCallback = callback;
-}
+void DigitalInputManager::notifyChange(uint8_t channel, bool state, uint64_t timestampUs) {
+    if (excludedMask & (1 << channel)) {
+        return;
+    }
 
-void DigitalInputManager::notifyChange(uint8_t channel, bool state) {
     // Suppress callbacks during grace period to avoid boot noise
     // Inputs are still tracked, but change events are not published
+    // (runs in the I/O task - counted here, logged from loop())
     if (millis() - bootTime < INPUT_GRACE_PERIOD) {
-        Serial.printf("Input CH%d changed to %s (suppressed - grace period)\n",
-                     channel + 1, state ? "HIGH" : "LOW");
+        suppressedChanges++;
         return;
     }
 
-    Serial.printf("Input CH%d changed to %s\n",
-                 channel + 1, state ? "HIGH" : "LOW");
-
     if (changeCallback != nullptr) {
-        changeCallback(channel, state);
+        changeCallback(channel, state, timestampUs);
     }
 }
@@ -1,41 +1,85 @@
 #pragma once
 
 #include <Arduino.h>
+#include "config.h"
+#include "input_event_queue.h"
+#include "vertical_debouncer.h"
 
 // Callback function type for input change events
-typedef void (*InputChangeCallback)(uint8_t channel, bool state);
+// timestampUs is the esp_timer time (µs since boot) of the edge that started the stable period
+typedef void (*InputChangeCallback)(uint8_t channel, bool state, uint64_t timestampUs);
 
 // Digital Input Manager with debouncing
+//
+// All 8 pins are read in one GPIO_IN register access every
+// INPUT_SAMPLE_INTERVAL_US and debounced together with vertical counters.
+// INPUT_CAPTURE_ISR (config.h) only changes how changes are timestamped:
+// - ISR: every edge is timestamped in a GPIO interrupt and queued; update()
+//   drains the queue, and a debounced change carries the time of the last raw
+//   edge before it (exact to the µs)
+// - Polling: the edge time is estimated from the samples that confirmed it
 class DigitalInputManager {
 public:
     DigitalInputManager();
 
-    // Initialize digital input pins
+    // Initialize digital input pins (and attach edge ISRs in ISR mode)
     void begin();
 
     // Update inputs (call in loop for debouncing)
     void update();
 
+    // Take one polled sample of all channels (constant time)
+    // Called by update() at INPUT_SAMPLE_INTERVAL_US; may be driven from a fixed-rate task instead
+    void sample(uint64_t nowUs);
+
     // Get individual input state (channel 0-7)
     bool getInput(uint8_t channel);
 
     // Get all inputs as bitmask (bit 0 = CH1, bit 7 = CH8)
-    uint8_t getAllInputs();
+    uint8_t getAllInputs() const { return inputMask; }
 
     // Set callback for input change events
     void setCallback(InputChangeCallback callback);
 
+    // Stop change detection on channels owned by another subsystem (e.g. pulse counters)
+    // Their ISRs are detached and no change callbacks are raised for them
+    void setExcludedChannels(uint8_t channelMask);
+
+    // Edge capture statistics (ISR mode)
+    bool isISRCapture() const { return isrCapture; }
+    uint32_t getDroppedEdges() const { return edgeQueue.getDroppedCount(); }
+    uint16_t getQueueHighWater() const { return edgeQueue.getHighWaterMark(); }
+
+    // Changes not reported during the boot grace period (logged by loop())
+    uint32_t getSuppressedChanges() const { return suppressedChanges; }
+
 private:
     static const uint8_t DIN_PINS[8];
 
-    bool inputState[8];
-    bool lastReading[8];
-    unsigned long lastDebounceTime[8];
-    unsigned long debounceDelay;
+    uint8_t inputMask;             // Debounced state of all channels
     bool bootStabilized;
     unsigned long bootTime;
+    bool isrCapture;
+    uint8_t excludedMask;          // Channels that never raise change callbacks
+    volatile uint32_t suppressedChanges;
+
+    // Bit-parallel debouncer (both modes)
+    VerticalDebouncer debouncer;
+    uint64_t lastSampleUs;
+
+    // ISR mode: edge timestamps
+    uint64_t lastEdgeUs[8];        // Time of last raw edge (start of current stable period)
+    InputEventQueue<INPUT_EVENT_QUEUE_SIZE> edgeQueue;
 
     InputChangeCallback changeCallback;
 
-    void notifyChange(uint8_t channel, bool state);
+    // Read all DIN pins in a single register access (bit 0 = CH1)
+    static inline uint8_t readAllPins();
+
+    // Edge ISR (static for attachInterruptArg, arg = channel index)
+    static void IRAM_ATTR onEdgeISR(void* arg);
+    static DigitalInputManager* instance;
+
+
+    void notifyChange(uint8_t channel, bool state, uint64_t timestampUs);
 };
@@ -6,21 +6,36 @@
 #define TCA9554_POLARITY_REG 0x02
 #define TCA9554_CONFIG_REG   0x03
 
-DigitalOutputManager::DigitalOutputManager() : outputState(0xFF) {
+DigitalOutputManager::DigitalOutputManager(I2CBusManager* bus)
+    : bus(bus),
+      outputState(0xFF),
+      committedState(0xFF),
+      writeFailed(false),
+      transactionCount(0),
+      changeCount(0),
+      completedCount(0),
+      edgeTransaction(0),
+      edgeUs(0),
+      appliedCallback(nullptr),
+      stateMutex(nullptr) {
     // Initialize to 0xFF (all outputs OFF due to inverted logic)
 }
 
 bool DigitalOutputManager::begin() {
-    // Initialize I2C on GPIO41 (SCL) and GPIO42 (SDA)
-    // Note: These are JTAG pins (MTDI/MTMS) - hardware JTAG will not be available
-    Wire.begin(I2C_SDA_PIN, I2C_SCL_PIN);
-    delay(10);
+    if (stateMutex == nullptr) {
+        stateMutex = xSemaphoreCreateMutex();
+    }
+
+    // I2C bus (GPIO41/42) is owned by the bus manager - probe/configure synchronously
+    bus->registerDevice(TCA9554_ADDRESS, "tca9554");
+    bus->lock();
 
     // Test I2C communication
     Wire.beginTransmission(TCA9554_ADDRESS);
     uint8_t error = Wire.endTransmission();
 
     if (error != 0) {
+        bus->unlock();
         Serial.printf("TCA9554PWR not found at address 0x%02X (I2C error: %d)\n",
                      TCA9554_ADDRESS, error);
         return false;
@@ -28,6 +43,7 @@ bool DigitalOutputManager::begin() {
 
     // Configure all pins as outputs (0 = output, 1 = input)
     if (!writeRegister(TCA9554_CONFIG_REG, 0x00)) {
+        bus->unlock();
         Serial.println("Failed to configure TCA9554PWR pins as outputs");
         return false;
     }
@@ -35,11 +51,14 @@ bool DigitalOutputManager::begin() {
     // Set all outputs OFF initially (0xFF due to inverted logic)
     // Note: Darlington sinking transistors require HIGH=OFF, LOW=ON
     if (!writeRegister(TCA9554_OUTPUT_REG, 0xFF)) {
+        bus->unlock();
         Serial.println("Failed to set initial output state");
         return false;
     }
+    bus->unlock();
 
     outputState = 0xFF;
+    committedState = 0xFF;
     Serial.println("TCA9554PWR initialized - all outputs OFF");
     return true;
 }
@@ -55,18 +74,23 @@ bool DigitalOutputManager::setOutput(uint8_t channel, bool state) {
     // - state=false (want LED OFF) → write 1 (HIGH) → transistor off → LED OFF
     bool invertedState = !state;
 
+    lock();
     if (invertedState) {
         outputState |= (1 << channel);
     } else {
         outputState &= ~(1 << channel);
     }
-
-    return writeRegister(TCA9554_OUTPUT_REG, outputState);
+    changeCount++;
+    unlock();
+    return true;
 }
 
 bool DigitalOutputManager::setAllOutputs(uint8_t state) {
+    lock();
     outputState = state;
-    return writeRegister(TCA9554_OUTPUT_REG, outputState);
+    changeCount++;
+    unlock();
+    return true;
 }
 
 bool DigitalOutputManager::toggleOutput(uint8_t channel) {
@@ -75,8 +99,56 @@ bool DigitalOutputManager::toggleOutput(uint8_t channel) {
         return false;
     }
 
+    lock();
     outputState ^= (1 << channel);
-    return writeRegister(TCA9554_OUTPUT_REG, outputState);
+    changeCount++;
+    unlock();
+    return true;
+}
+
+bool DigitalOutputManager::commit(uint64_t edgeTimeUs) {
+    lock();
+    bool success = true;
+    if (outputState != committedState || writeFailed) {
+        uint8_t packet[2] = { TCA9554_OUTPUT_REG, outputState };
+        writeFailed = false;
+
+        // Tag the write before it is queued - the bus task may finish it at once
+        if (edgeTimeUs != 0) {
+            edgeUs = edgeTimeUs;
+            edgeTransaction = transactionCount + 1;
+        }
+        success = bus->submit(TCA9554_ADDRESS, packet, sizeof(packet),
+                              I2CBusManager::PRIORITY_HIGH, onWriteComplete, this);
+        if (success) {
+            committedState = outputState;  // If the queue is full, stays dirty - retried next commit
+            transactionCount++;
+        } else if (edgeTimeUs != 0) {
+            edgeTransaction = 0;
+        }
+    }
+    unlock();
+    return success;
+}
+
+bool DigitalOutputManager::isDirty() {
+    return outputState != committedState || writeFailed;
+}
+
+void DigitalOutputManager::onWriteComplete(void* context, bool success) {
+    DigitalOutputManager* self = static_cast<DigitalOutputManager*>(context);
+    if (!success) {
+        self->writeFailed = true;
+    }
+
+    // High-priority writes complete in submit order
+    self->completedCount++;
+    if (self->edgeTransaction != 0 && self->completedCount == self->edgeTransaction) {
+        self->edgeTransaction = 0;
+        if (self->appliedCallback != nullptr) {
+            self->appliedCallback(self->edgeUs, success);
+        }
+    }
 }
 
 uint8_t DigitalOutputManager::getAllOutputs() {
@@ -88,6 +160,18 @@ bool DigitalOutputManager::getOutput(uint8_t channel) {
     return (outputState & (1 << channel)) != 0;
 }
 
+void DigitalOutputManager::lock() {
+    if (stateMutex != nullptr) {
+        xSemaphoreTake(stateMutex, portMAX_DELAY);
+    }
+}
+
+void DigitalOutputManager::unlock() {
+    if (stateMutex != nullptr) {
+        xSemaphoreGive(stateMutex);
+    }
+}
+
 bool DigitalOutputManager::writeRegister(uint8_t reg, uint8_t data) {
     Wire.beginTransmission(TCA9554_ADDRESS);
     Wire.write(reg);
@@ -2,34 +2,83 @@
 
 #include <Arduino.h>
 #include <Wire.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "io/i2c_bus.h"
 
 // TCA9554PWR I2C GPIO Expander for Digital Outputs
+// Thread-safe: the I/O task (tower lights, button LED) and the main loop
+// (status LED) both write outputs, so updates are serialized by a mutex
+//
+// Batched: setOutput/setAllOutputs/toggleOutput only change the shadow
+// register. commit() writes it to the expander in a single I2C transaction,
+// and only if it differs from what was last written. The I/O task commits
+// once per tick; latency-critical paths may commit() explicitly.
+//
+// commit() does not wait for the bus: the write is queued at high priority
+// on the shared I2C bus manager. A failed write is retried on the next commit.
+//
+// A commit() can carry the time of the input edge that caused it; when that
+// write has reached the expander, the applied callback gets the edge time
+// (bus task), so edge-to-output latency includes queue wait and transfer.
 class DigitalOutputManager {
 public:
-    DigitalOutputManager();
+    // Runs in the I2C bus task (keep it short, must not block)
+    typedef void (*AppliedCallback)(uint64_t edgeUs, bool success);
+
+    DigitalOutputManager(I2CBusManager* bus);
 
     // Initialize the TCA9554PWR GPIO expander
     bool begin();
 
-    // Control individual output (channel 0-7)
+    // Control individual output (channel 0-7) - applied on next commit()
     bool setOutput(uint8_t channel, bool state);
 
-    // Control all outputs at once (bitmask 0x00-0xFF)
+    // Control all outputs at once (bitmask 0x00-0xFF) - applied on next commit()
     bool setAllOutputs(uint8_t state);
 
-    // Toggle individual output
+    // Toggle individual output - applied on next commit()
     bool toggleOutput(uint8_t channel);
 
+    // Queue pending changes for the expander (no I2C traffic if nothing changed)
+    // @param edgeUs esp_timer time of the input edge behind the change (0 = none)
+    bool commit(uint64_t edgeUs = 0);
+
+    // Called when a write queued with an edge time completes
+    void setAppliedCallback(AppliedCallback callback) { appliedCallback = callback; }
+
+    // Check for changes not yet written
+    bool isDirty();
+
     // Get current state of all outputs
     uint8_t getAllOutputs();
 
     // Get individual output state
     bool getOutput(uint8_t channel);
 
+    // Statistics: output register writes vs. requested bit changes
+    uint32_t getTransactionCount() const { return transactionCount; }
+    uint32_t getChangeCount() const { return changeCount; }
+
 private:
-    uint8_t outputState;  // Current state of all outputs
+    I2CBusManager* bus;
+    uint8_t outputState;  // Current state of all outputs (shadow register)
+    uint8_t committedState;  // Last value queued for the expander
+    volatile bool writeFailed;  // Set by the bus task - forces a rewrite
+    volatile uint32_t transactionCount;
+    volatile uint32_t changeCount;
+    volatile uint32_t completedCount;  // Writes finished (bus task, in submit order)
+    volatile uint32_t edgeTransaction;  // Write that carries edgeUs (0 = none)
+    volatile uint64_t edgeUs;
+    AppliedCallback appliedCallback;
+    SemaphoreHandle_t stateMutex;  // Guards outputState read-modify-write + commit
+
+    void lock();
+    void unlock();
+
+    static void onWriteComplete(void* context, bool success);
 
-    // I2C register operations
+    // Blocking I2C register operations (caller holds the bus lock)
     bool writeRegister(uint8_t reg, uint8_t data);
     uint8_t readRegister(uint8_t reg);
 };
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+
+/**
+ * Input Edge Event
+ *
+ * One captured edge on a digital input channel.
+ * Timestamp is esp_timer time (microseconds since boot) taken in the ISR.
+ */
+struct InputEdgeEvent {
+    uint8_t channel;        // Input channel (0-7)
+    uint8_t level;          // Pin level after the edge (0 or 1)
+    uint64_t timestampUs;   // esp_timer_get_time() at the edge
+};
+
+/**
+ * Input Event Queue
+ *
+ * Lock-free single-producer / single-consumer ring buffer for edge events.
+ * Producer: GPIO ISR (all DIN ISRs share one interrupt level, so they never
+ * preempt each other). Consumer: DigitalInputManager::update().
+ *
+ * Capacity must be a power of two. One slot is never used, so the queue
+ * holds at most (CAPACITY - 1) events before push() starts dropping.
+ */
+template <uint16_t CAPACITY>
+class InputEventQueue {
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY must be a power of two");
+
+public:
+    InputEventQueue() : head(0), tail(0), dropped(0), highWater(0) {}
+
+    /**
+     * Push an event (ISR context)
+     * @return false if the queue was full and the event was dropped
+     */
+    bool IRAM_ATTR push(uint8_t channel, uint8_t level, uint64_t timestampUs) {
+        uint16_t h = head.load(std::memory_order_relaxed);
+        uint16_t next = (h + 1) & MASK;
+
+        if (next == tail.load(std::memory_order_acquire)) {
+            dropped++;
+            return false;
+        }
+
+        events[h].channel = channel;
+        events[h].level = level;
+        events[h].timestampUs = timestampUs;
+        head.store(next, std::memory_order_release);
+
+        uint16_t depth = (next - tail.load(std::memory_order_relaxed)) & MASK;
+        if (depth > highWater) {
+            highWater = depth;
+        }
+        return true;
+    }
+
+    /**
+     * Pop the oldest event (task context)
+     * @return false if the queue is empty
+     */
+    bool pop(InputEdgeEvent& out) {
+        uint16_t t = tail.load(std::memory_order_relaxed);
+
+        if (t == head.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        out = events[t];
+        tail.store((t + 1) & MASK, std::memory_order_release);
+        return true;
+    }
+
+    bool isEmpty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+    uint16_t size() const {
+        return (head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire)) & MASK;
+    }
+
+    // Total events dropped because the queue was full
+    uint32_t getDroppedCount() const { return dropped; }
+
+    // Deepest fill level seen since boot
+    uint16_t getHighWaterMark() const { return highWater; }
+
+    static constexpr uint16_t capacity() { return CAPACITY - 1; }
+
+private:
+    static const uint16_t MASK = CAPACITY - 1;
+
+    InputEdgeEvent events[CAPACITY];
+    std::atomic<uint16_t> head;   // Next slot to write (producer)
+    std::atomic<uint16_t> tail;   // Next slot to read (consumer)
+    volatile uint32_t dropped;
+    volatile uint16_t highWater;
+};
@@ -0,0 +1,217 @@
+#include "pattern_engine.h"
+
+PatternEngine::PatternEngine(DigitalOutputManager* outputMgr)
+    : outputs(outputMgr),
+      timer(nullptr),
+      lastTickUs(0),
+      mutex(nullptr),
+      slotCount(0) {
+}
+
+bool PatternEngine::begin() {
+    if (mutex == nullptr) {
+        mutex = xSemaphoreCreateMutex();
+    }
+
+    esp_timer_create_args_t args = {};
+    args.callback = onTimer;
+    args.arg = this;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "patterns";
+    args.skip_unhandled_events = true;  // Don't burst-catch-up after a stall
+
+    lastTickUs = esp_timer_get_time();
+    if (esp_timer_create(&args, &timer) != ESP_OK ||
+        esp_timer_start_periodic(timer, PATTERN_TICK_MS * 1000ULL) != ESP_OK) {
+        Serial.println("✗ Pattern engine: failed to start timer");
+        return false;
+    }
+
+    Serial.printf("Pattern engine started (%d ms tick, %u indicators)\n", PATTERN_TICK_MS, slotCount);
+    return true;
+}
+
+int8_t PatternEngine::addOutputChannel(uint8_t channel) {
+    return addSlot(SINK_OUTPUT, channel, 255);
+}
+
+int8_t PatternEngine::addPWMPin(uint8_t pin, uint8_t maxDuty) {
+    return addSlot(SINK_PWM, pin, maxDuty);
+}
+
+int8_t PatternEngine::addSlot(SinkType type, uint8_t target, uint8_t maxDuty) {
+    if (mutex == nullptr) {
+        mutex = xSemaphoreCreateMutex();  // Slots may be registered before begin()
+    }
+
+    lock();
+    if (slotCount >= PATTERN_MAX_SLOTS) {
+        unlock();
+        Serial.println("✗ Pattern engine: no free slot");
+        return -1;
+    }
+
+    int8_t id = slotCount++;
+    Slot& slot = slots[id];
+    slot.type = type;
+    slot.target = target;
+    slot.maxDuty = maxDuty;
+    slot.base = &Patterns::OFF;
+    slot.overlay = nullptr;
+    slot.overlayRemainingMs = 0;
+    slot.appliedLevel = -1;
+    restart(slot);
+    apply(slot);
+    unlock();
+    return id;
+}
+
+void PatternEngine::setPattern(int8_t slot, const Pattern& pattern) {
+    if (slot < 0 || slot >= slotCount) {
+        return;
+    }
+
+    lock();
+    Slot& s = slots[slot];
+    if (s.base != &pattern) {
+        s.base = &pattern;
+        if (s.overlay == nullptr) {
+            restart(s);
+            apply(s);
+        }
+    }
+    unlock();
+}
+
+void PatternEngine::playFor(int8_t slot, const Pattern& pattern, uint32_t durationMs) {
+    if (slot < 0 || slot >= slotCount) {
+        return;
+    }
+
+    lock();
+    Slot& s = slots[slot];
+    s.overlay = &pattern;
+    s.overlayRemainingMs = durationMs;
+    restart(s);
+    apply(s);
+    unlock();
+}
+
+void PatternEngine::stopOverlay(int8_t slot) {
+    if (slot < 0 || slot >= slotCount) {
+        return;
+    }
+
+    lock();
+    Slot& s = slots[slot];
+    if (s.overlay != nullptr) {
+        s.overlay = nullptr;
+        restart(s);
+        apply(s);
+    }
+    unlock();
+}
+
+bool PatternEngine::isOverlayActive(int8_t slot) {
+    if (slot < 0 || slot >= slotCount) {
+        return false;
+    }
+
+    lock();
+    bool active = slots[slot].overlay != nullptr;
+    unlock();
+    return active;
+}
+
+void PatternEngine::restart(Slot& slot) {
+    slot.step = 0;
+    slot.stepElapsedMs = 0;
+}
+
+const Pattern& PatternEngine::active(const Slot& slot) const {
+    return slot.overlay != nullptr ? *slot.overlay : *slot.base;
+}
+
+void PatternEngine::apply(Slot& slot) {
+    uint8_t level = active(slot).steps[slot.step].level;
+    if (level == slot.appliedLevel) {
+        return;
+    }
+    slot.appliedLevel = level;
+
+    if (slot.type == SINK_OUTPUT) {
+        if (outputs != nullptr) {
+            outputs->setOutput(slot.target, level > 0);  // Shadow only - committed per tick
+        }
+    } else {
+        ledcWrite(slot.target, (uint32_t)level * slot.maxDuty / 255);
+    }
+}
+
+void PatternEngine::onTimer(void* arg) {
+    static_cast<PatternEngine*>(arg)->tick();
+}
+
+void PatternEngine::tick() {
+    // Advance by the real elapsed time: skipped or late timer events (stalls,
+    // skip_unhandled_events) must not slow patterns down. The sub-ms
+    // remainder stays in lastTickUs for the next tick.
+    uint64_t now = esp_timer_get_time();
+    uint32_t elapsedMs = (uint32_t)((now - lastTickUs) / 1000);
+    lastTickUs += (uint64_t)elapsedMs * 1000;
+
+    lock();
+    for (uint8_t i = 0; i < slotCount && elapsedMs > 0; i++) {
+        Slot& slot = slots[i];
+
+        // Overlay expired - back to the base pattern
+        if (slot.overlay != nullptr) {
+            if (slot.overlayRemainingMs <= elapsedMs) {
+                slot.overlay = nullptr;
+                restart(slot);
+                apply(slot);
+                continue;
+            }
+            slot.overlayRemainingMs -= elapsedMs;
+        }
+
+        const Pattern& pattern = active(slot);
+        if (pattern.steps[slot.step].durationMs == 0) {
+            continue;  // Static level
+        }
+
+        // Skip over every step that ended in the elapsed time, keep the rest
+        uint8_t startStep = slot.step;
+        slot.stepElapsedMs += elapsedMs;
+        uint16_t duration;
+        while ((duration = pattern.steps[slot.step].durationMs) != 0 &&
+               slot.stepElapsedMs >= duration) {
+            slot.stepElapsedMs -= duration;
+            slot.step = (slot.step + 1) % pattern.count;
+        }
+        if (duration == 0) {
+            slot.stepElapsedMs = 0;  // Reached a static step
+        }
+        if (slot.step != startStep) {
+            apply(slot);
+        }
+    }
+    unlock();
+
+    // Everything changed in this tick goes out as one expander write
+    if (outputs != nullptr) {
+        outputs->commit();
+    }
+}
+
+void PatternEngine::lock() {
+    if (mutex != nullptr) {
+        xSemaphoreTake(mutex, portMAX_DELAY);
+    }
+}
+
+void PatternEngine::unlock() {
+    if (mutex != nullptr) {
+        xSemaphoreGive(mutex);
+    }
+}
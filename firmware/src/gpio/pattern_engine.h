@@ -0,0 +1,142 @@
+#pragma once
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "config.h"
+#include "digital_output.h"
+
+/**
+ * Pattern step: hold a level for a duration
+ * level: 0 = off, 255 = full (expander channels are on for any level > 0)
+ * durationMs: 0 = hold forever (last step of a static pattern)
+ */
+struct PatternStep {
+    uint16_t durationMs;
+    uint8_t level;
+};
+
+/**
+ * Pattern: step sequence, repeated from the first step
+ */
+struct Pattern {
+    const PatternStep* steps;
+    uint8_t count;
+};
+
+template <size_t N>
+constexpr Pattern makePattern(const PatternStep (&steps)[N]) {
+    return Pattern{steps, (uint8_t)N};
+}
+
+/**
+ * Pattern tables shared by all indicators
+ */
+namespace Patterns {
+    inline constexpr PatternStep OFF_STEPS[] = {{0, 0}};
+    inline constexpr PatternStep SOLID_STEPS[] = {{0, 255}};
+    inline constexpr PatternStep BLINK_MAINTENANCE_STEPS[] = {{BUTTON_LED_MAINTENANCE_PERIOD, 255}, {BUTTON_LED_MAINTENANCE_PERIOD, 0}};
+    inline constexpr PatternStep BLINK_ERROR_STEPS[] = {{BUTTON_LED_ERROR_PERIOD, 255}, {BUTTON_LED_ERROR_PERIOD, 0}};
+    inline constexpr PatternStep DOUBLE_BLINK_STEPS[] = {{150, 255}, {150, 0}, {150, 255}, {650, 0}};
+    inline constexpr PatternStep SINGLE_BLINK_STEPS[] = {{500, 255}, {1000, 0}};
+    inline constexpr PatternStep SLOW_BLINK_STEPS[] = {{1000, 255}, {1000, 0}};
+    inline constexpr PatternStep IDENTIFY_STEPS[] = {{200, 255}, {200, 0}};
+    inline constexpr PatternStep DIM_BLINK_STEPS[] = {{500, 128}, {500, 0}};
+
+    inline constexpr Pattern OFF = makePattern(OFF_STEPS);
+    inline constexpr Pattern SOLID = makePattern(SOLID_STEPS);
+    inline constexpr Pattern BLINK_MAINTENANCE = makePattern(BLINK_MAINTENANCE_STEPS);  // Button LED: maintenance
+    inline constexpr Pattern BLINK_ERROR = makePattern(BLINK_ERROR_STEPS);              // Button LED: error
+    inline constexpr Pattern DOUBLE_BLINK = makePattern(DOUBLE_BLINK_STEPS);            // Status LED: no MQTT
+    inline constexpr Pattern SINGLE_BLINK = makePattern(SINGLE_BLINK_STEPS);            // Status LED: no network
+    inline constexpr Pattern SLOW_BLINK = makePattern(SLOW_BLINK_STEPS);                // Status LED: AP mode
+    inline constexpr Pattern IDENTIFY = makePattern(IDENTIFY_STEPS);                    // RGB + buzzer: flash identify
+    inline constexpr Pattern DIM_BLINK = makePattern(DIM_BLINK_STEPS);                  // RGB: AP mode
+}
+
+/**
+ * Indicator Pattern Engine
+ *
+ * Plays step patterns on any number of indicators (expander output
+ * channels, or PWM pins such as the RGB LED and buzzer) from one periodic
+ * esp_timer, so timing does not depend on loop() load.
+ *
+ * - Each indicator is a slot with a base pattern (setPattern) and an
+ *   optional timed overlay (playFor) that falls back to the base when it ends
+ * - Each tick advances by the real time since the last one, so late or
+ *   skipped timer events do not stretch patterns
+ * - All expander bits changed in a tick are committed as one register write
+ * - PWM pins are only written when their level changes
+ */
+class PatternEngine {
+public:
+    PatternEngine(DigitalOutputManager* outputMgr);
+
+    /**
+     * Start the tick timer (slots may be added before or after)
+     */
+    bool begin();
+
+    /**
+     * Register an indicator
+     * @return slot id, or -1 if all PATTERN_MAX_SLOTS are used
+     */
+    int8_t addOutputChannel(uint8_t channel);
+    int8_t addPWMPin(uint8_t pin, uint8_t maxDuty);
+
+    /**
+     * Set the base pattern of a slot (restarts from step 0 if it changes)
+     * Step 0 is applied immediately (expander bits on the next commit)
+     */
+    void setPattern(int8_t slot, const Pattern& pattern);
+
+    /**
+     * Play a pattern for durationMs, then return to the base pattern
+     */
+    void playFor(int8_t slot, const Pattern& pattern, uint32_t durationMs);
+
+    /**
+     * End an overlay early
+     */
+    void stopOverlay(int8_t slot);
+
+    bool isOverlayActive(int8_t slot);
+
+private:
+    enum SinkType : uint8_t {
+        SINK_OUTPUT,    // Expander channel (on/off)
+        SINK_PWM        // LEDC pin (duty = level * maxDuty / 255)
+    };
+
+    struct Slot {
+        SinkType type;
+        uint8_t target;             // Channel or pin
+        uint8_t maxDuty;
+        const Pattern* base;
+        const Pattern* overlay;     // nullptr = playing base
+        uint32_t overlayRemainingMs;
+        uint8_t step;
+        uint32_t stepElapsedMs;
+        int16_t appliedLevel;       // -1 = never written
+    };
+
+    DigitalOutputManager* outputs;
+    esp_timer_handle_t timer;
+    uint64_t lastTickUs;            // Time already accounted for (whole ms consumed)
+    SemaphoreHandle_t mutex;        // Guards slots (tick vs. setPattern/playFor)
+
+    Slot slots[PATTERN_MAX_SLOTS];
+    uint8_t slotCount;
+
+    int8_t addSlot(SinkType type, uint8_t target, uint8_t maxDuty);
+    void restart(Slot& slot);
+    void apply(Slot& slot);
+    const Pattern& active(const Slot& slot) const;
+
+    void lock();
+    void unlock();
+
+    static void onTimer(void* arg);
+    void tick();
+};
@@ -0,0 +1,256 @@
+#include "pulse_counter.h"
+#include <Preferences.h>
+
+// NVS namespace for counter checkpoints
+static const char* NVS_NAMESPACE = "counters";
+
+// Digital input pins (DIN CH1-8), same mapping as DigitalInputManager
+static const uint8_t COUNTER_PINS[8] = {
+    DIN_PIN_1, DIN_PIN_2, DIN_PIN_3, DIN_PIN_4,
+    DIN_PIN_5, DIN_PIN_6, DIN_PIN_7, DIN_PIN_8
+};
+
+PulseCounterManager::PulseCounterManager()
+    : counterCount(0),
+      activeMask(0),
+      windowStart(0),
+      lastCheckpointTime(0) {
+    memset(counters, 0, sizeof(counters));
+}
+
+uint8_t PulseCounterManager::begin(uint8_t channelMask) {
+    // DIN1 is the control button
+    channelMask &= ~(1 << CONTROL_BUTTON_CHANNEL);
+
+    if (channelMask == 0) {
+        Serial.println("Pulse counters: none configured");
+        return 0;
+    }
+
+    Preferences prefs;
+    bool nvsOpen = prefs.begin(NVS_NAMESPACE, true);  // Read-only mode
+
+    for (uint8_t ch = 0; ch < 8; ch++) {
+        if (!(channelMask & (1 << ch))) {
+            continue;
+        }
+
+        if (counterCount >= MAX_COUNTERS) {
+            Serial.printf("✗ Pulse counter DIN%d skipped - only %d PCNT units available\n",
+                         ch + 1, MAX_COUNTERS);
+            continue;
+        }
+
+        Counter& c = counters[counterCount];
+        c.channel = ch;
+
+        // Unit counts 0..COUNTER_PCNT_LIMIT, then wraps to 0 and fires the watch point
+        pcnt_unit_config_t unitConfig = {};
+        unitConfig.low_limit = -1;
+        unitConfig.high_limit = COUNTER_PCNT_LIMIT;
+
+        if (pcnt_new_unit(&unitConfig, &c.unit) != ESP_OK) {
+            Serial.printf("✗ Pulse counter DIN%d: failed to allocate PCNT unit\n", ch + 1);
+            continue;
+        }
+
+        // Reject contact bounce / EMI spikes shorter than the filter width
+        pcnt_glitch_filter_config_t filterConfig = {};
+        filterConfig.max_glitch_ns = COUNTER_GLITCH_FILTER_NS;
+        pcnt_unit_set_glitch_filter(c.unit, &filterConfig);
+
+        pcnt_chan_config_t chanConfig = {};
+        chanConfig.edge_gpio_num = COUNTER_PINS[ch];
+        chanConfig.level_gpio_num = -1;
+
+        if (pcnt_new_channel(c.unit, &chanConfig, &c.pcntChannel) != ESP_OK) {
+            Serial.printf("✗ Pulse counter DIN%d: failed to create PCNT channel\n", ch + 1);
+            pcnt_del_unit(c.unit);
+            continue;
+        }
+
+        // INPUT_PULLUP: sensor active pulls the input LOW - count falling edges
+        pcnt_channel_set_edge_action(c.pcntChannel,
+                                     PCNT_CHANNEL_EDGE_ACTION_HOLD,       // rising
+                                     PCNT_CHANNEL_EDGE_ACTION_INCREASE);  // falling
+
+        pcnt_unit_add_watch_point(c.unit, COUNTER_PCNT_LIMIT);
+
+        pcnt_event_callbacks_t callbacks = {};
+        callbacks.on_reach = onReach;
+        pcnt_unit_register_event_callbacks(c.unit, &callbacks, &c);
+
+        pcnt_unit_enable(c.unit);
+        pcnt_unit_clear_count(c.unit);
+        pcnt_unit_start(c.unit);
+
+        // Restore total from last checkpoint
+        char key[8];
+        snprintf(key, sizeof(key), "total%d", ch);
+        c.wraps = 0;
+        c.base = nvsOpen ? prefs.getULong64(key, 0) : 0;
+        c.windowStartTotal = c.base;
+        c.lastCheckpoint = c.base;
+        c.lastRead = c.base;
+        c.ratePPM = 0.0f;
+
+        activeMask |= (1 << ch);
+        counterCount++;
+
+        Serial.printf("✓ Pulse counter on DIN%d (GPIO%d), restored total: %llu\n",
+                     ch + 1, COUNTER_PINS[ch], c.base);
+    }
+
+    if (nvsOpen) {
+        prefs.end();
+    }
+
+    windowStart = millis();
+    lastCheckpointTime = millis();
+
+    return counterCount;
+}
+
+bool IRAM_ATTR PulseCounterManager::onReach(pcnt_unit_handle_t unit,
+                                            const pcnt_watch_event_data_t* edata,
+                                            void* userCtx) {
+    Counter* c = static_cast<Counter*>(userCtx);
+    if (edata->watch_point_value == COUNTER_PCNT_LIMIT) {
+        c->wraps++;
+    }
+    return false;  // No task woken
+}
+
+void PulseCounterManager::update() {
+    if (counterCount == 0) {
+        return;
+    }
+
+    unsigned long now = millis();
+
+    // Close the rate window
+    unsigned long elapsed = now - windowStart;
+    if (elapsed >= COUNTER_RATE_WINDOW) {
+        for (uint8_t i = 0; i < counterCount; i++) {
+            uint64_t total = readTotal(counters[i]);
+            counters[i].ratePPM = (float)(total - counters[i].windowStartTotal) * 60000.0f / elapsed;
+            counters[i].windowStartTotal = total;
+        }
+        windowStart = now;
+    }
+
+    // Periodic NVS checkpoint
+    if (now - lastCheckpointTime >= COUNTER_CHECKPOINT_INTERVAL) {
+        lastCheckpointTime = now;
+        checkpoint();
+    }
+}
+
+bool PulseCounterManager::isCounterChannel(uint8_t channel) const {
+    if (channel >= 8) return false;
+    return (activeMask & (1 << channel)) != 0;
+}
+
+uint64_t PulseCounterManager::getTotal(uint8_t channel) {
+    Counter* c = findCounter(channel);
+    return c ? readTotal(*c) : 0;
+}
+
+float PulseCounterManager::getRatePPM(uint8_t channel) const {
+    const Counter* c = findCounter(channel);
+    return c ? c->ratePPM : 0.0f;
+}
+
+bool PulseCounterManager::resetCounter(uint8_t channel) {
+    Counter* c = findCounter(channel);
+    if (c == nullptr) {
+        return false;
+    }
+
+    pcnt_unit_clear_count(c->unit);
+    c->wraps = 0;
+    c->base = 0;
+    c->windowStartTotal = 0;
+    c->lastCheckpoint = 0;
+    c->lastRead = 0;
+    c->ratePPM = 0.0f;
+
+    Preferences prefs;
+    if (prefs.begin(NVS_NAMESPACE, false)) {  // Read-write mode
+        char key[8];
+        snprintf(key, sizeof(key), "total%d", channel);
+        prefs.putULong64(key, 0);
+        prefs.end();
+    }
+
+    Serial.printf("Pulse counter DIN%d reset\n", channel + 1);
+    return true;
+}
+
+void PulseCounterManager::checkpoint() {
+    Preferences prefs;
+    bool nvsOpen = false;
+
+    for (uint8_t i = 0; i < counterCount; i++) {
+        Counter& c = counters[i];
+        uint64_t total = readTotal(c);
+
+        if (total == c.lastCheckpoint) {
+            continue;  // Avoid needless flash writes
+        }
+
+        if (!nvsOpen) {
+            nvsOpen = prefs.begin(NVS_NAMESPACE, false);  // Read-write mode
+            if (!nvsOpen) {
+                Serial.println("Failed to save pulse counters to NVS");
+                return;
+            }
+        }
+
+        char key[8];
+        snprintf(key, sizeof(key), "total%d", c.channel);
+        prefs.putULong64(key, total);
+        c.lastCheckpoint = total;
+    }
+
+    if (nvsOpen) {
+        prefs.end();
+    }
+}
+
+PulseCounterManager::Counter* PulseCounterManager::findCounter(uint8_t channel) {
+    for (uint8_t i = 0; i < counterCount; i++) {
+        if (counters[i].channel == channel) {
+            return &counters[i];
+        }
+    }
+    return nullptr;
+}
+
+const PulseCounterManager::Counter* PulseCounterManager::findCounter(uint8_t channel) const {
+    for (uint8_t i = 0; i < counterCount; i++) {
+        if (counters[i].channel == channel) {
+            return &counters[i];
+        }
+    }
+    return nullptr;
+}
+
+uint64_t PulseCounterManager::readTotal(Counter& c) {
+    // Re-read if the overflow ISR fired between reading wraps and the hardware count
+    uint32_t wraps;
+    int count;
+    do {
+        wraps = c.wraps;
+        pcnt_unit_get_count(c.unit, &count);
+    } while (wraps != c.wraps);
+
+    uint64_t total = c.base + (uint64_t)wraps * COUNTER_PCNT_LIMIT + (uint64_t)count;
+
+    // Counts only go up: a drop means the hardware wrapped but the ISR has not run yet
+    if (total < c.lastRead) {
+        total += COUNTER_PCNT_LIMIT;
+    }
+    c.lastRead = total;
+    return total;
+}
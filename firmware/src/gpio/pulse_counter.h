@@ -0,0 +1,96 @@
+#pragma once
+
+#include <Arduino.h>
+#include <driver/pulse_cnt.h>
+#include "config.h"
+
+/**
+ * Pulse Counter Manager
+ *
+ * Counts part-present / cycle-complete pulses on DIN channels in hardware
+ * using the ESP32-S3 PCNT peripheral, instead of publishing one MQTT
+ * input-change message per edge.
+ *
+ * - One PCNT unit per counter channel (ESP32-S3 has 4 units)
+ * - 16-bit hardware counts are extended to 64-bit totals via watch-point overflow
+ * - Parts-per-minute rate computed over COUNTER_RATE_WINDOW
+ * - Totals checkpointed to NVS every COUNTER_CHECKPOINT_INTERVAL (survive reboots;
+ *   at most one interval of counts is lost on power failure)
+ *
+ * DIN1 is reserved for the control button and cannot be a counter channel.
+ */
+class PulseCounterManager {
+public:
+    static const uint8_t MAX_COUNTERS = 4;  // PCNT units on ESP32-S3
+
+    PulseCounterManager();
+
+    /**
+     * Initialize counters on the channels set in channelMask
+     * @param channelMask Bitmask of DIN channels in counter mode (bit 0 = DIN1)
+     * @return Number of counters started
+     */
+    uint8_t begin(uint8_t channelMask);
+
+    /**
+     * Update rate windows and NVS checkpoints (call in main loop)
+     */
+    void update();
+
+    /**
+     * Get mask of channels actually running in counter mode
+     */
+    uint8_t getChannelMask() const { return activeMask; }
+
+    /**
+     * Check if a channel is in counter mode
+     */
+    bool isCounterChannel(uint8_t channel) const;
+
+    /**
+     * Get 64-bit total count for a channel (includes counts restored from NVS)
+     */
+    uint64_t getTotal(uint8_t channel);
+
+    /**
+     * Get parts-per-minute rate over the last completed window
+     */
+    float getRatePPM(uint8_t channel) const;
+
+    /**
+     * Reset a channel's total to zero (also clears the NVS checkpoint)
+     */
+    bool resetCounter(uint8_t channel);
+
+    /**
+     * Write totals to NVS now (skipped for channels unchanged since last checkpoint)
+     */
+    void checkpoint();
+
+private:
+    struct Counter {
+        uint8_t channel;                 // DIN channel (0-7)
+        pcnt_unit_handle_t unit;
+        pcnt_channel_handle_t pcntChannel;
+        volatile uint32_t wraps;         // Hardware counter overflows (updated in ISR)
+        uint64_t base;                   // Total restored from NVS at boot
+        uint64_t windowStartTotal;       // Total at start of current rate window
+        uint64_t lastCheckpoint;         // Total at last NVS write
+        uint64_t lastRead;               // Last value returned by readTotal()
+        float ratePPM;                   // Rate over last completed window
+    };
+
+    Counter counters[MAX_COUNTERS];
+    uint8_t counterCount;
+    uint8_t activeMask;
+
+    unsigned long windowStart;
+    unsigned long lastCheckpointTime;
+
+    Counter* findCounter(uint8_t channel);
+    const Counter* findCounter(uint8_t channel) const;
+    uint64_t readTotal(Counter& counter);
+
+    // PCNT watch-point callback (ISR context)
+    static bool IRAM_ATTR onReach(pcnt_unit_handle_t unit, const pcnt_watch_event_data_t* edata, void* userCtx);
+};
@@ -18,10 +18,6 @@ void TowerLightManager::setStatePattern(LineState state) {
         return;  // No change needed
     }
 
-    Serial.printf("Tower Light pattern changed: %s -> %s\n",
-                 LineStateManager::stateToString(currentState),
-                 LineStateManager::stateToString(state));
-
     currentState = state;
 
     // Turn off all lights first
@@ -32,31 +28,26 @@ void TowerLightManager::setStatePattern(LineState state) {
         case LINE_STATE_ON:
             // Green light only
             outputs->setOutput(TOWER_LIGHT_GREEN_CHANNEL, true);
-            Serial.println("Tower Light: GREEN (Production Running)");
             break;
 
         case LINE_STATE_OFF:
             // Red light only
             outputs->setOutput(TOWER_LIGHT_RED_CHANNEL, true);
-            Serial.println("Tower Light: RED (Production Stopped)");
             break;
 
         case LINE_STATE_MAINTENANCE:
             // Yellow light only
             outputs->setOutput(TOWER_LIGHT_YELLOW_CHANNEL, true);
-            Serial.println("Tower Light: YELLOW (Maintenance Mode)");
             break;
 
         case LINE_STATE_ERROR:
             // Red light only
             outputs->setOutput(TOWER_LIGHT_RED_CHANNEL, true);
-            Serial.println("Tower Light: RED (Error State)");
             break;
 
         case LINE_STATE_UNKNOWN:
         default:
             // All lights off
-            Serial.println("Tower Light: OFF (Unknown/Boot State)");
             break;
     }
 }
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * Vertical Counter Debouncer
+ *
+ * Debounces 8 channels in parallel using bitwise vertical counters.
+ * Bit n of each counter plane (cnt0..cnt2) forms a 3-bit counter for
+ * channel n, so every sample costs the same handful of AND/XOR operations
+ * regardless of how many channels are bouncing.
+ *
+ * A channel's debounced state flips after SAMPLES consecutive samples that
+ * disagree with it; any agreeing sample resets that channel's counter.
+ * Debounce time = SAMPLES * sample interval.
+ */
+class VerticalDebouncer {
+public:
+    static const uint8_t SAMPLES = 8;  // 3-bit counter wraps after 8 samples
+
+    VerticalDebouncer() : state(0), cnt0(0), cnt1(0), cnt2(0) {}
+
+    /**
+     * Seed debounced state (e.g. from the first raw read after boot)
+     */
+    void reset(uint8_t initialState) {
+        state = initialState;
+        cnt0 = cnt1 = cnt2 = 0;
+    }
+
+    /**
+     * Feed one raw sample of all channels
+     * @param raw Raw input bitmask (bit 0 = CH1)
+     * @return Bitmask of channels whose debounced state changed on this sample
+     */
+    inline uint8_t sample(uint8_t raw) {
+        uint8_t delta = raw ^ state;
+
+        // Increment counters where raw differs from state, clear them elsewhere
+        cnt2 = (cnt2 ^ (cnt1 & cnt0)) & delta;
+        cnt1 = (cnt1 ^ cnt0) & delta;
+        cnt0 = ~cnt0 & delta;
+
+        // Counter wrapped to zero while still differing -> commit
+        uint8_t toggle = delta & ~(cnt0 | cnt1 | cnt2);
+        state ^= toggle;
+        return toggle;
+    }
+
+    /**
+     * Get debounced state of all channels
+     */
+    uint8_t getState() const { return state; }
+
+private:
+    uint8_t state;  // Debounced state
+    uint8_t cnt0;   // Counter bit 0 plane
+    uint8_t cnt1;   // Counter bit 1 plane
+    uint8_t cnt2;   // Counter bit 2 plane
+};
@@ -0,0 +1,161 @@
+#include "i2c_bus.h"
+#include <esp_timer.h>
+
+I2CBusManager::I2CBusManager()
+    : taskHandle(nullptr),
+      busMutex(nullptr),
+      deviceCount(0) {
+    queues[PRIORITY_HIGH] = nullptr;
+    queues[PRIORITY_LOW] = nullptr;
+    memset(devices, 0, sizeof(devices));
+}
+
+bool I2CBusManager::begin(int sdaPin, int sclPin) {
+    // Note: GPIO41/42 are JTAG pins (MTDI/MTMS) - hardware JTAG will not be available
+    Wire.begin(sdaPin, sclPin, I2C_BUS_FREQUENCY);
+
+    busMutex = xSemaphoreCreateMutex();
+    queues[PRIORITY_HIGH] = xQueueCreate(I2C_BUS_HIGH_QUEUE_LENGTH, sizeof(I2CRequest));
+    queues[PRIORITY_LOW] = xQueueCreate(I2C_BUS_LOW_QUEUE_LENGTH, sizeof(I2CRequest));
+
+    if (busMutex == nullptr || queues[PRIORITY_HIGH] == nullptr || queues[PRIORITY_LOW] == nullptr) {
+        Serial.println("✗ I2C bus: failed to create queues");
+        return false;
+    }
+
+    BaseType_t result = xTaskCreatePinnedToCore(
+        taskEntry,
+        "i2c_bus",
+        I2C_BUS_TASK_STACK_SIZE,
+        this,
+        I2C_BUS_TASK_PRIORITY,
+        &taskHandle,
+        I2C_BUS_TASK_CORE
+    );
+
+    if (result != pdPASS) {
+        Serial.println("✗ I2C bus: failed to create task");
+        return false;
+    }
+
+    Serial.printf("I2C bus task started on core %d (%lu kHz, priority %d)\n",
+                 I2C_BUS_TASK_CORE, (unsigned long)(I2C_BUS_FREQUENCY / 1000), I2C_BUS_TASK_PRIORITY);
+    return true;
+}
+
+void I2CBusManager::registerDevice(uint8_t address, const char* name) {
+    if (findDevice(address) != nullptr || deviceCount >= I2C_BUS_MAX_DEVICES) {
+        return;
+    }
+
+    devices[deviceCount].address = address;
+    devices[deviceCount].name = name;
+    deviceCount++;
+}
+
+bool I2CBusManager::submit(uint8_t address, const uint8_t* data, uint8_t length, Priority priority,
+                           I2CRequest::CompletionCallback callback, void* context) {
+    QueueHandle_t queue = queues[priority];
+    if (queue == nullptr || length > I2CRequest::MAX_DATA) {
+        return false;
+    }
+
+    I2CRequest request;
+    request.address = address;
+    request.length = length;
+    memcpy(request.data, data, length);
+    request.submittedUs = esp_timer_get_time();
+    request.callback = callback;
+    request.context = context;
+
+    if (xQueueSend(queue, &request, 0) != pdTRUE) {
+        I2CDeviceStats* stats = findDevice(address);
+        if (stats != nullptr) {
+            stats->dropped++;
+        }
+        return false;
+    }
+
+    xTaskNotifyGive(taskHandle);
+    return true;
+}
+
+uint32_t I2CBusManager::getFreeSlots(Priority priority) const {
+    QueueHandle_t queue = queues[priority];
+    return queue != nullptr ? uxQueueSpacesAvailable(queue) : 0;
+}
+
+void I2CBusManager::lock() {
+    if (busMutex != nullptr) {
+        xSemaphoreTake(busMutex, portMAX_DELAY);
+    }
+}
+
+void I2CBusManager::unlock() {
+    if (busMutex != nullptr) {
+        xSemaphoreGive(busMutex);
+    }
+}
+
+I2CDeviceStats* I2CBusManager::findDevice(uint8_t address) {
+    for (uint8_t i = 0; i < deviceCount; i++) {
+        if (devices[i].address == address) {
+            return &devices[i];
+        }
+    }
+    return nullptr;
+}
+
+void I2CBusManager::taskEntry(void* param) {
+    static_cast<I2CBusManager*>(param)->run();
+}
+
+void I2CBusManager::run() {
+    I2CRequest request;
+
+    while (true) {
+        // HIGH is re-checked before every LOW request, so output writes
+        // preempt a display frame between chunks
+        if (xQueueReceive(queues[PRIORITY_HIGH], &request, 0) == pdTRUE ||
+            xQueueReceive(queues[PRIORITY_LOW], &request, 0) == pdTRUE) {
+            execute(request);
+            continue;
+        }
+
+        // Idle until the next submit()
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+}
+
+void I2CBusManager::execute(I2CRequest& request) {
+    lock();
+    Wire.beginTransmission(request.address);
+    Wire.write(request.data, request.length);
+    uint8_t error = Wire.endTransmission();
+    unlock();
+
+    bool success = (error == 0);
+    uint32_t latencyUs = (uint32_t)(esp_timer_get_time() - request.submittedUs);
+
+    I2CDeviceStats* stats = findDevice(request.address);
+    if (stats != nullptr) {
+        stats->transfers++;
+        stats->lastLatencyUs = latencyUs;
+        stats->totalLatencyUs += latencyUs;
+        if (latencyUs > stats->maxLatencyUs) {
+            stats->maxLatencyUs = latencyUs;
+        }
+        if (!success) {
+            stats->errors++;
+        }
+    }
+
+    if (!success) {
+        Serial.printf("I2C write error: %d (addr=0x%02X, len=%u)\n",
+                     error, request.address, request.length);
+    }
+
+    if (request.callback != nullptr) {
+        request.callback(request.context, success);
+    }
+}
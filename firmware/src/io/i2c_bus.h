@@ -0,0 +1,118 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include "config.h"
+
+/**
+ * I2C Write Request
+ *
+ * One bus transaction (START, address, data..., STOP). Data is copied into
+ * the request, so the caller's buffer can be reused as soon as submit()
+ * returns.
+ */
+struct I2CRequest {
+    // Completion hook, runs in the bus task (keep it short, must not block)
+    typedef void (*CompletionCallback)(void* context, bool success);
+
+    static const uint8_t MAX_DATA = 33;   // Control byte + 32 data bytes (one SSD1306 chunk)
+
+    uint8_t address;
+    uint8_t length;
+    uint8_t data[MAX_DATA];
+    uint64_t submittedUs;                 // esp_timer time of submit()
+    CompletionCallback callback;
+    void* context;
+};
+
+/**
+ * Per-device bus statistics
+ */
+struct I2CDeviceStats {
+    uint8_t address;
+    const char* name;
+    uint32_t transfers;
+    uint32_t errors;
+    uint32_t dropped;                     // Rejected by submit() (queue full)
+    uint32_t lastLatencyUs;               // submit() -> transfer complete
+    uint32_t maxLatencyUs;
+    uint64_t totalLatencyUs;
+};
+
+/**
+ * Shared I2C Bus Manager
+ *
+ * Owns Wire (GPIO41/42) and serializes all transfers for the TCA9554PWR
+ * output expander and the SSD1306 display in one FreeRTOS task.
+ *
+ * - Callers submit() writes and return immediately
+ * - Two priority levels: HIGH (output registers) is always drained before
+ *   the next LOW request (display), so an output change waits at most for
+ *   one display chunk (~0.8 ms at 400 kHz) instead of a full 1 KB frame
+ * - Latency (queue wait + transfer) is tracked per registered device
+ *
+ * Blocking transactions (device probing, display init) take the bus with
+ * lock()/unlock() and use Wire directly.
+ */
+class I2CBusManager {
+public:
+    enum Priority : uint8_t {
+        PRIORITY_HIGH = 0,    // Output expander writes
+        PRIORITY_LOW = 1      // Display page transfers
+    };
+
+    I2CBusManager();
+
+    /**
+     * Initialize Wire at I2C_BUS_FREQUENCY and start the bus task
+     * @return true if the task is running
+     */
+    bool begin(int sdaPin, int sclPin);
+
+    /**
+     * Register a device for latency statistics
+     */
+    void registerDevice(uint8_t address, const char* name);
+
+    /**
+     * Queue a write (non-blocking)
+     * @return false if the queue for this priority is full or length > MAX_DATA
+     */
+    bool submit(uint8_t address, const uint8_t* data, uint8_t length, Priority priority,
+                I2CRequest::CompletionCallback callback = nullptr, void* context = nullptr);
+
+    /**
+     * Free request slots at a priority level (to submit multi-request
+     * sequences such as a display frame all-or-nothing)
+     */
+    uint32_t getFreeSlots(Priority priority) const;
+
+    /**
+     * Exclusive bus access for blocking transactions (waits for the current transfer)
+     */
+    void lock();
+    void unlock();
+
+    // Statistics
+    uint8_t getDeviceCount() const { return deviceCount; }
+    const I2CDeviceStats& getDeviceStats(uint8_t index) const { return devices[index]; }
+    uint32_t getFrequency() const { return I2C_BUS_FREQUENCY; }
+
+private:
+    TaskHandle_t taskHandle;
+    QueueHandle_t queues[2];          // Indexed by Priority
+    SemaphoreHandle_t busMutex;
+
+    I2CDeviceStats devices[I2C_BUS_MAX_DEVICES];
+    uint8_t deviceCount;
+
+    I2CDeviceStats* findDevice(uint8_t address);
+    void execute(I2CRequest& request);
+
+    static void taskEntry(void* param);
+    void run();
+};
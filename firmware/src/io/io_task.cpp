@@ -0,0 +1,123 @@
+#include "io_task.h"
+#include <esp_timer.h>
+
+IOTask::IOTask()
+    : taskHandle(nullptr),
+      eventQueue(nullptr),
+      commandQueue(nullptr),
+      tickCallback(nullptr),
+      pendingEdgeUs(0),
+      maxCycleUs(0),
+      overruns(0),
+      lastLatencyUs(0),
+      maxLatencyUs(0),
+      latencySamples(0),
+      droppedEvents(0),
+      droppedCommands(0) {
+}
+
+bool IOTask::begin(TickCallback tick) {
+    tickCallback = tick;
+
+    eventQueue = xQueueCreate(IO_EVENT_QUEUE_LENGTH, sizeof(IOEvent));
+    commandQueue = xQueueCreate(IO_COMMAND_QUEUE_LENGTH, sizeof(IOCommand));
+
+    if (eventQueue == nullptr || commandQueue == nullptr) {
+        Serial.println("✗ I/O task: failed to create queues");
+        return false;
+    }
+
+    BaseType_t result = xTaskCreatePinnedToCore(
+        taskEntry,
+        "io_task",
+        IO_TASK_STACK_SIZE,
+        this,
+        IO_TASK_PRIORITY,
+        &taskHandle,
+        IO_TASK_CORE
+    );
+
+    if (result != pdPASS) {
+        Serial.println("✗ I/O task: failed to create task");
+        return false;
+    }
+
+    Serial.printf("I/O task started on core %d (period %d ms, priority %d)\n",
+                 IO_TASK_CORE, IO_TASK_PERIOD_MS, IO_TASK_PRIORITY);
+    return true;
+}
+
+bool IOTask::isIOTaskContext() const {
+    return taskHandle != nullptr && xTaskGetCurrentTaskHandle() == taskHandle;
+}
+
+void IOTask::taskEntry(void* param) {
+    static_cast<IOTask*>(param)->run();
+}
+
+void IOTask::run() {
+    const TickType_t period = pdMS_TO_TICKS(IO_TASK_PERIOD_MS);
+    TickType_t lastWake = xTaskGetTickCount();
+
+    while (true) {
+        int64_t start = esp_timer_get_time();
+
+        if (tickCallback != nullptr) {
+            tickCallback();
+        }
+
+        // Latency is only attributed within the tick that handled the edge
+        pendingEdgeUs = 0;
+
+        uint32_t cycleUs = (uint32_t)(esp_timer_get_time() - start);
+        if (cycleUs > maxCycleUs) {
+            maxCycleUs = cycleUs;
+        }
+        if (cycleUs > getPeriodUs()) {
+            overruns++;
+        }
+
+        vTaskDelayUntil(&lastWake, period);
+    }
+}
+
+bool IOTask::postEvent(const IOEvent& event) {
+    if (eventQueue == nullptr || xQueueSend(eventQueue, &event, 0) != pdTRUE) {
+        droppedEvents++;
+        return false;
+    }
+    return true;
+}
+
+bool IOTask::receiveEvent(IOEvent& event) {
+    return eventQueue != nullptr && xQueueReceive(eventQueue, &event, 0) == pdTRUE;
+}
+
+bool IOTask::postCommand(const IOCommand& command) {
+    if (commandQueue == nullptr || xQueueSend(commandQueue, &command, 0) != pdTRUE) {
+        droppedCommands++;
+        return false;
+    }
+    return true;
+}
+
+bool IOTask::receiveCommand(IOCommand& command) {
+    return commandQueue != nullptr && xQueueReceive(commandQueue, &command, 0) == pdTRUE;
+}
+
+uint64_t IOTask::takeInputEdge() {
+    uint64_t edgeUs = pendingEdgeUs;
+    pendingEdgeUs = 0;
+    return edgeUs;
+}
+
+void IOTask::recordOutputApplied(uint64_t edgeUs) {
+    // Bus task - the only writer of the latency figures
+    uint32_t latencyUs = (uint32_t)(esp_timer_get_time() - edgeUs);
+
+    lastLatencyUs = latencyUs;
+    if (latencyUs > maxLatencyUs) {
+        maxLatencyUs = latencyUs;
+    }
+    latencySamples++;  // loop() logs new samples
+}
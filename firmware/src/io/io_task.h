@@ -0,0 +1,131 @@
+#pragma once
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include "config.h"
+#include "state/line_state.h"
+
+/**
+ * Event produced by the I/O task for the network side
+ */
+struct IOEvent {
+    enum Type : uint8_t {
+        INPUT_CHANGE,        // Debounced DIN change (channel, state, timestampUs)
+        LINE_STATE_CHANGE,   // Line state transition applied (oldState -> newState)
+        COMMAND_APPLIED      // IOCommand with a requestTag processed (newState = resulting state)
+    };
+
+    Type type;
+    uint8_t channel;
+    bool state;
+    LineState oldState;
+    LineState newState;
+    uint64_t timestampUs;    // esp_timer time of the originating edge/transition
+    uint16_t requestTag;     // COMMAND_APPLIED: tag of the originating command
+    const char* source;      // LINE_STATE_CHANGE: what requested it (string literal, for logging)
+};
+
+/**
+ * Command sent from the network side to the I/O task
+ */
+struct IOCommand {
+    enum Type : uint8_t {
+        SET_LINE_STATE       // Apply newState (e.g. MQTT set_line_state)
+    };
+
+    Type type;
+    LineState newState;
+    uint16_t requestTag;     // Non-zero: report back with a COMMAND_APPLIED event
+};
+
+/**
+ * Fixed-Rate I/O Task
+ *
+ * Runs input sampling, control button / line state transitions and tower
+ * light output in a FreeRTOS task pinned to IO_TASK_CORE (the Arduino loop
+ * runs on the other core), so network, web server and display work cannot
+ * stall them.
+ *
+ * The task only talks to the network side through two bounded queues:
+ * - events (I/O -> loop): input changes and line state changes to publish
+ * - commands (loop -> I/O): line state changes requested over MQTT
+ *
+ * Also measures cycle time and input-edge-to-tower-light latency (edge
+ * timestamp to completed expander write, including the I2C queue wait).
+ *
+ * Nothing in the tick writes to Serial or NVS: the task keeps counters and
+ * loop() logs and persists from them, so a full UART buffer or a flash
+ * erase cannot stretch a cycle.
+ */
+class IOTask {
+public:
+    // Work done every period (runs in the I/O task)
+    typedef void (*TickCallback)();
+
+    IOTask();
+
+    /**
+     * Create and start the task
+     * @param tick Function called once per period
+     * @return true if the task was created
+     */
+    bool begin(TickCallback tick);
+
+    /**
+     * Check if running in the I/O task
+     */
+    bool isIOTaskContext() const;
+
+    // I/O side: queue an event for the network side (non-blocking, dropped if full)
+    bool postEvent(const IOEvent& event);
+
+    // Network side: take the next pending event (non-blocking)
+    bool receiveEvent(IOEvent& event);
+
+    // Network side: queue a command for the I/O task (non-blocking, dropped if full)
+    bool postCommand(const IOCommand& command);
+
+    // I/O side: take the next pending command (non-blocking)
+    bool receiveCommand(IOCommand& command);
+
+    /**
+     * Latency tracking
+     * markInputEdge() records the edge time of the input being handled and
+     * takeInputEdge() hands it to the output commit it caused (I/O task);
+     * recordOutputApplied() closes the measurement when that expander write
+     * has completed on the bus (bus task) - edge to light actually switched
+     */
+    void markInputEdge(uint64_t edgeUs) { pendingEdgeUs = edgeUs; }
+    uint64_t takeInputEdge();
+    void recordOutputApplied(uint64_t edgeUs);
+
+    // Statistics
+    uint32_t getPeriodUs() const { return IO_TASK_PERIOD_MS * 1000UL; }
+    uint32_t getMaxCycleUs() const { return maxCycleUs; }
+    uint32_t getOverruns() const { return overruns; }
+    uint32_t getLastLatencyUs() const { return lastLatencyUs; }
+    uint32_t getMaxLatencyUs() const { return maxLatencyUs; }
+    uint32_t getLatencySamples() const { return latencySamples; }
+    uint32_t getDroppedEvents() const { return droppedEvents; }
+    uint32_t getDroppedCommands() const { return droppedCommands; }
+
+private:
+    TaskHandle_t taskHandle;
+    QueueHandle_t eventQueue;
+    QueueHandle_t commandQueue;
+    TickCallback tickCallback;
+
+    uint64_t pendingEdgeUs;
+    volatile uint32_t maxCycleUs;
+    volatile uint32_t overruns;
+    volatile uint32_t lastLatencyUs;
+    volatile uint32_t maxLatencyUs;
+    volatile uint32_t latencySamples;
+    volatile uint32_t droppedEvents;
+    volatile uint32_t droppedCommands;
+
+    static void taskEntry(void* param);
+    void run();
+};
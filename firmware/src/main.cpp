@@ -1,113 +1,104 @@
 #include <Arduino.h>
+#include <esp_timer.h>
 #include "config.h"
 #include "device_config.h"
 #include "network/connection_manager.h"
 #include "gpio/boot_button.h"
 #include "gpio/digital_input.h"
 #include "gpio/digital_output.h"
+#include "gpio/pulse_counter.h"
 #include "gpio/control_button.h"
 #include "gpio/button_led.h"
 #include "gpio/tower_light.h"
 #include "gpio/status_led.h"
+#include "gpio/pattern_engine.h"
 #include "display/display_manager.h"
 #include "mqtt/mqtt_client.h"
+#include "mqtt/publish_scheduler.h"
 #include "identification.h"
 #include "state/line_state.h"
+#include "io/io_task.h"
+#include "io/i2c_bus.h"
+#include "network/time_service.h"
+#include "boot_profile.h"
+#include "malloc_audit.h"
 
 // Global managers
 ConnectionManager networkManager;
 BootButton bootButton;
 DigitalInputManager inputs;
-DigitalOutputManager outputs;
+I2CBusManager i2cBus;
+DigitalOutputManager outputs(&i2cBus);
+PulseCounterManager pulseCounter;
 MQTTClientManager mqtt;
-DeviceIdentification deviceID;
+PatternEngine patterns(&outputs);
+DeviceIdentification deviceID(&patterns);
 LineStateManager lineState;
 ControlButton controlButton;
-ButtonLED buttonLED(&outputs);
+ButtonLED buttonLED(&patterns);
 TowerLightManager towerLight(&outputs);
-StatusLEDController statusLED(&outputs);
-DisplayManager displayManager;
+StatusLEDController statusLED(&patterns);
+DisplayManager displayManager(&i2cBus);
+IOTask ioTask;
+TimeService timeService;
+BootProfile bootProfile;
 
 // Device identification (MAC address)
 char deviceMAC[18];  // Format: "XX:XX:XX:XX:XX:XX"
 
-// State tracking
-unsigned long lastHeartbeat = 0;
-unsigned long lastAnnouncement = 0;
+// Periodic publishes (heartbeat, announcement, counters) - MAC-derived phase per device
+PublishScheduler publishSchedule;
 
-void onInputChange(uint8_t channel, bool state);
+// Longest loop() iteration (excluding the trailing delay) - read and reset by /status
+volatile uint32_t loopMaxUs = 0;
+
+void onInputChange(uint8_t channel, bool state, uint64_t timestampUs);
 void onNetworkConnection(bool connected);
-void onFlashIdentify();
+void onMQTTConnection(bool connected);
+void onFlashIdentify(uint16_t durationSeconds);
 void onBootButtonLongPress(uint32_t duration);
-void onLineStateChange(LineState oldState, LineState newState);
+void onLineStateChange(LineState oldState, LineState newState, const char* source);
+void onOutputApplied(uint64_t edgeUs, bool success);
 void onControlButtonShortPress();
 void onControlButtonLongPress();
+void ioTick();
+void logIOActivity();
 String getMACAddress();
 
 void setup() {
+    // ===================================================================
+    // FAST PATH (steps 1-7): restore line state to the tower lights and
+    // bring the control button online before anything touches the network.
+    // Network and MQTT come up afterwards in the background.
+    // ===================================================================
+
     // ===================================================================
     // STEP 1: Initialize Serial Communication (USB CDC)
     // ===================================================================
     Serial.begin(115200);
-    delay(1000);  // Wait for USB enumeration
+    if (BOOT_SERIAL_WAIT > 0) {
+        delay(BOOT_SERIAL_WAIT);  // Only to catch early logs on a fresh USB enumeration
+    }
 
     Serial.println("\n\n==============================================");
     Serial.println("  Waveshare ESP32-S3-POE-ETH-8DI-8DO");
     Serial.printf("  Firmware Version: %s\n", FIRMWARE_VERSION);
     Serial.printf("  Device Type: %s\n", DEVICE_TYPE);
     Serial.println("==============================================\n");
+    bootProfile.mark("serial");
 
     // ===================================================================
-    // STEP 2: Wait for Boot Stabilization
-    // CRITICAL: ESP32-S3 power-up glitches on GPIO1-20 (60µs low-level)
-    // ===================================================================
-    Serial.println("Waiting for boot stabilization...");
-    delay(BOOT_STABILIZATION_DELAY);
-    Serial.println("Boot stabilization complete\n");
-
-    // ===================================================================
-    // STEP 3: Get MAC Address for Device Identification
+    // STEP 2: Get MAC Address for Device Identification
     // ===================================================================
     String macStr = getMACAddress();
     macStr.toCharArray(deviceMAC, sizeof(deviceMAC));
     Serial.printf("Device ID (MAC): %s\n\n", deviceMAC);
 
     // ===================================================================
-    // STEP 4: Initialize Boot Button Handler
-    // ===================================================================
-    Serial.println("Initializing boot button handler...");
-    bootButton.begin();
-    bootButton.setLongPressCallback(onBootButtonLongPress);
-
-    // Check for long press during boot (15s hold to enter AP mode)
-    Serial.println("Checking for AP mode trigger (hold BOOT for 15s)...");
-    unsigned long bootCheckStart = millis();
-    while (millis() - bootCheckStart < 15100) {  // Check for 15.1 seconds
-        bootButton.update();
-        if (bootButton.longPressDetected()) {
-            Serial.println("\n!!! BOOT BUTTON HELD 15 SECONDS !!!");
-            Serial.println("Entering AP Mode - Clearing WiFi credentials");
-
-            // Clear WiFi credentials and force AP mode
-            deviceConfig.clearWiFiCredentials();
-            deviceConfig.save();
-
-            // Visual feedback
-            Serial.println("Configuration cleared. Device will enter AP mode on boot.\n");
-
-            bootButton.resetLongPress();
-            break;
-        }
-        delay(10);
-    }
-    Serial.println("Boot button check complete\n");
-
-    // ===================================================================
-    // STEP 5: Load Device Configuration from NVS
+    // STEP 3: Load Device Configuration from NVS
     // ===================================================================
     Serial.println("Loading device configuration from NVS...");
     deviceConfig.begin();
-    deviceConfig.printSettings();
 
     // Auto-switch to WiFi mode if AP mode flag is set
     // (AP mode is a WiFi feature and incompatible with Ethernet mode)
@@ -118,178 +109,145 @@ void setup() {
         deviceConfig.save();
         Serial.println("✓ Connection mode changed to WiFi\n");
     }
+    bootProfile.mark("config");
 
     // ===================================================================
-    // STEP 6: Initialize I2C for TCA9554PWR
+    // STEP 4: Initialize I2C + Digital Outputs (TCA9554PWR)
     // Note: GPIO41/42 are JTAG pins - hardware JTAG will be disabled
     // ===================================================================
-    Serial.println("Initializing I2C...");
-    Serial.printf("  I2C SDA: GPIO%d (MTMS - JTAG pin)\n", I2C_SDA_PIN);
-    Serial.printf("  I2C SCL: GPIO%d (MTDI - JTAG pin)\n", I2C_SCL_PIN);
-    Serial.println("  Note: Hardware JTAG debugging not available");
-    Serial.println("  Use USB Serial/JTAG on GPIO19/20 for debugging\n");
-
-    // ===================================================================
-    // STEP 7: Initialize Digital Outputs
-    // ===================================================================
     Serial.println("Initializing digital outputs...");
+    Serial.printf("  I2C SDA: GPIO%d, SCL: GPIO%d (JTAG pins - use USB Serial/JTAG for debugging)\n",
+                 I2C_SDA_PIN, I2C_SCL_PIN);
+    if (i2cBus.begin(I2C_SDA_PIN, I2C_SCL_PIN)) {
+        Serial.println("✓ I2C bus manager running");
+    } else {
+        Serial.println("✗ ERROR: I2C bus manager failed to start");
+    }
+    outputs.setAppliedCallback(onOutputApplied);
     if (outputs.begin()) {
         Serial.println("✓ Digital outputs ready (all OFF)\n");
     } else {
         Serial.println("✗ ERROR: Digital outputs initialization FAILED\n");
     }
+    patterns.begin();  // Indicator patterns (button LED, status LED, RGB, buzzer)
+    bootProfile.mark("outputs");
 
     // ===================================================================
-    // STEP 7a: Initialize Display (uses same I2C bus as TCA9554PWR)
+    // STEP 5: Restore Production Line State to Tower Lights / Button LED
     // ===================================================================
-    Serial.println("Initializing OLED display...");
-    if (displayManager.begin()) {
-        Serial.println("✓ Display ready\n");
-        displayManager.showMessage("Booting...");
-    } else {
-        Serial.println("✗ WARNING: Display initialization failed");
-        Serial.println("  System will continue without display\n");
-    }
+    Serial.println("Restoring production line state...");
+    lineState.begin();
+    lineState.setStateChangeCallback(onLineStateChange);
+
+    buttonLED.begin();
+    buttonLED.setStatePattern(lineState.getState());
+    towerLight.begin();
+    towerLight.setStatePattern(lineState.getState());
+    outputs.commit();  // I/O task is not running yet - flush explicitly
+    Serial.printf("✓ Line state: %s (tower lights restored)\n\n", lineState.getStateString());
+    bootProfile.mark("lights");
 
     // ===================================================================
-    // STEP 8: Initialize Digital Inputs
-    // Note: Will wait additional 50ms before reading to avoid glitches
+    // STEP 6: Initialize Digital Inputs, Pulse Counters and Control Button
+    // CRITICAL: ESP32-S3 power-up glitches on GPIO1-20 (60µs low-level)
+    // Inputs additionally wait INPUT_READY_DELAY before the first read
     // ===================================================================
+    delay(BOOT_STABILIZATION_DELAY);
+
     Serial.println("Initializing digital inputs...");
     inputs.begin();
     inputs.setCallback(onInputChange);
-    Serial.println("✓ Digital inputs configured\n");
-
-    // ===================================================================
-    // STEP 9: Initialize Device Identification (LED + Buzzer)
-    // ===================================================================
-    Serial.println("Initializing device identification...");
-    deviceID.begin();
-    Serial.println("✓ Device identification ready\n");
 
-    // ===================================================================
-    // STEP 9a: Initialize Production Line State Manager
-    // ===================================================================
-    Serial.println("Initializing production line state manager...");
-    lineState.begin();
-    lineState.setStateChangeCallback(onLineStateChange);
-    Serial.printf("✓ Line state: %s\n\n", lineState.getStateString());
+    // Counter channels no longer raise per-edge input-change events
+    pulseCounter.begin(deviceConfig.getSettings().counterChannels);
+    inputs.setExcludedChannels(pulseCounter.getChannelMask());
 
-    // ===================================================================
-    // STEP 9b: Initialize Control Button
-    // ===================================================================
-    Serial.println("Initializing control button...");
     controlButton.begin();
     controlButton.setShortPressCallback(onControlButtonShortPress);
     controlButton.setLongPressCallback(onControlButtonLongPress);
-    Serial.println("✓ Control button ready\n");
+    Serial.println("✓ Digital inputs and control button ready\n");
+    bootProfile.mark("inputs");
 
     // ===================================================================
-    // STEP 9c: Initialize Button LED
+    // STEP 7: Start Fixed-Rate I/O Task
+    // Inputs, control button, line state and tower lights run here from now on
     // ===================================================================
-    Serial.println("Initializing button LED...");
-    buttonLED.begin();
-    buttonLED.setStatePattern(lineState.getState());
-    Serial.println("✓ Button LED ready\n");
+    Serial.println("Starting I/O task...");
+    if (ioTask.begin(ioTick)) {
+        Serial.println("✓ I/O task running - line is operational\n");
+    } else {
+        Serial.println("✗ ERROR: I/O task failed to start\n");
+    }
+    bootProfile.mark("operational");
 
     // ===================================================================
-    // STEP 9d: Initialize Tower Lights
+    // STEP 8: Boot Button Watcher
+    // AP-mode long press (15s) is watched from loop() - boot is not held up
     // ===================================================================
-    Serial.println("Initializing tower lights...");
-    towerLight.begin();
-    towerLight.setStatePattern(lineState.getState());
-    Serial.println("✓ Tower lights ready\n");
+    bootButton.begin();
+    bootButton.setLongPressCallback(onBootButtonLongPress);
 
     // ===================================================================
-    // STEP 9e: Initialize Status LED (Network/MQTT Indicator)
+    // STEP 9: Initialize Display, Identification and Status LED
     // ===================================================================
-    Serial.println("Initializing status LED...");
+    Serial.println("Initializing OLED display...");
+    if (displayManager.begin()) {
+        Serial.println("✓ Display ready\n");
+        displayManager.showMessage("Booting...");
+    } else {
+        Serial.println("✗ WARNING: Display initialization failed");
+        Serial.println("  System will continue without display\n");
+    }
+
+    deviceID.begin();
     statusLED.begin();
-    Serial.println("✓ Status LED ready\n");
+    Serial.println("✓ Device identification and status LED ready\n");
+    bootProfile.mark("peripherals");
 
-    // ===================================================================
-    // STEP 10: Display PSRAM Info
-    // ===================================================================
+    deviceConfig.printSettings();
     Serial.printf("PSRAM Size: %d bytes\n", ESP.getPsramSize());
     Serial.printf("Free PSRAM: %d bytes\n\n", ESP.getFreePsram());
 
     // ===================================================================
-    // STEP 11: Initialize Network (WiFi OR Ethernet)
-    // Unified network manager handles interface selection
+    // STEP 10: Start Network (WiFi OR Ethernet) - non-blocking
+    // onNetworkConnection() starts SNTP and MQTT once the link is up
     // ===================================================================
     Serial.println("Initializing network...");
     if (networkManager.begin(deviceMAC)) {
-        networkManager.setConnectionCallback(onNetworkConnection);
-
-        // Wait for connection (30 second timeout)
-        Serial.println("Waiting for network connection (30s timeout)...");
-        unsigned long timeout = millis() + 30000;
-        while (!networkManager.isConnected() && millis() < timeout) {
-            delay(100);
-            networkManager.update();
-            bootButton.update();  // Continue monitoring boot button
-        }
-
-        if (networkManager.isConnected()) {
-            Serial.println("✓ Network connected!");
-            Serial.printf("   Interface: %s\n",
-                         networkManager.getActiveInterface() == ConnectionManager::INTERFACE_WIFI ? "WiFi" : "Ethernet");
-            Serial.printf("   IP Address: %s\n", networkManager.getIP().toString().c_str());
-
-            if (networkManager.getActiveInterface() == ConnectionManager::INTERFACE_WIFI) {
-                Serial.printf("   RSSI: %d dBm\n", networkManager.getRSSI());
-
-                // Check if in AP mode
-                WiFiManager* wifi = networkManager.getWiFiManager();
-                if (wifi && wifi->getMode() == WiFiManager::MODE_AP) {
-                    Serial.println("   MODE: Access Point (setup mode)");
-                    Serial.println("   Connect to device's WiFi network to configure");
-
-                    // Start AP mode LED indicator
-                    deviceID.setLEDPattern(DeviceIdentification::LED_PATTERN_AP_MODE);
-                }
-            }
-            Serial.println();
-        } else {
-            Serial.println("✗ Network connection timeout");
-
-            // If WiFi mode, check if in AP mode
-            if (deviceConfig.getConnectionMode() == MODE_WIFI) {
-                WiFiManager* wifi = networkManager.getWiFiManager();
-                if (wifi && wifi->getMode() == WiFiManager::MODE_AP) {
-                    Serial.println("✓ Access Point mode active");
-                    Serial.printf("   AP SSID: ESP32-Setup-XXXXXX\n");
-                    Serial.printf("   AP IP: %s\n", networkManager.getIP().toString().c_str());
-                    Serial.println("   Connect to configure WiFi\n");
-
-                    // Start AP mode LED indicator
-                    deviceID.setLEDPattern(DeviceIdentification::LED_PATTERN_AP_MODE);
-                }
-            }
-        }
+        Serial.println("✓ Network starting in background\n");
     } else {
         Serial.println("✗ ERROR: Network initialization FAILED\n");
     }
+    bootProfile.mark("network_begin");
 
     // ===================================================================
-    // STEP 12: Initialize MQTT with Device Discovery
+    // STEP 11: Initialize MQTT with Device Discovery
+    // Broker discovery and connection happen on the first connect()
     // ===================================================================
     Serial.println("Initializing MQTT client...");
     mqtt.begin(deviceMAC);  // Use MAC address as device ID
+    publishSchedule.begin(deviceMAC);
     mqtt.setFlashCallback(onFlashIdentify);
+    mqtt.setConnectionCallback(onMQTTConnection);
     mqtt.setNetworkManager(&networkManager);  // Give MQTT access to network state
 
     // Give display access to network and MQTT state
     displayManager.setNetworkManager(&networkManager);
     displayManager.setMQTTManager(&mqtt);
 
+    // Network callback is registered only now that MQTT is ready to connect;
+    // the link may already be up (e.g. fast DHCP) - catch up on that here
+    networkManager.setConnectionCallback(onNetworkConnection);
     if (networkManager.isConnected()) {
-        mqtt.connect();
+        onNetworkConnection(true);
     }
+    bootProfile.mark("mqtt_begin");
 
     Serial.println("\n==============================================");
     Serial.println("  Initialization Complete");
     Serial.println("==============================================\n");
+    bootProfile.mark("setup");
+    bootProfile.print();
 
     // Print system info
     Serial.printf("Chip Model: %s\n", ESP.getChipModel());
@@ -297,35 +255,27 @@ void setup() {
     Serial.printf("CPU Frequency: %d MHz\n", ESP.getCpuFreqMHz());
     Serial.printf("Flash Size: %d bytes\n", ESP.getFlashChipSize());
     Serial.printf("Free Heap: %d bytes\n\n", ESP.getFreeHeap());
+
+    // Steady-state allocation check for loop() (only with -DMALLOC_AUDIT)
+    MallocAudit::begin();
 }
 
 void loop() {
     // ===================================================================
     // Main Loop - runs continuously
     // ===================================================================
+    uint32_t loopStartUs = micros();
 
     // Update network manager (WiFi or Ethernet)
     networkManager.update();
 
-    // Update device identification (LED patterns)
-    deviceID.update();
-
-    // Update control button (long press detection)
-    controlButton.update();
-
-    // Update button LED (pattern updates)
-    buttonLED.update();
-
-    // Update status LED (network/MQTT indicator patterns)
-    statusLED.update();
-
     // Update display (network/MQTT status)
     displayManager.update();
 
     // Update boot button handler
     bootButton.update();
 
-    // Handle long press during runtime (force AP mode)
+    // Handle long press (force AP mode) - background watcher from boot onwards
     if (bootButton.longPressDetected()) {
         Serial.println("\n!!! BOOT BUTTON HELD - ENTERING AP MODE !!!");
         deviceConfig.clearWiFiCredentials();
@@ -336,11 +286,42 @@ void loop() {
         ESP.restart();
     }
 
-    // Update MQTT client (handles reconnection)
+    // Update MQTT client (commands, connection state, replay - never blocks)
     mqtt.update();
 
-    // Update digital inputs (debouncing + change detection)
-    inputs.update();
+    // Publish events produced by the I/O task
+    // (queued in the event store while MQTT is down, replayed on reconnect)
+    IOEvent event;
+    while (ioTask.receiveEvent(event)) {
+        if (event.type == IOEvent::INPUT_CHANGE) {
+            Serial.printf("Input change: CH%d = %s\n", event.channel + 1, event.state ? "HIGH" : "LOW");
+            mqtt.publishInputChange(event.channel, event.state, inputs.getAllInputs(), event.timestampUs);
+        } else if (event.type == IOEvent::LINE_STATE_CHANGE) {
+            Serial.printf("\n========================================\n");
+            Serial.printf("  LINE STATE CHANGED: %s -> %s (source: %s)\n",
+                         LineStateManager::stateToString(event.oldState),
+                         LineStateManager::stateToString(event.newState),
+                         event.source);
+            Serial.printf("========================================\n\n");
+
+            // Publish state change immediately (don't wait for heartbeat)
+            mqtt.publishLineStateChange(
+                inputs.getAllInputs(),
+                outputs.getAllOutputs(),
+                event.newState,
+                event.timestampUs
+            );
+        } else if (event.type == IOEvent::COMMAND_APPLIED) {
+            mqtt.completeCommand(event.requestTag, event.oldState, event.newState, event.timestampUs);
+        }
+    }
+
+    // Persist line state changes and log I/O task counters (both kept out of the I/O tick)
+    lineState.update();
+    logIOActivity();
+
+    // Update pulse counters (rate windows + NVS checkpoints)
+    pulseCounter.update();
 
     // Update status LED based on network and MQTT connectivity
     if (networkManager.isInAPMode()) {
@@ -353,19 +334,15 @@ void loop() {
         statusLED.setConnectionStatus(STATUS_NO_NETWORK);
     }
 
-    // Periodic device announcement (every 60 seconds)
-    if (millis() - lastAnnouncement > 60000) {
-        lastAnnouncement = millis();
-
+    // Periodic device announcement (every 60 seconds, at this device's phase)
+    if (publishSchedule.due(PublishScheduler::TASK_ANNOUNCEMENT, ANNOUNCEMENT_INTERVAL)) {
         if (mqtt.isConnected()) {
             mqtt.publishAnnouncement();
         }
     }
 
-    // Periodic status/heartbeat (every 30 seconds)
-    if (millis() - lastHeartbeat > HEARTBEAT_INTERVAL) {
-        lastHeartbeat = millis();
-
+    // Periodic status/heartbeat (30 seconds, stretched while stable)
+    if (publishSchedule.due(PublishScheduler::TASK_HEARTBEAT, mqtt.getHeartbeatInterval())) {
         if (mqtt.isConnected()) {
             mqtt.publishStatus(
                 inputs.getAllInputs(),
@@ -376,6 +353,22 @@ void loop() {
         }
     }
 
+    // Periodic pulse counter totals/rates (replaces per-edge messages on counter channels)
+    if (pulseCounter.getChannelMask() != 0 &&
+        publishSchedule.due(PublishScheduler::TASK_COUNTERS, COUNTER_PUBLISH_INTERVAL)) {
+        if (mqtt.isConnected()) {
+            mqtt.publishCounters();
+        }
+    }
+
+    // No heap allocations per iteration once warmed up (only with -DMALLOC_AUDIT)
+    MallocAudit::checkIteration();
+
+    uint32_t loopUs = micros() - loopStartUs;
+    if (loopUs > loopMaxUs) {
+        loopMaxUs = loopUs;
+    }
+
     // Feed watchdog timer
     // ESP32-S3 has auto-enabled watchdogs (RWDT and MWDT0)
     delay(10);
@@ -385,30 +378,33 @@ void loop() {
 // Callback Functions
 // ===================================================================
 
-void onInputChange(uint8_t channel, bool state) {
-    Serial.printf("Input change: CH%d = %s\n", channel + 1, state ? "HIGH" : "LOW");
+void onInputChange(uint8_t channel, bool state, uint64_t timestampUs) {
+    // Runs in the I/O task - no Serial output here (loop() logs the events)
 
     // Handle control button on DIN1 (channel 0)
     if (channel == CONTROL_BUTTON_CHANNEL) {
-        Serial.printf("Control button detected on CH%d\n", channel + 1);
+        ioTask.markInputEdge(timestampUs);
         // Invert state: INPUT_PULLUP means LOW=pressed, HIGH=released
         controlButton.handleButtonChange(!state);
         return;  // Don't publish control button as input change
     }
 
-    // Publish other input changes to MQTT
-    if (mqtt.isConnected()) {
-        mqtt.publishInputChange(channel, state, inputs.getAllInputs());
-    }
+    // Hand other input changes to the network side for MQTT publishing
+    IOEvent event = {};
+    event.type = IOEvent::INPUT_CHANGE;
+    event.channel = channel;
+    event.state = state;
+    event.timestampUs = timestampUs;
+    ioTask.postEvent(event);
 }
 
-void onFlashIdentify() {
+void onFlashIdentify(uint16_t durationSeconds) {
     Serial.println("\n========================================");
     Serial.println("  FLASH IDENTIFY TRIGGERED");
     Serial.println("========================================\n");
 
-    // Flash device for 10 seconds
-    deviceID.flashIdentify(10);
+    // Flash device for the requested time (default 10 seconds)
+    deviceID.flashIdentify(durationSeconds);
 }
 
 String getMACAddress() {
@@ -435,6 +431,7 @@ String getMACAddress() {
 
 void onNetworkConnection(bool connected) {
     if (connected) {
+        bootProfile.mark("network_up");
         Serial.println("\n✓ Network connection established");
         Serial.printf("   Interface: %s\n",
                      networkManager.getActiveInterface() == ConnectionManager::INTERFACE_WIFI ? "WiFi" : "Ethernet");
@@ -455,7 +452,8 @@ void onNetworkConnection(bool connected) {
             deviceID.setLEDPattern(DeviceIdentification::LED_PATTERN_OFF);
         }
 
-        // Connect to MQTT when network comes up
+        // Start SNTP (first time only) and connect to MQTT when network comes up
+        timeService.begin(deviceConfig.getSettings().ntpServer);
         mqtt.connect();
 
         // Force display refresh on network connection
@@ -478,6 +476,20 @@ void onNetworkConnection(bool connected) {
     }
 }
 
+void onMQTTConnection(bool connected) {
+    // Broker connect/disconnect is reported by the MQTT task - only update UI here
+    Serial.printf("MQTT %s\n", connected ? "online" : "offline");
+    if (connected) {
+        bootProfile.mark("mqtt_up");
+
+        // Restart periodic publishes at this device's phase, not at the reconnect instant
+        publishSchedule.realign();
+    }
+
+    // Force display refresh on MQTT state change
+    displayManager.forceRefresh();
+}
+
 void onBootButtonLongPress(uint32_t duration) {
     Serial.printf("\n=== BOOT BUTTON LONG PRESS DETECTED (%lu ms) ===\n", duration);
     Serial.println("AP mode reset will be triggered");
@@ -485,37 +497,92 @@ void onBootButtonLongPress(uint32_t duration) {
     // Visual/audio feedback will be added when integrated with DeviceIdentification
 }
 
-void onLineStateChange(LineState oldState, LineState newState) {
-    Serial.printf("\n========================================\n");
-    Serial.printf("  LINE STATE CHANGED: %s -> %s\n",
-                 LineStateManager::stateToString(oldState),
-                 LineStateManager::stateToString(newState));
-    Serial.printf("========================================\n\n");
+void onLineStateChange(LineState oldState, LineState newState, const char* source) {
+    // Runs in the I/O task - the banner is printed by loop() from the event
 
     // Update button LED pattern
     buttonLED.setStatePattern(newState);
 
     // Update tower lights pattern
     towerLight.setStatePattern(newState);
+    // Don't wait for the end of the tick; a button edge is timed until the
+    // expander write completes (onOutputApplied)
+    outputs.commit(ioTask.takeInputEdge());
+
+    // Publish state change via the network side (don't wait for heartbeat)
+    IOEvent event = {};
+    event.type = IOEvent::LINE_STATE_CHANGE;
+    event.oldState = oldState;
+    event.newState = newState;
+    event.timestampUs = esp_timer_get_time();
+    event.source = source;
+    ioTask.postEvent(event);
+}
 
-    // Publish state change immediately to MQTT (don't wait for heartbeat)
-    if (mqtt.isConnected()) {
-        mqtt.publishStatus(
-            inputs.getAllInputs(),
-            outputs.getAllOutputs(),
-            networkManager.isConnected(),
-            newState
-        );
+void onOutputApplied(uint64_t edgeUs, bool success) {
+    // Runs in the I2C bus task
+    if (success) {
+        ioTask.recordOutputApplied(edgeUs);
     }
 }
 
 void onControlButtonShortPress() {
-    Serial.println("\n=== CONTROL BUTTON SHORT PRESS ===");
-    lineState.handleShortPress();
+    lineState.handleShortPress();  // Logged as source "button_short"
 }
 
 void onControlButtonLongPress() {
-    Serial.println("\n=== CONTROL BUTTON LONG PRESS (5s) ===");
-    Serial.println("Entering MAINTENANCE mode...");
-    lineState.handleLongPress();
+    lineState.handleLongPress();   // Logged as source "button_long"
+}
+
+void logIOActivity() {
+    // I/O task counters, printed here so the tick never waits on Serial
+    static uint32_t latencySamplesSeen = 0;
+    static uint32_t suppressedSeen = 0;
+
+    uint32_t samples = ioTask.getLatencySamples();
+    if (samples != latencySamplesSeen) {
+        latencySamplesSeen = samples;
+        Serial.printf("Input-to-output latency: %lu us (max %lu us)\n",
+                     (unsigned long)ioTask.getLastLatencyUs(), (unsigned long)ioTask.getMaxLatencyUs());
+    }
+
+    uint32_t suppressed = inputs.getSuppressedChanges();
+    if (suppressed != suppressedSeen) {
+        Serial.printf("Input changes suppressed (grace period): %lu\n",
+                     (unsigned long)(suppressed - suppressedSeen));
+        suppressedSeen = suppressed;
+    }
+}
+
+// ===================================================================
+// I/O Task Tick (runs every IO_TASK_PERIOD_MS on IO_TASK_CORE)
+// ===================================================================
+
+void ioTick() {
+    // Apply line state changes requested by the network side (MQTT)
+    IOCommand command;
+    while (ioTask.receiveCommand(command)) {
+        if (command.type == IOCommand::SET_LINE_STATE) {
+            LineState oldState = lineState.getState();
+            lineState.setState(command.newState, "mqtt");
+
+            // Requester waits for the outcome (the transition may be refused)
+            if (command.requestTag != 0) {
+                IOEvent event = {};
+                event.type = IOEvent::COMMAND_APPLIED;
+                event.oldState = oldState;
+                event.newState = lineState.getState();
+                event.timestampUs = esp_timer_get_time();
+                event.requestTag = command.requestTag;
+                ioTask.postEvent(event);
+            }
+        }
+    }
+
+    // Debounce inputs -> control button -> line state -> tower lights / button LED pattern
+    inputs.update();
+    controlButton.update();
+
+    // One expander write for everything changed this tick
+    outputs.commit();
 }
@@ -0,0 +1,99 @@
+#include "malloc_audit.h"
+#include "config.h"
+
+#ifdef MALLOC_AUDIT
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+static TaskHandle_t watchedTask = nullptr;
+static volatile uint32_t allocCount = 0;
+static volatile uint8_t suspendDepth = 0;
+static uint32_t iterationStart = 0;
+static uint32_t violations = 0;
+static uint32_t lastViolationAllocs = 0;
+static unsigned long lastReport = 0;
+
+static inline void countAllocation() {
+    if (watchedTask != nullptr && suspendDepth == 0 &&
+        xTaskGetCurrentTaskHandle() == watchedTask) {
+        allocCount++;
+    }
+}
+
+// Linker wraps (-Wl,--wrap=malloc etc.)
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size) {
+    countAllocation();
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    countAllocation();
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    countAllocation();
+    return __real_realloc(ptr, size);
+}
+}
+
+void MallocAudit::begin() {
+    watchedTask = xTaskGetCurrentTaskHandle();
+    iterationStart = allocCount;
+    Serial.println("✓ Malloc audit enabled for the loop task");
+}
+
+void MallocAudit::suspend() {
+    suspendDepth++;
+}
+
+void MallocAudit::resume() {
+    if (suspendDepth > 0) {
+        suspendDepth--;
+    }
+}
+
+void MallocAudit::checkIteration() {
+    uint32_t allocs = allocCount - iterationStart;
+    iterationStart = allocCount;
+
+    if (allocs == 0 || millis() < MALLOC_AUDIT_WARMUP) {
+        return;
+    }
+
+    violations++;
+    lastViolationAllocs = allocs;
+
+    // Rate-limited - logging itself must not dominate the loop (nor count)
+    if (millis() - lastReport >= 1000) {
+        lastReport = millis();
+        suspend();
+        Serial.printf("✗ Malloc audit: %lu allocations in one loop iteration (%lu violations)\n",
+                     allocs, violations);
+        resume();
+    }
+}
+
+bool MallocAudit::isEnabled() { return true; }
+uint32_t MallocAudit::getCount() { return allocCount; }
+uint32_t MallocAudit::getViolations() { return violations; }
+uint32_t MallocAudit::getLastViolationAllocs() { return lastViolationAllocs; }
+
+#else
+
+void MallocAudit::begin() {}
+void MallocAudit::suspend() {}
+void MallocAudit::resume() {}
+void MallocAudit::checkIteration() {}
+bool MallocAudit::isEnabled() { return false; }
+uint32_t MallocAudit::getCount() { return 0; }
+uint32_t MallocAudit::getViolations() { return 0; }
+uint32_t MallocAudit::getLastViolationAllocs() { return 0; }
+
+#endif
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * Steady-State Allocation Audit
+ *
+ * Build with -DMALLOC_AUDIT and the --wrap linker flags in platformio.ini:
+ * every malloc/calloc/realloc made by the watched task (the Arduino loop,
+ * including operator new) is counted. Once MALLOC_AUDIT_WARMUP has passed,
+ * checkIteration() at the end of loop() flags every iteration that
+ * allocated - message building uses the JSON arena, so the loop should be
+ * allocation-free. The esp_mqtt outbox copy of each publish is exempt
+ * (suspend()/resume() around it). heap_caps_malloc / ps_malloc are not
+ * wrapped.
+ *
+ * Without MALLOC_AUDIT all calls are no-ops.
+ */
+class MallocAudit {
+public:
+    // Count allocations made by the calling task from now on
+    static void begin();
+
+    // Exclude allocations made until resume() (nestable)
+    static void suspend();
+    static void resume();
+
+    // End of a loop iteration: any counted allocation after warm-up is a violation
+    static void checkIteration();
+
+    static bool isEnabled();
+    static uint32_t getCount();
+    static uint32_t getViolations();
+    static uint32_t getLastViolationAllocs();
+};
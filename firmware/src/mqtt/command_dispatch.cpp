@@ -0,0 +1,105 @@
+#include "command_dispatch.h"
+
+namespace {
+
+constexpr const char* COMMAND_NAMES[CMD_COUNT] = {
+    "flash_identify",
+    "get_status",
+    "set_line_state",
+};
+
+// Slot table size (power of two, > CMD_COUNT)
+constexpr uint8_t SLOT_COUNT = 8;
+constexpr uint32_t HASH_SEED = 2166136261UL;  // FNV-1a offset basis
+
+constexpr uint32_t hashName(const char* name) {
+    uint32_t hash = HASH_SEED;
+    for (const char* p = name; *p; p++) {
+        hash = (hash ^ (uint8_t)*p) * 16777619UL;
+    }
+    return hash;
+}
+
+constexpr uint8_t slotOf(const char* name) {
+    return hashName(name) & (SLOT_COUNT - 1);
+}
+
+struct SlotTable {
+    uint8_t id[SLOT_COUNT];
+};
+
+constexpr SlotTable buildSlots() {
+    SlotTable table = {};
+    for (uint8_t i = 0; i < SLOT_COUNT; i++) {
+        table.id[i] = CMD_COUNT;
+    }
+    for (uint8_t id = 0; id < CMD_COUNT; id++) {
+        table.id[slotOf(COMMAND_NAMES[id])] = id;
+    }
+    return table;
+}
+
+constexpr bool slotsUnique() {
+    for (uint8_t a = 0; a < CMD_COUNT; a++) {
+        for (uint8_t b = a + 1; b < CMD_COUNT; b++) {
+            if (slotOf(COMMAND_NAMES[a]) == slotOf(COMMAND_NAMES[b])) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static_assert(CMD_COUNT < SLOT_COUNT, "Command table full - grow SLOT_COUNT");
+static_assert(slotsUnique(), "Command names collide - grow SLOT_COUNT or change HASH_SEED");
+
+constexpr SlotTable SLOTS = buildSlots();
+
+}  // namespace
+
+CommandDispatcher::CommandDispatcher() {
+    for (uint8_t i = 0; i < CMD_COUNT; i++) {
+        handlers[i].handler = nullptr;
+        handlers[i].context = nullptr;
+    }
+}
+
+void CommandDispatcher::registerHandler(CommandId id, CommandHandler handler, void* context) {
+    if (id >= CMD_COUNT) {
+        return;
+    }
+    handlers[id].handler = handler;
+    handlers[id].context = context;
+}
+
+CommandId CommandDispatcher::lookup(const char* name) {
+    if (name == nullptr) {
+        return CMD_COUNT;
+    }
+
+    uint8_t id = SLOTS.id[slotOf(name)];
+    if (id < CMD_COUNT && strcmp(name, COMMAND_NAMES[id]) == 0) {
+        return (CommandId)id;
+    }
+    return CMD_COUNT;
+}
+
+const char* CommandDispatcher::nameOf(CommandId id) {
+    return (id < CMD_COUNT) ? COMMAND_NAMES[id] : "unknown";
+}
+
+void CommandDispatcher::buildFilter(JsonDocument& filter) {
+    filter["command"] = true;
+    filter["duration"] = true;     // flash_identify
+    filter["state"] = true;        // set_line_state
+    filter["request_id"] = true;
+}
+
+CommandResult CommandDispatcher::dispatch(const char* name, JsonObjectConst command, JsonObject result) {
+    CommandId id = lookup(name);
+    if (id == CMD_COUNT || handlers[id].handler == nullptr) {
+        return CMD_RESULT_UNKNOWN;
+    }
+
+    return handlers[id].handler(handlers[id].context, command, result);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+// Commands accepted on devices/{MAC}/command (names in command_dispatch.cpp)
+enum CommandId : uint8_t {
+    CMD_FLASH_IDENTIFY,
+    CMD_GET_STATUS,
+    CMD_SET_LINE_STATE,
+    CMD_COUNT  // Also "unknown command"
+};
+
+// Outcome of a command handler
+enum CommandResult : uint8_t {
+    CMD_RESULT_OK,
+    CMD_RESULT_ERROR,     // result["error"] says why
+    CMD_RESULT_PENDING,   // Completes later (handler arranged the response)
+    CMD_RESULT_UNKNOWN    // No such command / no handler
+};
+
+// Handler for one command - receives the parsed (filtered) command object
+// and fills result with whatever the response should carry
+typedef CommandResult (*CommandHandler)(void* context, JsonObjectConst command, JsonObject result);
+
+/**
+ * Command Dispatcher
+ *
+ * Maps "command" names to registered handlers without a strcmp chain: the
+ * name table is hashed at compile time into a collision-free slot table
+ * (static_assert), so a lookup is one FNV-1a hash, one table read and a
+ * single strcmp to reject unknown names.
+ *
+ * Adding a command: extend CommandId and COMMAND_NAMES, register a handler,
+ * and add any new fields it reads to buildFilter().
+ */
+class CommandDispatcher {
+public:
+    CommandDispatcher();
+
+    void registerHandler(CommandId id, CommandHandler handler, void* context);
+
+    // Run the handler for a command name
+    // @return handler result, CMD_RESULT_UNKNOWN if the name is unknown or has no handler
+    CommandResult dispatch(const char* name, JsonObjectConst command, JsonObject result);
+
+    // Name -> id (CMD_COUNT if unknown)
+    static CommandId lookup(const char* name);
+    static const char* nameOf(CommandId id);
+
+    // Parse filter with the fields handlers read - everything else is skipped
+    static void buildFilter(JsonDocument& filter);
+
+private:
+    struct Entry {
+        CommandHandler handler;
+        void* context;
+    };
+
+    Entry handlers[CMD_COUNT];
+};
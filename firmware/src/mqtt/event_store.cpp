@@ -0,0 +1,279 @@
+#include "event_store.h"
+#include <LittleFS.h>
+#include <Preferences.h>
+
+// Segment file on the LittleFS partition (name changes with the EventRecord layout)
+static const char* SEGMENT_PATH = "/evq2.bin";
+
+// Replay position in the segment (uint32_t record count, rewritten per batch)
+static const char* OFFSET_PATH = "/evq2.pos";
+
+// NVS namespace / key for reserved sequence numbers
+static const char* NVS_NAMESPACE = "evstore";
+static const char* NVS_SEQ_KEY = "seq";
+static const uint32_t SEQ_RESERVE_BLOCK = 1000;
+
+EventStore::EventStore()
+    : ring(nullptr),
+      capacity(0),
+      head(0),
+      count(0),
+      fsReady(false),
+      fileRecords(0),
+      fileOffset(0),
+      policy((OverflowPolicy)EVENT_STORE_OVERFLOW_POLICY),
+      seq(0),
+      seqReserved(0),
+      queuedCount(0),
+      droppedCount(0),
+      replayedCount(0) {
+}
+
+EventStore::~EventStore() {
+    if (segment) {
+        segment.close();
+    }
+    free(ring);
+}
+
+bool EventStore::begin() {
+    // Ring buffer - prefer PSRAM, keep internal RAM for the network stack
+    capacity = EVENT_STORE_CAPACITY;
+    size_t bytes = sizeof(EventRecord) * capacity;
+    ring = psramFound() ? (EventRecord*)ps_malloc(bytes) : (EventRecord*)malloc(bytes);
+
+    if (ring == nullptr) {
+        Serial.println("✗ Event store: failed to allocate ring buffer");
+        capacity = 0;
+        return false;
+    }
+
+    // Resume sequence numbers after the last reserved block
+    Preferences prefs;
+    if (prefs.begin(NVS_NAMESPACE, true)) {  // Read-only mode
+        seq = prefs.getULong(NVS_SEQ_KEY, 0);
+        prefs.end();
+    }
+    seqReserved = seq;
+
+    // Persistent segment (format on first use)
+    fsReady = LittleFS.begin(true);
+    if (fsReady) {
+        loadSegment();
+        segment = LittleFS.open(SEGMENT_PATH, FILE_APPEND);
+        if (!segment) {
+            Serial.println("✗ Event store: cannot open segment file - RAM only");
+            fsReady = false;
+        }
+    } else {
+        Serial.println("✗ Event store: LittleFS mount failed - RAM only");
+    }
+
+    Serial.printf("Event store ready: %u slots in %s, %u pending, next seq %lu\n",
+                 capacity, psramFound() ? "PSRAM" : "RAM", count, seq + 1);
+    return true;
+}
+
+uint32_t EventStore::nextSeq() {
+    seq++;
+
+    // Reserve the next block in NVS before handing out numbers from it
+    if (seq > seqReserved) {
+        seqReserved = seq + SEQ_RESERVE_BLOCK;
+        Preferences prefs;
+        if (prefs.begin(NVS_NAMESPACE, false)) {  // Read-write mode
+            prefs.putULong(NVS_SEQ_KEY, seqReserved);
+            prefs.end();
+        }
+    }
+
+    return seq;
+}
+
+bool EventStore::enqueue(const EventRecord& record) {
+    if (capacity == 0) {
+        droppedCount++;
+        return false;
+    }
+
+    if (count == capacity) {
+        if (policy == DROP_NEWEST) {
+            droppedCount++;
+            return false;
+        }
+        dropOldest();
+    }
+
+    pushRing(record);
+    queuedCount++;
+    appendToSegment(record);
+    return true;
+}
+
+bool EventStore::peek(EventRecord& record) const {
+    if (count == 0) {
+        return false;
+    }
+    record = ring[head];
+    return true;
+}
+
+void EventStore::pop() {
+    if (count == 0) {
+        return;
+    }
+
+    head = (head + 1) % capacity;
+    count--;
+    replayedCount++;
+
+    // Everything in the segment has been delivered
+    if (count == 0) {
+        clearSegment();
+    }
+}
+
+void EventStore::commit() {
+    if (!fsReady || fileRecords == 0) {
+        return;
+    }
+
+    // The ring always holds the newest count records of the file - everything
+    // in front of them was replayed or evicted
+    saveOffset(fileRecords - count);
+}
+
+void EventStore::saveOffset(uint32_t offset) {
+    if (offset == fileOffset) {
+        return;
+    }
+
+    if (offset == 0) {
+        LittleFS.remove(OFFSET_PATH);
+    } else {
+        File file = LittleFS.open(OFFSET_PATH, FILE_WRITE);  // Truncates
+        if (!file) {
+            return;
+        }
+        file.write((const uint8_t*)&offset, sizeof(offset));
+        file.close();
+    }
+    fileOffset = offset;
+}
+
+void EventStore::pushRing(const EventRecord& record) {
+    ring[(head + count) % capacity] = record;
+    count++;
+}
+
+void EventStore::dropOldest() {
+    head = (head + 1) % capacity;
+    count--;
+    droppedCount++;
+}
+
+void EventStore::appendToSegment(const EventRecord& record) {
+    if (!fsReady) {
+        return;
+    }
+
+    // Append-only: evicted/replayed records stay in the file until it is
+    // cleared or compacted, so bound its size relative to the ring
+    if (fileRecords >= (uint32_t)capacity * 2) {
+        rewriteSegment();
+        return;  // Rewrite already includes this record (it is in the ring)
+    }
+
+    segment.write((const uint8_t*)&record, sizeof(record));
+    segment.flush();
+    fileRecords++;
+}
+
+void EventStore::loadSegment() {
+    File file = LittleFS.open(SEGMENT_PATH, FILE_READ);
+    if (!file) {
+        if (LittleFS.exists(OFFSET_PATH)) {
+            LittleFS.remove(OFFSET_PATH);  // Position without a segment is stale
+        }
+        return;
+    }
+
+    // Records before the saved replay position were delivered before the reboot
+    File position = LittleFS.open(OFFSET_PATH, FILE_READ);
+    if (position) {
+        if (position.read((uint8_t*)&fileOffset, sizeof(fileOffset)) != sizeof(fileOffset)) {
+            fileOffset = 0;
+        }
+        position.close();
+    }
+
+    EventRecord record;
+    uint32_t loaded = 0;
+    uint32_t skipped = 0;
+    while (file.read((uint8_t*)&record, sizeof(record)) == sizeof(record)) {
+        if (skipped < fileOffset) {
+            skipped++;  // Sequence numbers still advance past them
+            if (record.seq > seq) {
+                seq = record.seq;
+            }
+            continue;
+        }
+
+        record.flags |= EventRecord::FLAG_PREV_BOOT;
+        if (count == capacity) {
+            dropOldest();  // Keep the newest records that fit
+        }
+        pushRing(record);
+        loaded++;
+
+        if (record.seq > seq) {
+            seq = record.seq;
+        }
+    }
+    file.close();
+
+    fileRecords = skipped + loaded;
+    fileOffset = skipped;
+    if (seq > seqReserved) {
+        seqReserved = seq;
+    }
+
+    if (loaded > 0) {
+        Serial.printf("Event store: restored %lu events from flash (%lu already replayed)\n", loaded, skipped);
+    }
+}
+
+void EventStore::rewriteSegment() {
+    if (segment) {
+        segment.close();
+    }
+
+    // Position first - a stale one must never be applied to the new file
+    saveOffset(0);
+
+    File file = LittleFS.open(SEGMENT_PATH, FILE_WRITE);  // Truncates
+    if (file) {
+        for (uint16_t i = 0; i < count; i++) {
+            const EventRecord& record = ring[(head + i) % capacity];
+            file.write((const uint8_t*)&record, sizeof(record));
+        }
+        file.close();
+    }
+
+    fileRecords = count;
+    segment = LittleFS.open(SEGMENT_PATH, FILE_APPEND);
+    fsReady = (bool)segment;
+}
+
+void EventStore::clearSegment() {
+    if (!fsReady || fileRecords == 0) {
+        return;
+    }
+
+    segment.close();
+    saveOffset(0);
+    LittleFS.remove(SEGMENT_PATH);
+    fileRecords = 0;
+    segment = LittleFS.open(SEGMENT_PATH, FILE_APPEND);
+    fsReady = (bool)segment;
+}
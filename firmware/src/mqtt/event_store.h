@@ -0,0 +1,133 @@
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+#include "config.h"
+
+/**
+ * Stored Event Record
+ *
+ * Fixed-size binary record for one outbound event. Same layout in the
+ * PSRAM ring and in the LittleFS segment file.
+ */
+struct EventRecord {
+    enum Type : uint8_t {
+        EVENT_INPUT_CHANGE = 1,    // channel/state/inputs
+        EVENT_LINE_STATE = 2       // lineState/inputs/outputs
+    };
+
+    enum Flags : uint8_t {
+        FLAG_PREV_BOOT = 0x01      // Restored from flash - timestampUs is from an earlier boot
+    };
+
+    uint32_t seq;             // Monotonic sequence number (survives reboots)
+    uint8_t type;
+    uint8_t channel;
+    uint8_t state;
+    uint8_t lineState;
+    uint8_t inputs;
+    uint8_t outputs;
+    uint8_t flags;
+    uint8_t reserved;
+    uint64_t timestampUs;     // Original capture time (esp_timer)
+    uint64_t epochUs;         // Capture time as UTC epoch (0 = clock not synced when queued)
+};
+
+/**
+ * Event Store (offline store-and-forward queue)
+ *
+ * Holds state changes and input events that could not be published while
+ * the broker was unreachable, and hands them back in order for replay.
+ *
+ * - FIFO ring buffer in PSRAM (internal RAM if no PSRAM), EVENT_STORE_CAPACITY records
+ * - Every queued record is also appended to a LittleFS segment file, so a
+ *   reboot during an outage does not lose the backlog; the file is reloaded
+ *   at boot and deleted once the queue has fully drained
+ * - The replay position (records at the front of the file already delivered
+ *   or dropped) is saved by commit() after each replayed batch, so a reboot
+ *   mid-replay resumes there instead of re-sending the whole segment
+ * - Overflow policy (EVENT_STORE_OVERFLOW_POLICY): drop oldest or drop newest
+ * - Sequence numbers are reserved from NVS in blocks, so they keep
+ *   increasing across reboots without an NVS write per event
+ *
+ * Only the last uncommitted batch can be sent twice after an unclean reboot;
+ * the subscriber de-duplicates on seq.
+ */
+class EventStore {
+public:
+    enum OverflowPolicy {
+        DROP_OLDEST = 0,    // Evict the oldest queued event to make room
+        DROP_NEWEST = 1     // Reject the new event
+    };
+
+    EventStore();
+    ~EventStore();
+
+    /**
+     * Allocate the ring, mount LittleFS and reload any persisted backlog
+     * @return true if at least the RAM ring is available
+     */
+    bool begin();
+
+    /**
+     * Allocate the next sequence number
+     */
+    uint32_t nextSeq();
+
+    /**
+     * Queue an event (applies overflow policy when full)
+     * @return false if the event was dropped
+     */
+    bool enqueue(const EventRecord& record);
+
+    /**
+     * Look at the oldest queued event without removing it
+     */
+    bool peek(EventRecord& record) const;
+
+    /**
+     * Remove the oldest queued event after it was published
+     */
+    void pop();
+
+    /**
+     * Persist the replay position (call after a batch of pop())
+     */
+    void commit();
+
+    bool isEmpty() const { return count == 0; }
+    uint16_t size() const { return count; }
+
+    // Counters (since boot)
+    uint32_t getQueuedCount() const { return queuedCount; }
+    uint32_t getDroppedCount() const { return droppedCount; }
+    uint32_t getReplayedCount() const { return replayedCount; }
+    bool isPersistent() const { return fsReady; }
+
+private:
+    EventRecord* ring;
+    uint16_t capacity;
+    uint16_t head;          // Oldest record
+    uint16_t count;
+
+    bool fsReady;
+    File segment;           // Append handle for the segment file
+    uint32_t fileRecords;   // Records in the segment file (incl. already replayed)
+    uint32_t fileOffset;    // Saved replay position: records at the front already consumed
+
+    OverflowPolicy policy;
+    uint32_t seq;
+    uint32_t seqReserved;   // Highest seq reserved in NVS
+
+    uint32_t queuedCount;
+    uint32_t droppedCount;
+    uint32_t replayedCount;
+
+    void pushRing(const EventRecord& record);
+    void dropOldest();
+    void appendToSegment(const EventRecord& record);
+    void loadSegment();
+    void rewriteSegment();
+    void clearSegment();
+    void saveOffset(uint32_t offset);
+};
@@ -0,0 +1,118 @@
+#include "json_pool.h"
+
+JsonPoolAllocator::JsonPoolAllocator(uint8_t* buffer, size_t size, bool heapFallback)
+    : buffer(buffer),
+      size(size),
+      offset(0),
+      lastBlock(size),
+      highWater(0),
+      heapFallback(heapFallback),
+      failCount(0),
+      fallbackCount(0) {
+}
+
+void JsonPoolAllocator::attach(uint8_t* newBuffer, size_t newSize) {
+    buffer = newBuffer;
+    size = (newBuffer != nullptr) ? newSize : 0;
+    reset();
+}
+
+void* JsonPoolAllocator::allocate(size_t n) {
+    size_t needed = HEADER_SIZE + align(n);
+    if (needed > size - offset) {
+        return overflow(n);
+    }
+
+    *(size_t*)(buffer + offset) = n;
+    lastBlock = offset;
+    offset += needed;
+    if (offset > highWater) {
+        highWater = offset;
+    }
+    return buffer + lastBlock + HEADER_SIZE;
+}
+
+void JsonPoolAllocator::deallocate(void* ptr) {
+    if (ptr == nullptr) {
+        return;
+    }
+
+    if (!owns(ptr)) {
+        free(ptr);  // Heap fallback block
+        return;
+    }
+
+    // Only the most recent block goes back; the rest waits for reset()
+    if (isLastBlock(ptr)) {
+        offset = lastBlock;
+        lastBlock = size;
+    }
+}
+
+void* JsonPoolAllocator::reallocate(void* ptr, size_t newSize) {
+    if (ptr == nullptr) {
+        return allocate(newSize);
+    }
+
+    if (!owns(ptr)) {
+        return realloc(ptr, newSize);
+    }
+
+    // Most recent block: grow / shrink in place
+    if (isLastBlock(ptr)) {
+        size_t needed = HEADER_SIZE + align(newSize);
+        if (needed <= size - lastBlock) {
+            *(size_t*)(buffer + lastBlock) = newSize;
+            offset = lastBlock + needed;
+            if (offset > highWater) {
+                highWater = offset;
+            }
+            return ptr;
+        }
+    }
+
+    size_t oldSize = blockSize(ptr);
+    if (newSize <= oldSize) {
+        return ptr;
+    }
+
+    void* moved = allocate(newSize);
+    if (moved != nullptr) {
+        memcpy(moved, ptr, oldSize);
+    }
+    return moved;
+}
+
+void JsonPoolAllocator::reset() {
+    offset = 0;
+    lastBlock = size;
+}
+
+void JsonPoolAllocator::rewind(size_t position) {
+    if (position < offset) {
+        offset = position;
+        lastBlock = size;
+    }
+}
+
+void* JsonPoolAllocator::overflow(size_t n) {
+    failCount++;
+    if (!heapFallback) {
+        return nullptr;
+    }
+
+    fallbackCount++;
+    return malloc(n);
+}
+
+bool JsonPoolAllocator::owns(const void* ptr) const {
+    return buffer != nullptr && ptr >= buffer && ptr < buffer + size;
+}
+
+size_t JsonPoolAllocator::blockSize(const void* ptr) const {
+    return *(const size_t*)((const uint8_t*)ptr - HEADER_SIZE);
+}
+
+bool JsonPoolAllocator::isLastBlock(const void* ptr) const {
+    return lastBlock < size && ptr == buffer + lastBlock + HEADER_SIZE;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+/**
+ * Fixed-size pool / arena for ArduinoJson documents
+ *
+ * Bump allocator over a preallocated buffer: reset() (or a JsonPoolScope
+ * going out of scope) frees everything allocated since at once. Only the
+ * most recent block can be freed or grown in place (ArduinoJson's string
+ * builder and pool shrinking do this); other frees wait for the reset.
+ *
+ * When the buffer is exhausted, allocate() returns nullptr (deserialization
+ * reports NoMemory) - or, with heapFallback, takes the block from the heap
+ * and counts it, so an undersized arena costs allocations, never content.
+ *
+ * Not thread-safe - use from one task.
+ */
+class JsonPoolAllocator : public ArduinoJson::Allocator {
+public:
+    JsonPoolAllocator(uint8_t* buffer = nullptr, size_t size = 0, bool heapFallback = false);
+
+    // Attach the backing buffer (e.g. allocated once in begin())
+    void attach(uint8_t* buffer, size_t size);
+
+    void* allocate(size_t size) override;
+    void deallocate(void* ptr) override;
+    void* reallocate(void* ptr, size_t newSize) override;
+
+    // Release all blocks (no document may still use the pool)
+    void reset();
+
+    // Nested release: everything allocated after mark() goes on rewind()
+    size_t mark() const { return offset; }
+    void rewind(size_t position);
+
+    size_t getUsed() const { return offset; }
+    size_t getCapacity() const { return size; }
+    size_t getHighWater() const { return highWater; }
+    uint32_t getFailCount() const { return failCount; }       // Out of space (incl. heap fallbacks)
+    uint32_t getFallbackCount() const { return fallbackCount; }
+
+private:
+    static const size_t ALIGNMENT = 8;
+    static const size_t HEADER_SIZE = ALIGNMENT;  // Block size, padded to alignment
+
+    uint8_t* buffer;
+    size_t size;
+    size_t offset;      // First free byte
+    size_t lastBlock;   // Header offset of the most recent block (size = none)
+    size_t highWater;
+    bool heapFallback;
+    uint32_t failCount;
+    uint32_t fallbackCount;
+
+    static size_t align(size_t n) { return (n + ALIGNMENT - 1) & ~(ALIGNMENT - 1); }
+    bool owns(const void* ptr) const;
+    size_t blockSize(const void* ptr) const;
+    bool isLastBlock(const void* ptr) const;
+    void* overflow(size_t n);
+};
+
+/**
+ * Releases everything allocated from a pool during its lifetime - declare it
+ * before the JsonDocuments that use the pool, so they are destroyed first.
+ * Scopes nest; a document from an outer scope must not grow while an inner
+ * scope is open (its new blocks would be released with the inner scope).
+ */
+class JsonPoolScope {
+public:
+    explicit JsonPoolScope(JsonPoolAllocator& pool) : pool(pool), position(pool.mark()) {}
+    ~JsonPoolScope() { pool.rewind(position); }
+
+    JsonPoolScope(const JsonPoolScope&) = delete;
+    JsonPoolScope& operator=(const JsonPoolScope&) = delete;
+
+private:
+    JsonPoolAllocator& pool;
+    size_t position;
+};
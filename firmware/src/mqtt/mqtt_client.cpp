@@ -1,27 +1,120 @@
 #include "mqtt_client.h"
 #include "config.h"
 #include "device_config.h"
+#include "payload_buffer.h"
 #include "network/connection_manager.h"
+#include "gpio/pulse_counter.h"
+#include "gpio/digital_input.h"
+#include "gpio/digital_output.h"
+#include "io/io_task.h"
+#include "io/i2c_bus.h"
+#include "network/time_service.h"
+#include "boot_profile.h"
+#include "malloc_audit.h"
 #include <ETH.h>
+#include <esp_timer.h>
+#include <mqtt_client.h>  // ESP-IDF esp_mqtt
+#include <Preferences.h>
 
 // External references
 extern DeviceConfig deviceConfig;
 extern ConnectionManager networkManager;
 extern LineStateManager lineState;
-
-// Static instance pointer for callback
-MQTTClientManager* MQTTClientManager::instance = nullptr;
+extern PulseCounterManager pulseCounter;
+extern DigitalInputManager inputs;
+extern DigitalOutputManager outputs;
+extern IOTask ioTask;
+extern I2CBusManager i2cBus;
+extern TimeService timeService;
+extern BootProfile bootProfile;
+
+// Client configuration (kept for esp_mqtt_set_config when the last will changes)
+static esp_mqtt_client_config_t clientConfig = {};
+
+// NVS namespace / key for the boot sequence number
+static const char* LIFECYCLE_NVS_NAMESPACE = "mqtt";
+static const char* LIFECYCLE_NVS_BOOT_KEY = "boot_seq";
+
+// Copy of the configured SSID (a web save may rewrite it meanwhile)
+static void copyWiFiSSID(char* buffer, size_t size) {
+    DeviceConfig::Guard guard(deviceConfig);
+    strncpy(buffer, deviceConfig.getSettings().wifiSSID, size - 1);
+    buffer[size - 1] = '\0';
+}
 
 MQTTClientManager::MQTTClientManager()
-    : mqttClient(ethClient),
+    : client(nullptr),
+      inboundQueue(nullptr),
+      connected(false),
+      reportedConnected(false),
+      started(false),
       flashCallback(nullptr),
+      connectionCallback(nullptr),
       networkManagerPtr(nullptr),
-      lastReconnectAttempt(0),
-      reconnectInterval(5000),
-      mdnsDiscovery(nullptr) {
+      mdnsDiscovery(nullptr),
+      discoveryRunning(false),
+      brokerResolved(false),
+      brokerPort(MQTT_PORT),
+      lastReplay(0),
+      droppedCommands(0),
+      commandPool(commandPoolBuffer, sizeof(commandPoolBuffer)),
+      commandCount(0),
+      rejectedCommands(0),
+      lastParseUs(0),
+      maxParseUs(0),
+      currentRequestId(nullptr),
+      currentReceivedUs(0),
+      nextRequestTag(0),
+      responseCount(0),
+      responseTimeouts(0),
+      ackedCount(0),
+      retransmitCount(0),
+      unconfirmedCount(0),
+      messageArena(nullptr, 0, true),
+      keyframePool(nullptr, 0, true),
+      statusKeyframe(&keyframePool),
+      keyframeValid(false),
+      statusSeq(0),
+      keyframeSeq(0),
+      deltasSinceKeyframe(0),
+      heartbeatInterval(HEARTBEAT_INTERVAL),
+      lastCoreValid(false),
+      lastInputs(0),
+      lastOutputs(0),
+      lastLineState(LINE_STATE_UNKNOWN),
+      lastNetworkConnected(false),
+      bootSeq(0),
+      sessionSeq(0),
+      randomState(1),
+      backoffAttempt(0),
+      lastBackoffMs(0),
+      connectAttempts(0),
+      connectCount(0),
+      restartPending(false),
+      restartAt(0),
+      connectRequested(false),
+      disconnectRequested(false),
+      stopPending(false),
+      stopAt(0),
+      announcePending(false),
+      pacingUntil(0),
+      lastPacingMs(0),
+      bytesSent(0),
+      lastPayloadBytes(0),
+      bytesThisHour(0),
+      bytesLastHour(0),
+      hourStart(0),
+      hourComplete(false) {
 
-    instance = this;
     deviceMAC[0] = '\0';
+    brokerHost[0] = '\0';
+    brokerUser[0] = '\0';
+    brokerPassword[0] = '\0';
+    willPayload[0] = '\0';
+    memset(inFlight, 0, sizeof(inFlight));
+    memset(pendingResponses, 0, sizeof(pendingResponses));
+    portMUX_INITIALIZE(&inFlightLock);
+    portMUX_INITIALIZE(&backoffLock);
 }
 
 void MQTTClientManager::begin(const char* macAddress) {
@@ -29,16 +122,96 @@ void MQTTClientManager::begin(const char* macAddress) {
     strncpy(deviceMAC, macAddress, sizeof(deviceMAC) - 1);
     deviceMAC[sizeof(deviceMAC) - 1] = '\0';
 
+    // Backoff PRNG: FNV-1a of the MAC, mixed with the boot sequence below
+    uint32_t seed = 2166136261UL;
+    for (const char* p = deviceMAC; *p; p++) {
+        seed = (seed ^ (uint8_t)*p) * 16777619UL;
+    }
+
     // Build device-specific topics
     snprintf(deviceTopicCommand, sizeof(deviceTopicCommand),
              "%s%s%s", MQTT_TOPIC_DEVICE_PREFIX, deviceMAC, MQTT_TOPIC_COMMAND_SUFFIX);
     snprintf(deviceTopicStatus, sizeof(deviceTopicStatus),
              "%s%s%s", MQTT_TOPIC_DEVICE_PREFIX, deviceMAC, MQTT_TOPIC_STATUS_SUFFIX);
+    snprintf(deviceTopicStatusDelta, sizeof(deviceTopicStatusDelta),
+             "%s%s%s", MQTT_TOPIC_DEVICE_PREFIX, deviceMAC, MQTT_TOPIC_STATUS_DELTA_SUFFIX);
+    snprintf(deviceTopicResponse, sizeof(deviceTopicResponse),
+             "%s%s%s", MQTT_TOPIC_DEVICE_PREFIX, deviceMAC, MQTT_TOPIC_RESPONSE_SUFFIX);
+    snprintf(deviceTopicLifecycle, sizeof(deviceTopicLifecycle),
+             "%s%s%s", MQTT_TOPIC_DEVICE_PREFIX, deviceMAC, MQTT_TOPIC_LIFECYCLE_SUFFIX);
+
+    // Offline event queue (reloads any backlog persisted before a reboot)
+    eventStore.begin();
+
+    // Boot sequence for birth / death ordering (one NVS write per boot)
+    Preferences prefs;
+    if (prefs.begin(LIFECYCLE_NVS_NAMESPACE, false)) {  // Read-write mode
+        bootSeq = prefs.getULong(LIFECYCLE_NVS_BOOT_KEY, 0) + 1;
+        prefs.putULong(LIFECYCLE_NVS_BOOT_KEY, bootSeq);
+        prefs.end();
+    }
+    seed ^= bootSeq * 2654435761UL;
+    randomState = (seed != 0) ? seed : 1;
+
+    inboundQueue = xQueueCreate(MQTT_INBOUND_QUEUE_LENGTH, sizeof(InboundMessage));
+
+    // JSON arena for outgoing messages and the keyframe pool - allocated once,
+    // PSRAM if present (documents fall back to the heap if either is missing)
+    uint8_t* arenaRegion = (uint8_t*)(psramFound() ? ps_malloc(MQTT_MESSAGE_ARENA_SIZE) : malloc(MQTT_MESSAGE_ARENA_SIZE));
+    uint8_t* keyframeRegion = (uint8_t*)(psramFound() ? ps_malloc(MQTT_KEYFRAME_POOL_SIZE) : malloc(MQTT_KEYFRAME_POOL_SIZE));
+    messageArena.attach(arenaRegion, MQTT_MESSAGE_ARENA_SIZE);
+    keyframePool.attach(keyframeRegion, MQTT_KEYFRAME_POOL_SIZE);
+    if (arenaRegion == nullptr || keyframeRegion == nullptr) {
+        Serial.println("✗ MQTT: JSON arena allocation failed - using heap");
+    }
 
-    // Get broker configuration from device settings
-    const DeviceConfig::Settings& settings = deviceConfig.getSettings();
-    const char* broker = nullptr;
-    uint16_t port = MQTT_PORT;
+    // Command fields the handlers read (one heap allocation, here)
+    CommandDispatcher::buildFilter(commandFilter);
+
+    commands.registerHandler(CMD_FLASH_IDENTIFY, onFlashIdentify, this);
+    commands.registerHandler(CMD_GET_STATUS, onGetStatus, this);
+    commands.registerHandler(CMD_SET_LINE_STATE, onSetLineState, this);
+
+    // Broker discovery needs the network - the client is created on first connect()
+    Serial.printf("MQTT ready (client created on first connect):\n");
+    Serial.printf("  Device ID (MAC): %s\n", deviceMAC);
+    Serial.printf("  Command topic: %s\n", deviceTopicCommand);
+    Serial.printf("  Status topic: %s\n", deviceTopicStatus);
+    Serial.printf("  Response topic: %s\n", deviceTopicResponse);
+    Serial.printf("  Lifecycle topic: %s\n", deviceTopicLifecycle);
+    Serial.printf("  Boot sequence: %lu\n", bootSeq);
+}
+
+void MQTTClientManager::discoveryTask(void* param) {
+    MQTTClientManager* self = static_cast<MQTTClientManager*>(param);
+    self->resolveBroker();
+    self->discoveryRunning = false;
+    vTaskDelete(nullptr);
+}
+
+void MQTTClientManager::startDiscovery() {
+    if (discoveryRunning) {
+        return;
+    }
+
+    // Without mDNS the configured broker is used - nothing to wait for
+    if (!deviceConfig.getSettings().mdnsEnabled) {
+        resolveBroker();
+        return;
+    }
+
+    discoveryRunning = true;
+    if (xTaskCreate(discoveryTask, "mdns", MDNS_TASK_STACK_SIZE, this, MDNS_TASK_PRIORITY, nullptr) != pdPASS) {
+        Serial.println("✗ mDNS: failed to create discovery task - using configured broker");
+        discoveryRunning = false;
+        resolveConfiguredBroker();
+    }
+}
+
+void MQTTClientManager::resolveBroker() {
+    // Get broker configuration from device settings (copy - runs in the discovery task)
+    DeviceConfig::Settings settings;
+    deviceConfig.copySettings(settings);
 
     // === mDNS DISCOVERY ===
     if (settings.mdnsEnabled) {
@@ -56,153 +229,606 @@ void MQTTClientManager::begin(const char* macAddress) {
         if (settings.mdnsCacheEnabled &&
             mdnsDiscovery->getCachedBroker(cachedIP, cachedPort)) {
             // Use cached broker
-            static String cachedIPStr;
-            cachedIPStr = cachedIP.toString();
-            broker = cachedIPStr.c_str();
-            port = cachedPort;
-            Serial.printf("Using cached broker: %s:%d\n", broker, port);
-        } else {
-            // Perform live discovery
-            Serial.println("Performing mDNS discovery...");
-            MDNSDiscovery::DiscoveryConfig config;
-            config.enabled = true;
-            config.timeoutMs = settings.mdnsTimeoutMs;
-            config.cacheResults = settings.mdnsCacheEnabled;
-            config.cacheExpiryMs = settings.mdnsCacheExpiryMs;
-            strncpy(config.serviceName, settings.mdnsServiceName, sizeof(config.serviceName) - 1);
-            config.serviceName[sizeof(config.serviceName) - 1] = '\0';
-            strncpy(config.protocol, settings.mdnsProtocol, sizeof(config.protocol) - 1);
-            config.protocol[sizeof(config.protocol) - 1] = '\0';
-
-            auto discovered = mdnsDiscovery->discoverBroker(config);
-
-            if (discovered.valid) {
-                // Use discovered broker
-                static String discoveredIPStr;
-                discoveredIPStr = discovered.ip.toString();
-                broker = discoveredIPStr.c_str();
-                port = discovered.port;
-                Serial.printf("✓ Discovered broker: %s (%s:%d)\n",
-                             discovered.hostname, broker, port);
-
-                // Cache for future use
-                if (settings.mdnsCacheEnabled) {
-                    mdnsDiscovery->cacheBroker(discovered.ip, discovered.port);
-                }
-            } else {
-                Serial.println("✗ mDNS discovery failed - falling back to configured broker");
+            ConnectionManager::formatIP(cachedIP, brokerHost, sizeof(brokerHost));
+            brokerPort = cachedPort;
+            Serial.printf("Using cached broker: %s:%d\n", brokerHost, brokerPort);
+            brokerResolved = true;
+            return;
+        }
+
+        // Perform live discovery
+        Serial.println("Performing mDNS discovery...");
+        MDNSDiscovery::DiscoveryConfig config;
+        config.enabled = true;
+        config.timeoutMs = settings.mdnsTimeoutMs;
+        config.cacheResults = settings.mdnsCacheEnabled;
+        config.cacheExpiryMs = settings.mdnsCacheExpiryMs;
+        strncpy(config.serviceName, settings.mdnsServiceName, sizeof(config.serviceName) - 1);
+        config.serviceName[sizeof(config.serviceName) - 1] = '\0';
+        strncpy(config.protocol, settings.mdnsProtocol, sizeof(config.protocol) - 1);
+        config.protocol[sizeof(config.protocol) - 1] = '\0';
+
+        auto discovered = mdnsDiscovery->discoverBroker(config);
+
+        if (discovered.valid) {
+            // Use discovered broker
+            ConnectionManager::formatIP(discovered.ip, brokerHost, sizeof(brokerHost));
+            brokerPort = discovered.port;
+            Serial.printf("✓ Discovered broker: %s (%s:%d)\n",
+                         discovered.hostname, brokerHost, brokerPort);
+
+            // Cache for future use
+            if (settings.mdnsCacheEnabled) {
+                mdnsDiscovery->cacheBroker(discovered.ip, discovered.port);
             }
+            brokerResolved = true;
+            return;
         }
+
+        Serial.println("✗ mDNS discovery failed - falling back to configured broker");
     }
 
+    resolveConfiguredBroker();
+}
+
+void MQTTClientManager::resolveConfiguredBroker() {
     // === FALLBACK CHAIN ===
     // If mDNS didn't find anything, use configured or default broker
-    if (broker == nullptr) {
-        broker = (strlen(settings.mqttBroker) > 0) ? settings.mqttBroker : MQTT_BROKER;
-        port = (settings.mqttPort > 0) ? settings.mqttPort : MQTT_PORT;
-        Serial.printf("Using configured broker: %s:%d\n", broker, port);
+    {
+        DeviceConfig::Guard guard(deviceConfig);
+        const DeviceConfig::Settings& settings = deviceConfig.getSettings();
+        const char* broker = (strlen(settings.mqttBroker) > 0) ? settings.mqttBroker : MQTT_BROKER;
+        strncpy(brokerHost, broker, sizeof(brokerHost) - 1);
+        brokerHost[sizeof(brokerHost) - 1] = '\0';
+        brokerPort = (settings.mqttPort > 0) ? settings.mqttPort : MQTT_PORT;
     }
-
-    mqttClient.setServer(broker, port);
-    mqttClient.setCallback(onMessage);
-    mqttClient.setBufferSize(MQTT_MAX_PACKET_SIZE);
-
-    Serial.printf("\nMQTT configured:\n");
-    Serial.printf("  Broker: %s:%d\n", broker, port);
-    Serial.printf("  mDNS: %s\n", settings.mdnsEnabled ? "Enabled" : "Disabled");
-    Serial.printf("  Device ID (MAC): %s\n", deviceMAC);
-    Serial.printf("  Command topic: %s\n", deviceTopicCommand);
-    Serial.printf("  Status topic: %s\n", deviceTopicStatus);
+    Serial.printf("Using configured broker: %s:%d\n", brokerHost, brokerPort);
+    brokerResolved = true;
 }
 
-bool MQTTClientManager::connect() {
-    Serial.println("Connecting to MQTT broker...");
-
-    // Get MQTT credentials from device configuration
+bool MQTTClientManager::createClient() {
+    DeviceConfig::Guard guard(deviceConfig);
     const DeviceConfig::Settings& settings = deviceConfig.getSettings();
 
     // Use MAC as client ID for uniqueness
-    // Use stored credentials if available, otherwise fall back to compiled defaults
+    // Use stored credentials if available, otherwise fall back to compiled defaults.
+    // Copied: clientConfig is re-applied by the MQTT task before every connect,
+    // and saved settings only take effect after a reboot
     const char* user = (strlen(settings.mqttUser) > 0) ? settings.mqttUser : MQTT_USER;
     const char* password = (strlen(settings.mqttPassword) > 0) ? settings.mqttPassword : MQTT_PASSWORD;
+    strncpy(brokerUser, user, sizeof(brokerUser) - 1);
+    brokerUser[sizeof(brokerUser) - 1] = '\0';
+    strncpy(brokerPassword, password, sizeof(brokerPassword) - 1);
+    brokerPassword[sizeof(brokerPassword) - 1] = '\0';
+
+    // Last will for the first session (re-registered before every connect)
+    buildLifecyclePayload(false, willPayload, sizeof(willPayload));
+
+    // esp_mqtt copies the strings at init and again on every esp_mqtt_set_config()
+    esp_mqtt_client_config_t& mqttConfig = clientConfig;
+    mqttConfig.broker.address.hostname = brokerHost;
+    mqttConfig.broker.address.port = brokerPort;
+    mqttConfig.broker.address.transport = MQTT_TRANSPORT_OVER_TCP;
+    mqttConfig.credentials.client_id = deviceMAC;
+    mqttConfig.credentials.username = (brokerUser[0] != '\0') ? brokerUser : nullptr;
+    mqttConfig.credentials.authentication.password = (brokerPassword[0] != '\0') ? brokerPassword : nullptr;
+    mqttConfig.session.keepalive = MQTT_KEEPALIVE;
+    mqttConfig.session.last_will.topic = deviceTopicLifecycle;
+    mqttConfig.session.last_will.msg = willPayload;
+    mqttConfig.session.last_will.msg_len = strlen(willPayload);
+    mqttConfig.session.last_will.qos = MQTT_QOS_LIFECYCLE;
+    mqttConfig.session.last_will.retain = 1;
+    mqttConfig.network.reconnect_timeout_ms = backoffDelay(0);  // Updated before every connect
+    mqttConfig.network.timeout_ms = MQTT_NETWORK_TIMEOUT;
+    mqttConfig.buffer.size = MQTT_MAX_PACKET_SIZE;
+    mqttConfig.task.priority = MQTT_TASK_PRIORITY;
+    mqttConfig.task.stack_size = MQTT_TASK_STACK_SIZE;
+
+    client = esp_mqtt_client_init(&mqttConfig);
+
+    if (client == nullptr || inboundQueue == nullptr) {
+        Serial.println("✗ ERROR: Failed to create MQTT client");
+        client = nullptr;
+        return false;
+    }
 
-    bool success = mqttClient.connect(
-        deviceMAC,
-        user,
-        password
-    );
+    esp_mqtt_client_register_event(client, MQTT_EVENT_ANY, onMqttEvent, this);
 
-    if (success) {
-        Serial.println("MQTT connected!");
+    Serial.printf("\nMQTT configured:\n");
+    Serial.printf("  Broker: %s:%d\n", brokerHost, brokerPort);
+    Serial.printf("  mDNS: %s\n", settings.mdnsEnabled ? "Enabled" : "Disabled");
+    return true;
+}
 
-        // Subscribe to device-specific command topic
-        if (mqttClient.subscribe(deviceTopicCommand)) {
-            Serial.printf("✓ Subscribed to: %s\n", deviceTopicCommand);
-        } else {
-            Serial.println("✗ Failed to subscribe to command topic");
+size_t MQTTClientManager::buildLifecyclePayload(bool online, char* buffer, size_t size) {
+    // Fixed set of fields - formatted straight into the caller's buffer (the
+    // last will is rebuilt in the MQTT task, which must not touch the arena)
+    int len = snprintf(buffer, size,
+                       "{\"device_id\":\"%s\",\"event\":\"%s\",\"online\":%s,\"boot_seq\":%lu,\"session_seq\":%lu",
+                       deviceMAC, online ? "birth" : "death", online ? "true" : "false",
+                       (unsigned long)bootSeq, (unsigned long)sessionSeq);
+
+    if (online && len > 0 && (size_t)len < size) {
+        char ipAddress[16];
+        ConnectionManager::formatIP(networkManager.getIP(), ipAddress, sizeof(ipAddress));
+
+        // Same timestamp fields as addTimestamp()
+        uint64_t nowUs = esp_timer_get_time();
+        uint64_t epochUs = timeService.toEpochUs(nowUs);
+        len += snprintf(buffer + len, size - len,
+                        ",\"firmware_version\":\"%s\",\"ip_address\":\"%s\"", FIRMWARE_VERSION, ipAddress);
+        if (len > 0 && (size_t)len < size) {
+            if (epochUs != 0) {
+                len += snprintf(buffer + len, size - len, ",\"timestamp\":%llu,\"epoch_us\":%llu,\"time_synced\":true",
+                                (unsigned long long)(epochUs / 1000), (unsigned long long)epochUs);
+            } else {
+                len += snprintf(buffer + len, size - len, ",\"timestamp\":%llu,\"time_synced\":false",
+                                (unsigned long long)(nowUs / 1000));
+            }
         }
+    }
 
-        // Publish device announcement
-        publishAnnouncement();
+    if (len > 0 && (size_t)len + 1 < size) {
+        buffer[len++] = '}';
+        buffer[len] = '\0';
+        return len;
+    }
+
+    buffer[0] = '\0';  // Does not fit - never publish a truncated document
+    return 0;
+}
 
+void MQTTClientManager::prepareConnect() {
+    sessionSeq++;
+    connectAttempts++;
+
+    buildLifecyclePayload(false, willPayload, sizeof(willPayload));
+    clientConfig.session.last_will.msg = willPayload;
+    clientConfig.session.last_will.msg_len = strlen(willPayload);
+
+    // esp_mqtt waits reconnect_timeout_ms after this attempt if it fails
+    lastBackoffMs = backoffDelay(backoffAttempt);
+    if (backoffAttempt < 255) {
+        backoffAttempt++;
+    }
+    clientConfig.network.reconnect_timeout_ms = lastBackoffMs;
+
+    esp_mqtt_set_config(client, &clientConfig);  // Used by the CONNECT that follows
+}
+
+bool MQTTClientManager::publishBirth() {
+    char payload[256];
+    size_t len = buildLifecyclePayload(true, payload, sizeof(payload));
+
+    bool success = len > 0 && publishRaw(deviceTopicLifecycle, payload, len, MQTT_QOS_LIFECYCLE, true) >= 0;  // Retained message
+
+    if (success) {
+        Serial.printf("Published birth: boot_seq=%lu session_seq=%lu\n", bootSeq, sessionSeq);
     } else {
-        Serial.printf("MQTT connection failed, rc=%d\n", mqttClient.state());
+        Serial.println("ERROR: Failed to publish birth message");
     }
 
     return success;
 }
 
+bool MQTTClientManager::connect() {
+    // Don't attempt MQTT in AP mode (no internet connectivity)
+    if (networkManagerPtr && networkManagerPtr->isInAPMode()) {
+        return false;
+    }
+
+    // Called from the network event task - the connect itself runs in update()
+    disconnectRequested = false;
+    connectRequested = true;
+    return true;
+}
+
+bool MQTTClientManager::startConnect() {
+    if (networkManagerPtr && networkManagerPtr->isInAPMode()) {
+        return false;
+    }
+
+    // First connect: resolve the broker (mDNS/cache/config - the live query
+    // runs in its own task), then create the client from update()
+    if (client == nullptr) {
+        if (!brokerResolved) {
+            startDiscovery();
+            if (!brokerResolved) {
+                return true;  // update() continues once discovery finished
+            }
+        }
+        if (!createClient()) {
+            return false;
+        }
+    }
+
+    // Network came back before a pending stop - keep the running client
+    if (stopPending) {
+        stopPending = false;
+        return true;
+    }
+
+    // Already running: connected, or retrying on its own backoff schedule
+    if (started || restartPending) {
+        return true;
+    }
+
+    // After an outage the whole fleet sees the network return at once -
+    // spread the restart (first connect after boot goes out immediately)
+    if (connectAttempts > 0) {
+        uint32_t delayMs = backoffDelay(0);
+        restartPending = true;
+        restartAt = millis() + delayMs;
+        Serial.printf("MQTT reconnect in %lu ms\n", delayMs);
+        return true;
+    }
+
+    return startClient();
+}
+
+bool MQTTClientManager::startClient() {
+    // Handshake and retries run in the MQTT task - this returns immediately
+    Serial.println("Connecting to MQTT broker...");
+    esp_err_t err = esp_mqtt_client_start(client);
+    started = (err == ESP_OK);
+
+    if (err != ESP_OK) {
+        Serial.printf("✗ MQTT start failed: %s\n", esp_err_to_name(err));
+    }
+
+    return started;
+}
+
+uint32_t MQTTClientManager::nextRandom() {
+    portENTER_CRITICAL(&backoffLock);
+    uint32_t x = randomState;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    randomState = x;
+    portEXIT_CRITICAL(&backoffLock);
+    return x;
+}
+
+uint32_t MQTTClientManager::backoffDelay(uint8_t attempt) {
+    // Full jitter: uniform in [MIN, min(MAX, BASE * 2^attempt)]
+    uint8_t shift = (attempt < 16) ? attempt : 16;
+    uint64_t window = (uint64_t)MQTT_BACKOFF_BASE << shift;
+    if (window > MQTT_BACKOFF_MAX) {
+        window = MQTT_BACKOFF_MAX;
+    }
+
+    uint32_t delayMs = nextRandom() % ((uint32_t)window + 1);
+    return (delayMs < MQTT_BACKOFF_MIN) ? MQTT_BACKOFF_MIN : delayMs;
+}
+
 void MQTTClientManager::disconnect() {
-    if (mqttClient.connected()) {
-        mqttClient.disconnect();
-        Serial.println("MQTT disconnected");
+    // Called from the network event task - the stop itself runs in update()
+    connectRequested = false;
+    disconnectRequested = true;
+}
+
+void MQTTClientManager::beginStop() {
+    restartPending = false;
+
+    if (client == nullptr || !started || stopPending) {
+        return;
     }
+
+    // A clean DISCONNECT suppresses the last will - hand the death message to
+    // the outbox while the broker is still reachable; update() stops the
+    // client once it is sent (or after MQTT_STOP_GRACE)
+    if (connected && networkManagerPtr != nullptr && networkManagerPtr->isConnected()) {
+        char payload[160];
+        size_t len = buildLifecyclePayload(false, payload, sizeof(payload));
+        if (len > 0 && esp_mqtt_client_enqueue(client, deviceTopicLifecycle, payload, len, MQTT_QOS_LIFECYCLE, 1, true) >= 0) {
+            stopPending = true;
+            stopAt = millis() + MQTT_STOP_GRACE;
+            return;
+        }
+    }
+
+    stopClient();
+}
+
+void MQTTClientManager::stopClient() {
+    stopPending = false;
+
+    // Stop the MQTT task so it does not keep retrying without a network
+    esp_mqtt_client_stop(client);
+    started = false;
+    connected = false;
+    Serial.println("MQTT disconnected");
+
+    // Unacknowledged events stay in the outbox (and in flight) - esp_mqtt
+    // resends them after the next start, or reports them expired
 }
 
 void MQTTClientManager::setNetworkManager(ConnectionManager* manager) {
     networkManagerPtr = manager;
 }
 
+void MQTTClientManager::setConnectionCallback(MQTTConnectionCallback callback) {
+    connectionCallback = callback;
+}
+
+void MQTTClientManager::registerCommandHandler(CommandId id, CommandHandler handler, void* context) {
+    commands.registerHandler(id, handler, context);
+}
+
 void MQTTClientManager::update() {
-    // Skip MQTT operations if in AP mode (no internet connectivity)
-    if (networkManagerPtr && networkManagerPtr->isInAPMode()) {
-        return;  // Don't attempt MQTT in AP mode
+    // Network state changes reported by the event task (see connect()/disconnect())
+    if (disconnectRequested) {
+        disconnectRequested = false;
+        beginStop();
+    }
+    if (connectRequested) {
+        connectRequested = false;
+        startConnect();
+    }
+
+    // Broker discovery finished - first connect, if the network is still up
+    if (client == nullptr && brokerResolved && !discoveryRunning &&
+        networkManagerPtr != nullptr && networkManagerPtr->isConnected()) {
+        startConnect();
     }
 
-    // Skip if not actually connected to internet
-    if (networkManagerPtr && !networkManagerPtr->isConnected()) {
-        return;  // No network connection at all
+    if (client == nullptr || inboundQueue == nullptr) {
+        return;
     }
 
-    if (!mqttClient.connected()) {
-        // Auto-reconnect logic
-        if (millis() - lastReconnectAttempt > reconnectInterval) {
-            lastReconnectAttempt = millis();
-            Serial.println("MQTT reconnecting...");
-            connect();
+    checkConnectionState();
+
+    // Delayed restart after a network outage (see connect())
+    if (restartPending && (long)(millis() - restartAt) >= 0) {
+        restartPending = false;
+        startClient();
+    }
+
+    // Deferred stop (see disconnect())
+    if (stopPending && (esp_mqtt_client_get_outbox_size(client) == 0 || (long)(millis() - stopAt) >= 0)) {
+        stopClient();
+    }
+
+    // Commands received by the MQTT task
+    InboundMessage message;
+    while (xQueueReceive(inboundQueue, &message, 0) == pdTRUE) {
+        handleCommand(message.payload, message.length, message.receivedUs);
+    }
+    expirePendingResponses();
+
+    // Events the outbox gave up on go back into the store
+    requeueInFlight();
+
+    if (connected) {
+        // Post-connect pacing: announcement first, then the backlog
+        if (announcePending) {
+            if ((long)(millis() - pacingUntil) < 0) {
+                return;
+            }
+            announcePending = false;
+            publishAnnouncement();
+        }
+
+        replayQueued();
+    }
+}
+
+void MQTTClientManager::checkConnectionState() {
+    bool nowConnected = connected;
+    if (nowConnected == reportedConnected) {
+        return;
+    }
+    reportedConnected = nowConnected;
+
+    if (nowConnected) {
+        Serial.println("MQTT connected!");
+
+        // Retained birth replaces the previous session's death message
+        publishBirth();
+
+        // Subscriber may have missed deltas - next heartbeat is a full keyframe
+        keyframeValid = false;
+        heartbeatInterval = HEARTBEAT_INTERVAL;
+
+        // Announcement and replay go out after a random offset in the pacing window
+        lastPacingMs = nextRandom() % MQTT_POST_CONNECT_WINDOW;
+        pacingUntil = millis() + lastPacingMs;
+        announcePending = true;
+
+        // Queued events are replayed from update() at EVENT_REPLAY_INTERVAL pacing
+        if (!eventStore.isEmpty()) {
+            Serial.printf("Replaying %u queued events in %lu ms\n", eventStore.size(), lastPacingMs);
+            lastReplay = 0;
         }
     } else {
-        mqttClient.loop();
+        Serial.println("MQTT connection lost - client will retry in background");
+    }
+
+    if (connectionCallback != nullptr) {
+        connectionCallback(nowConnected);
+    }
+}
+
+void MQTTClientManager::replayQueued() {
+    if (eventStore.isEmpty() || millis() - lastReplay < EVENT_REPLAY_INTERVAL) {
+        return;
+    }
+    lastReplay = millis();
+
+    // Oldest first; an event is only removed once the outbox accepted it
+    EventRecord record;
+    for (int i = 0; i < EVENT_REPLAY_BATCH && eventStore.peek(record); i++) {
+        // Wait for PUBACKs to free in-flight slots before sending more
+        if (getInFlightCount() >= MQTT_INFLIGHT_MAX) {
+            break;
+        }
+        if (!publishEvent(record, true)) {
+            break;  // Retry on next interval
+        }
+        eventStore.pop();
+    }
+    eventStore.commit();  // A reboot resumes after this batch
+
+    if (eventStore.isEmpty()) {
+        Serial.printf("✓ Event replay complete (%lu replayed, %lu dropped)\n",
+                     eventStore.getReplayedCount(), eventStore.getDroppedCount());
     }
 }
 
 bool MQTTClientManager::isConnected() {
-    return mqttClient.connected();
+    return connected;
+}
+
+int MQTTClientManager::publishRaw(const char* topic, const char* payload, size_t length, uint8_t qos, bool retain) {
+    if (client == nullptr || !connected) {
+        return -1;
+    }
+
+    // Copied into the outbox and sent by the MQTT task (store=true also for QoS 0)
+    MallocAudit::suspend();  // The outbox copy is the one allocation a publish needs
+    int msgId = esp_mqtt_client_enqueue(client, topic, payload, length, qos, retain, true);
+    MallocAudit::resume();
+    if (msgId < 0) {
+        return -1;
+    }
+
+    recordBytesSent(length);
+    return msgId;
+}
+
+void MQTTClientManager::recordBytesSent(size_t length) {
+    unsigned long now = millis();
+    if (now - hourStart >= 3600000UL) {
+        bytesLastHour = bytesThisHour;
+        bytesThisHour = 0;
+        hourStart = now;
+        hourComplete = true;
+    }
+
+    bytesSent += length;
+    bytesThisHour += length;
+}
+
+uint32_t MQTTClientManager::getBytesPerHour() const {
+    if (hourComplete) {
+        return bytesLastHour;
+    }
+
+    // First hour: extrapolate from the partial window
+    unsigned long elapsed = millis() - hourStart;
+    if (elapsed < 60000UL) {
+        return bytesThisHour;
+    }
+    return (uint32_t)((uint64_t)bytesThisHour * 3600000ULL / elapsed);
+}
+
+uint8_t MQTTClientManager::qosFor(MQTTMessageClass messageClass) const {
+    return deviceConfig.getSettings().mqttQoS[messageClass];
+}
+
+bool MQTTClientManager::trackInFlight(int msgId, const EventRecord& record) {
+    // The PUBACK cannot overtake this - the MQTT task only sends the message
+    // after enqueue returns
+    bool tracked = false;
+    portENTER_CRITICAL(&inFlightLock);
+    for (int i = 0; i < MQTT_INFLIGHT_MAX; i++) {
+        if (inFlight[i].msgId == 0) {
+            inFlight[i].msgId = msgId;
+            inFlight[i].sentAt = millis();
+            inFlight[i].expired = false;
+            inFlight[i].record = record;
+            tracked = true;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&inFlightLock);
+    return tracked;
+}
+
+void MQTTClientManager::ackInFlight(int msgId) {
+    portENTER_CRITICAL(&inFlightLock);
+    for (int i = 0; i < MQTT_INFLIGHT_MAX; i++) {
+        if (inFlight[i].msgId == msgId) {
+            inFlight[i].msgId = 0;
+            ackedCount++;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&inFlightLock);
+}
+
+void MQTTClientManager::expireInFlight(int msgId) {
+    portENTER_CRITICAL(&inFlightLock);
+    for (int i = 0; i < MQTT_INFLIGHT_MAX; i++) {
+        if (inFlight[i].msgId == msgId) {
+            inFlight[i].expired = true;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&inFlightLock);
+}
+
+void MQTTClientManager::requeueInFlight() {
+    unsigned long now = millis();
+
+    for (int i = 0; i < MQTT_INFLIGHT_MAX; i++) {
+        EventRecord record;
+        bool expired = false;
+        bool stale = false;
+
+        portENTER_CRITICAL(&inFlightLock);
+        if (inFlight[i].msgId != 0) {
+            expired = inFlight[i].expired;
+            stale = !expired && now - inFlight[i].sentAt > MQTT_ACK_TIMEOUT;
+            if (expired || stale) {
+                record = inFlight[i].record;
+                inFlight[i].msgId = 0;
+                inFlight[i].expired = false;
+            }
+        }
+        portEXIT_CRITICAL(&inFlightLock);
+
+        // The outbox no longer holds it - this is the only copy left.
+        // Same seq is kept, so the subscriber can still de-duplicate
+        if (expired) {
+            retransmitCount++;
+            eventStore.enqueue(record);
+            Serial.printf("Event #%lu expired unacknowledged - queued for retransmit\n", record.seq);
+        } else if (stale) {
+            // Still in the outbox as far as we know - resending would duplicate it
+            unconfirmedCount++;
+            Serial.printf("Event #%lu: no PUBACK after %lu ms - left to the outbox\n", record.seq, (unsigned long)MQTT_ACK_TIMEOUT);
+        }
+    }
+}
+
+uint8_t MQTTClientManager::getInFlightCount() const {
+    uint8_t count = 0;
+    for (int i = 0; i < MQTT_INFLIGHT_MAX; i++) {
+        if (inFlight[i].msgId != 0) {
+            count++;
+        }
+    }
+    return count;
 }
 
 bool MQTTClientManager::publishAnnouncement() {
-    if (!mqttClient.connected()) {
+    if (!connected) {
         return false;
     }
 
     const DeviceConfig::Settings& settings = deviceConfig.getSettings();
 
     // Create device announcement message
-    JsonDocument doc;
+    JsonPoolScope scope(messageArena);  // Documents below live in the per-message arena
+    JsonDocument doc(&messageArena);
     doc["device_id"] = deviceMAC;
     doc["device_type"] = DEVICE_TYPE;
     doc["firmware_version"] = FIRMWARE_VERSION;
-    doc["ip_address"] = networkManager.getIP().toString();
+    char ipAddress[16];
+    ConnectionManager::formatIP(networkManager.getIP(), ipAddress, sizeof(ipAddress));
+    doc["ip_address"] = ipAddress;
     doc["mac_address"] = deviceMAC;
 
     // Capabilities
@@ -211,6 +837,20 @@ bool MQTTClientManager::publishAnnouncement() {
     caps["digital_outputs"] = 8;
     caps["ethernet"] = true;
     caps["wifi"] = true;  // Device now supports WiFi
+    caps["pulse_counters"] = PulseCounterManager::MAX_COUNTERS;
+    caps["counter_channels"] = pulseCounter.getChannelMask();
+
+    // Payload encodings (status/input-change/counters; announcement is always JSON)
+    JsonArray encodings = caps["encodings"].to<JsonArray>();
+    encodings.add("json");
+    encodings.add("msgpack");
+    caps["payload_format"] = DeviceConfig::payloadFormatToString(settings.payloadFormat);
+
+    // Delivery guarantee per message class
+    JsonObject qos = caps["qos"].to<JsonObject>();
+    for (int i = 0; i < MQTT_CLASS_COUNT; i++) {
+        qos[DeviceConfig::messageClassToString((MQTTMessageClass)i)] = settings.mqttQoS[i];
+    }
 
     // Connection information
     JsonObject conn = doc["connection"].to<JsonObject>();
@@ -219,7 +859,9 @@ bool MQTTClientManager::publishAnnouncement() {
 
     if (networkManager.getActiveInterface() == ConnectionManager::INTERFACE_WIFI) {
         WiFiManager* wifi = networkManager.getWiFiManager();
-        conn["wifi_ssid"] = settings.wifiSSID;
+        char ssid[sizeof(settings.wifiSSID)];
+        copyWiFiSSID(ssid, sizeof(ssid));
+        conn["wifi_ssid"] = ssid;
         conn["wifi_rssi"] = networkManager.getRSSI();
         conn["ap_mode"] = (wifi && wifi->getMode() == WiFiManager::MODE_AP);
     }
@@ -234,12 +876,27 @@ bool MQTTClientManager::publishAnnouncement() {
         status["rssi"] = nullptr;
     }
 
-    doc["timestamp"] = millis();
+    // Broker connect statistics (backoff / pacing)
+    JsonObject mqttStats = doc["mqtt"].to<JsonObject>();
+    mqttStats["connect_attempts"] = (uint32_t)connectAttempts;
+    mqttStats["connects"] = (uint32_t)connectCount;
+    mqttStats["failed_attempts"] = (uint32_t)(connectAttempts - connectCount);
+    mqttStats["backoff_ms"] = (uint32_t)lastBackoffMs;
+    mqttStats["pacing_ms"] = lastPacingMs;
+    mqttStats["boot_seq"] = bootSeq;
+    mqttStats["session_seq"] = (uint32_t)sessionSeq;
+
+    // Boot phase timings (ms since app start)
+    JsonObject boot = doc["boot"].to<JsonObject>();
+    for (uint8_t i = 0; i < bootProfile.getPhaseCount(); i++) {
+        boot[bootProfile.getPhaseName(i)] = bootProfile.getPhaseMs(i);
+    }
 
-    char buffer[MQTT_MAX_PACKET_SIZE];
-    size_t len = serializeJson(doc, buffer);
+    uint64_t nowUs = esp_timer_get_time();
+    addTimestamp(doc, timeService.toEpochUs(nowUs), nowUs);
 
-    bool success = mqttClient.publish(MQTT_TOPIC_ANNOUNCE, (const uint8_t*)buffer, len, true);  // Retained message
+    // Always JSON (read by discovery tools), retained
+    bool success = publishDocument(MQTT_TOPIC_ANNOUNCE, doc, qosFor(MQTT_CLASS_ANNOUNCE), true, false) >= 0;
 
     if (success) {
         Serial.printf("Published device announcement to: %s\n", MQTT_TOPIC_ANNOUNCE);
@@ -251,38 +908,94 @@ bool MQTTClientManager::publishAnnouncement() {
 }
 
 bool MQTTClientManager::publishStatus(uint8_t inputs, uint8_t outputs, bool networkConnected, LineState lineState) {
-    if (!mqttClient.connected()) {
+    if (!connected) {
         return false;
     }
 
     const DeviceConfig::Settings& settings = deviceConfig.getSettings();
 
-    // Create JSON status message
-    JsonDocument doc;
+    // Device state - the part deltas are computed on (timestamp is added per
+    // message below)
+    JsonPoolScope scope(messageArena);  // Documents below live in the per-message arena
+    JsonDocument doc(&messageArena);
     doc["device_id"] = deviceMAC;
+    doc["boot_seq"] = bootSeq;
+    doc["session_seq"] = sessionSeq;
     doc["line_state"] = LineStateManager::stateToString(lineState);
     doc["digital_inputs"] = inputs;
     doc["digital_outputs"] = outputs;
     doc["network_connected"] = networkConnected;
     doc["connection_type"] = networkManager.getActiveInterface() == ConnectionManager::INTERFACE_WIFI ? "wifi" : "ethernet";
-
-    // Add WiFi-specific information
     if (networkManager.getActiveInterface() == ConnectionManager::INTERFACE_WIFI) {
-        doc["wifi_rssi"] = networkManager.getRSSI();
-        doc["wifi_ssid"] = settings.wifiSSID;
+        char ssid[sizeof(settings.wifiSSID)];
+        copyWiFiSSID(ssid, sizeof(ssid));
+        doc["wifi_ssid"] = ssid;  // Char array - copied into the document
     }
-
     doc["assigned_line"] = nullptr;  // API will translate via assignment table
-    doc["timestamp"] = millis();
 
-    char buffer[MQTT_MAX_PACKET_SIZE];
-    size_t len = serializeJson(doc, buffer);
+    // Keyframe: full state plus diagnostics on the status topic. Delta: only
+    // the state fields that differ from the last keyframe, on status-delta
+    bool keyframe = !keyframeValid || deltasSinceKeyframe + 1 >= STATUS_KEYFRAME_EVERY;
+    JsonDocument message(&messageArena);
+    if (keyframe) {
+        message.set(doc);
+        addDiagnostics(message);
+    } else {
+        diffObject(doc.as<JsonObjectConst>(), statusKeyframe.as<JsonObjectConst>(), message.to<JsonObject>());
+        message["device_id"] = deviceMAC;
+    }
+
+    // Counters and sync quality on every heartbeat, deltas included - they
+    // change all the time, so they are never part of the diff
+    addStatusMetrics(message);
+
+    message["status_seq"] = statusSeq + 1;
+    message["keyframe"] = keyframe;
+    if (!keyframe) {
+        message["keyframe_seq"] = keyframeSeq;
+    }
+
+    uint64_t nowUs = esp_timer_get_time();
+    addTimestamp(message, timeService.toEpochUs(nowUs), nowUs);
 
-    bool success = mqttClient.publish(deviceTopicStatus, buffer, len);
+    int msgId = publishDocument(keyframe ? deviceTopicStatus : deviceTopicStatusDelta, message, qosFor(MQTT_CLASS_STATUS));
+    bool success = msgId >= 0;
 
     if (success) {
-        Serial.printf("Published status: line_state=%s inputs=0x%02X outputs=0x%02X\n",
-                     LineStateManager::stateToString(lineState), inputs, outputs);
+        statusSeq++;
+        if (keyframe) {
+            // Fixed pool, reused by every keyframe
+            statusKeyframe.clear();
+            keyframePool.reset();
+            statusKeyframe.set(doc);
+            keyframeValid = true;
+            keyframeSeq = statusSeq;
+            deltasSinceKeyframe = 0;
+        } else {
+            deltasSinceKeyframe++;
+        }
+
+        // Stretch the interval while nothing that matters changes
+        bool stable = lastCoreValid &&
+                      inputs == lastInputs &&
+                      outputs == lastOutputs &&
+                      lineState == lastLineState &&
+                      networkConnected == lastNetworkConnected;
+        if (stable) {
+            heartbeatInterval = min((uint32_t)(heartbeatInterval * 2), (uint32_t)HEARTBEAT_INTERVAL_MAX);
+        } else {
+            heartbeatInterval = HEARTBEAT_INTERVAL;
+        }
+        lastCoreValid = true;
+        lastInputs = inputs;
+        lastOutputs = outputs;
+        lastLineState = lineState;
+        lastNetworkConnected = networkConnected;
+
+        Serial.printf("Published status %s: line_state=%s inputs=0x%02X outputs=0x%02X (%u bytes, next in %lus)\n",
+                     keyframe ? "keyframe" : "delta",
+                     LineStateManager::stateToString(lineState), inputs, outputs,
+                     (unsigned)lastPayloadBytes, heartbeatInterval / 1000);
     } else {
         Serial.println("ERROR: Failed to publish status");
     }
@@ -290,113 +1003,638 @@ bool MQTTClientManager::publishStatus(uint8_t inputs, uint8_t outputs, bool netw
     return success;
 }
 
-bool MQTTClientManager::publishInputChange(uint8_t channel, bool state, uint8_t allInputs) {
-    if (!mqttClient.connected()) {
+void MQTTClientManager::addDiagnostics(JsonDocument& doc) {
+    // Signal strength changes on every sample - reported with diagnostics
+    if (networkManager.getActiveInterface() == ConnectionManager::INTERFACE_WIFI) {
+        doc["wifi_rssi"] = networkManager.getRSSI();
+    }
+
+    // I/O task timing (cycle budget + worst-case input-to-tower-light latency)
+    JsonObject io = doc["io_task"].to<JsonObject>();
+    io["period_us"] = ioTask.getPeriodUs();
+    io["max_cycle_us"] = ioTask.getMaxCycleUs();
+    io["overruns"] = ioTask.getOverruns();
+    io["latency_last_us"] = ioTask.getLastLatencyUs();
+    io["latency_max_us"] = ioTask.getMaxLatencyUs();
+    io["dropped_events"] = ioTask.getDroppedEvents();
+    io["output_changes"] = ::outputs.getChangeCount();
+    io["output_writes"] = ::outputs.getTransactionCount();
+
+    // Shared I2C bus (per-device submit -> complete latency)
+    JsonObject i2c = doc["i2c"].to<JsonObject>();
+    i2c["freq_hz"] = i2cBus.getFrequency();
+    JsonArray i2cDevices = i2c["devices"].to<JsonArray>();
+    for (uint8_t i = 0; i < i2cBus.getDeviceCount(); i++) {
+        const I2CDeviceStats& stats = i2cBus.getDeviceStats(i);
+        JsonObject device = i2cDevices.add<JsonObject>();
+        device["name"] = stats.name;
+        device["transfers"] = stats.transfers;
+        device["errors"] = stats.errors;
+        device["dropped"] = stats.dropped;
+        device["latency_avg_us"] = stats.transfers > 0 ? (uint32_t)(stats.totalLatencyUs / stats.transfers) : 0;
+        device["latency_max_us"] = stats.maxLatencyUs;
+    }
+
+    // Offline event queue
+    JsonObject store = doc["event_store"].to<JsonObject>();
+    store["pending"] = eventStore.size();
+    store["queued"] = eventStore.getQueuedCount();
+    store["dropped"] = eventStore.getDroppedCount();
+    store["replayed"] = eventStore.getReplayedCount();
+
+    // QoS delivery
+    JsonObject delivery = doc["delivery"].to<JsonObject>();
+    delivery["inflight"] = getInFlightCount();
+    delivery["acked"] = ackedCount;
+    delivery["retransmits"] = retransmitCount;
+    delivery["unconfirmed"] = unconfirmedCount;
+    delivery["bytes_sent"] = bytesSent;
+    delivery["bytes_per_hour"] = getBytesPerHour();
+    delivery["heartbeat_s"] = heartbeatInterval / 1000;
+
+    // Inbound commands
+    JsonObject commandStats = doc["commands"].to<JsonObject>();
+    commandStats["received"] = commandCount;
+    commandStats["rejected"] = rejectedCommands;
+    commandStats["dropped"] = droppedCommands;
+    commandStats["parse_us_max"] = maxParseUs;
+    commandStats["pool_failures"] = commandPool.getFailCount();
+    commandStats["responses"] = responseCount;
+    commandStats["response_timeouts"] = responseTimeouts;
+
+    // JSON memory (high-water marks show how close the fixed regions run)
+    JsonObject jsonMemory = doc["json_memory"].to<JsonObject>();
+    jsonMemory["arena_size"] = messageArena.getCapacity();
+    jsonMemory["arena_high_water"] = messageArena.getHighWater();
+    jsonMemory["arena_fallbacks"] = messageArena.getFallbackCount();
+    jsonMemory["keyframe_high_water"] = keyframePool.getHighWater();
+    jsonMemory["keyframe_fallbacks"] = keyframePool.getFallbackCount();
+    jsonMemory["command_high_water"] = commandPool.getHighWater();
+    if (MallocAudit::isEnabled()) {
+        jsonMemory["loop_malloc_violations"] = MallocAudit::getViolations();
+        jsonMemory["loop_malloc_last"] = MallocAudit::getLastViolationAllocs();
+    }
+}
+
+void MQTTClientManager::addStatusMetrics(JsonDocument& doc) {
+    // Pulse counter totals/rates (only when counter mode is in use)
+    if (pulseCounter.getChannelMask() != 0) {
+        addCounters(doc["counters"].to<JsonObject>());
+    }
+
+    // Clock sync quality
+    JsonObject time = doc["time"].to<JsonObject>();
+    time["synced"] = timeService.isSynced();
+    if (timeService.isSynced()) {
+        time["offset_us"] = timeService.getLastOffsetUs();
+        time["drift_ppm"] = roundf(timeService.getDriftPPM() * 100.0f) / 100.0f;
+        time["sync_age_s"] = timeService.getLastSyncAgeMs() / 1000;
+    }
+}
+
+bool MQTTClientManager::diffObject(JsonObjectConst current, JsonObjectConst base, JsonObject out) {
+    bool changed = false;
+
+    for (JsonPairConst field : current) {
+        JsonVariantConst value = field.value();
+        JsonVariantConst previous = base[field.key()];
+
+        if (value == previous) {
+            continue;
+        }
+
+        if (value.is<JsonObjectConst>() && previous.is<JsonObjectConst>()) {
+            JsonObject nested = out[field.key()].to<JsonObject>();
+            diffObject(value.as<JsonObjectConst>(), previous.as<JsonObjectConst>(), nested);
+        } else {
+            out[field.key()] = value;
+        }
+        changed = true;
+    }
+
+    // Fields that disappeared (e.g. wifi_rssi after switching to Ethernet)
+    for (JsonPairConst field : base) {
+        if (current[field.key()].isNull() && !field.value().isNull()) {
+            out[field.key()] = nullptr;
+            changed = true;
+        }
+    }
+
+    return changed;
+}
+
+bool MQTTClientManager::publishInputChange(uint8_t channel, bool state, uint8_t allInputs, uint64_t edgeTimeUs) {
+    EventRecord record = {};
+    record.seq = eventStore.nextSeq();
+    record.type = EventRecord::EVENT_INPUT_CHANGE;
+    record.channel = channel;
+    record.state = state;
+    record.inputs = allInputs;
+
+    // Stamp with the captured edge time, not the (later) publish time
+    record.timestampUs = (edgeTimeUs != 0) ? edgeTimeUs : esp_timer_get_time();
+    record.epochUs = timeService.toEpochUs(record.timestampUs);
+
+    return publishOrQueue(record);
+}
+
+bool MQTTClientManager::publishLineStateChange(uint8_t inputs, uint8_t outputs, LineState lineState, uint64_t timestampUs) {
+    EventRecord record = {};
+    record.seq = eventStore.nextSeq();
+    record.type = EventRecord::EVENT_LINE_STATE;
+    record.lineState = lineState;
+    record.inputs = inputs;
+    record.outputs = outputs;
+    record.timestampUs = (timestampUs != 0) ? timestampUs : esp_timer_get_time();
+    record.epochUs = timeService.toEpochUs(record.timestampUs);
+
+    return publishOrQueue(record);
+}
+
+bool MQTTClientManager::publishOrQueue(const EventRecord& record) {
+    // Publish directly only when nothing older is still waiting, so the
+    // subscriber always sees events in seq order
+    if (connected && eventStore.isEmpty() && publishEvent(record, false)) {
+        return true;
+    }
+
+    if (eventStore.enqueue(record)) {
+        Serial.printf("Event #%lu queued for replay (%u pending)\n", record.seq, eventStore.size());
+    } else {
+        Serial.printf("✗ Event store full - event #%lu dropped\n", record.seq);
+    }
+
+    return false;
+}
+
+bool MQTTClientManager::publishEvent(const EventRecord& record, bool replayed) {
+    uint8_t qos = qosFor(record.type == EventRecord::EVENT_INPUT_CHANGE ? MQTT_CLASS_INPUT : MQTT_CLASS_LINE_STATE);
+
+    // Back-pressure: leave the event queued until acknowledgements free a slot
+    if (qos > 0 && getInFlightCount() >= MQTT_INFLIGHT_MAX) {
         return false;
     }
 
-    // Create JSON input change event
+    // Replayed events are history - they go to devices/{MAC}/events, never to
+    // the status topic, where a stale line_state would override the current one
     char topicBuffer[80];
-    snprintf(topicBuffer, sizeof(topicBuffer),
-             "%s%s%s", MQTT_TOPIC_DEVICE_PREFIX, deviceMAC, MQTT_TOPIC_INPUT_SUFFIX);
+    bool inputChange = record.type == EventRecord::EVENT_INPUT_CHANGE;
+    const char* suffix = replayed ? MQTT_TOPIC_EVENTS_SUFFIX : (inputChange ? MQTT_TOPIC_INPUT_SUFFIX : MQTT_TOPIC_STATUS_SUFFIX);
+    snprintf(topicBuffer, sizeof(topicBuffer), "%s%s%s", MQTT_TOPIC_DEVICE_PREFIX, deviceMAC, suffix);
 
-    JsonDocument doc;
+    JsonPoolScope scope(messageArena);  // Documents below live in the per-message arena
+    JsonDocument doc(&messageArena);
     doc["device_id"] = deviceMAC;
-    doc["channel"] = channel;
-    doc["state"] = state;
-    doc["all_inputs"] = allInputs;
-    doc["timestamp"] = millis();
+    doc["seq"] = record.seq;
+    if (replayed) {
+        doc["event"] = inputChange ? "input_change" : "line_state";
+    }
 
-    char buffer[256];
-    size_t len = serializeJson(doc, buffer);
+    if (inputChange) {
+        doc["channel"] = record.channel;
+        doc["state"] = record.state != 0;
+        doc["all_inputs"] = record.inputs;
+    } else {
+        doc["line_state"] = LineStateManager::stateToString((LineState)record.lineState);
+        doc["digital_inputs"] = record.inputs;
+        doc["digital_outputs"] = record.outputs;
+        if (!replayed) {
+            doc["network_connected"] = true;  // Published live, so the network is up
+            doc["assigned_line"] = nullptr;   // API will translate via assignment table
+        }
+    }
 
-    bool success = mqttClient.publish(topicBuffer, buffer, len);
+    // Epoch capture time - if the clock synced only after the event was queued,
+    // the same-boot esp_timer value can still be converted now
+    uint64_t epochUs = record.epochUs;
+    if (epochUs == 0 && !(record.flags & EventRecord::FLAG_PREV_BOOT)) {
+        epochUs = timeService.toEpochUs(record.timestampUs);
+    }
+    addTimestamp(doc, epochUs, record.timestampUs);
+    doc["timestamp_us"] = record.timestampUs;       // esp_timer capture time (us since boot)
 
-    if (success) {
-        Serial.printf("Published input change: CH%d=%s\n", channel + 1, state ? "HIGH" : "LOW");
+    if (replayed) {
+        doc["replayed"] = true;
+    }
+    if (record.flags & EventRecord::FLAG_PREV_BOOT) {
+        doc["prev_boot"] = true;  // Timestamp is relative to an earlier boot
+    }
+
+    int msgId = publishDocument(topicBuffer, doc, qos);
+    bool success = msgId >= 0;
+
+    if (success && qos > 0) {
+        trackInFlight(msgId, record);
+    }
+
+    if (success && inputChange) {
+        Serial.printf("Published input change: CH%d=%s%s\n", record.channel + 1,
+                     record.state ? "HIGH" : "LOW", replayed ? " (replayed)" : "");
+    } else if (success) {
+        Serial.printf("Published line state change: %s%s\n",
+                     LineStateManager::stateToString((LineState)record.lineState),
+                     replayed ? " (replayed)" : "");
     }
 
     return success;
 }
 
+bool MQTTClientManager::publishCounters() {
+    if (!connected || pulseCounter.getChannelMask() == 0) {
+        return false;
+    }
+
+    char topicBuffer[80];
+    snprintf(topicBuffer, sizeof(topicBuffer),
+             "%s%s%s", MQTT_TOPIC_DEVICE_PREFIX, deviceMAC, MQTT_TOPIC_COUNTER_SUFFIX);
+
+    JsonPoolScope scope(messageArena);  // Documents below live in the per-message arena
+    JsonDocument doc(&messageArena);
+    doc["device_id"] = deviceMAC;
+    addCounters(doc.as<JsonObject>());
+
+    uint64_t nowUs = esp_timer_get_time();
+    addTimestamp(doc, timeService.toEpochUs(nowUs), nowUs);
+
+    return publishDocument(topicBuffer, doc, qosFor(MQTT_CLASS_COUNTERS)) >= 0;
+}
+
+void MQTTClientManager::addTimestamp(JsonDocument& doc, uint64_t epochUs, uint64_t timerUs) {
+    if (epochUs != 0) {
+        doc["timestamp"] = epochUs / 1000;      // Unix epoch ms
+        doc["epoch_us"] = epochUs;
+        doc["time_synced"] = true;
+    } else {
+        doc["timestamp"] = timerUs / 1000;      // Not synced yet: ms since boot
+        doc["time_synced"] = false;
+    }
+}
+
+int MQTTClientManager::publishDocument(const char* topic, JsonDocument& doc, uint8_t qos, bool retain, bool compact) {
+    if (client == nullptr || !connected) {
+        return -1;
+    }
+
+    // MessagePack keeps device_id - the API looks devices up by it
+    bool msgpack = compact && deviceConfig.getSettings().payloadFormat == PAYLOAD_MSGPACK;
+
+    // The outbox takes its own copy of the payload
+    PayloadBuffer payload(messageArena);
+    switch (payload.serialize(doc, msgpack)) {
+        case PayloadBuffer::PAYLOAD_TOO_LARGE:
+            Serial.printf("✗ Payload for %s too large (%u bytes) - not published\n", topic, (unsigned)payload.measured());
+            return -1;
+        case PayloadBuffer::PAYLOAD_NO_MEMORY:
+            Serial.printf("✗ No memory for %u byte payload on %s\n", (unsigned)payload.measured(), topic);
+            return -1;
+        default:
+            break;
+    }
+
+    lastPayloadBytes = payload.length();
+    return publishRaw(topic, payload.data(), payload.length(), qos, retain);
+}
+
+void MQTTClientManager::addCounters(JsonObject obj) {
+    // Parallel arrays keep the message compact: ch[i] has total[i] parts at ppm[i]
+    JsonArray channels = obj["ch"].to<JsonArray>();
+    JsonArray totals = obj["total"].to<JsonArray>();
+    JsonArray rates = obj["ppm"].to<JsonArray>();
+
+    uint8_t mask = pulseCounter.getChannelMask();
+    for (uint8_t ch = 0; ch < 8; ch++) {
+        if (mask & (1 << ch)) {
+            channels.add(ch);
+            totals.add(pulseCounter.getTotal(ch));
+            rates.add(roundf(pulseCounter.getRatePPM(ch) * 10.0f) / 10.0f);  // 0.1 ppm resolution
+        }
+    }
+}
+
 void MQTTClientManager::setFlashCallback(MQTTFlashCallback callback) {
     flashCallback = callback;
 }
 
-void MQTTClientManager::onMessage(char* topic, byte* payload, unsigned int length) {
-    Serial.printf("MQTT message received on topic: %s\n", topic);
+void MQTTClientManager::onMqttEvent(void* handlerArgs, const char* base, int32_t eventId, void* eventData) {
+    static_cast<MQTTClientManager*>(handlerArgs)->handleEvent(eventId, eventData);
+}
+
+void MQTTClientManager::handleEvent(int32_t eventId, void* eventData) {
+    // Runs in the MQTT task - only flags and queues here, work is done in update()
+    esp_mqtt_event_handle_t event = static_cast<esp_mqtt_event_handle_t>(eventData);
+
+    switch ((esp_mqtt_event_id_t)eventId) {
+        case MQTT_EVENT_BEFORE_CONNECT:
+            // New session: last will must carry its session_seq, next delay backs off
+            prepareConnect();
+            break;
+
+        case MQTT_EVENT_CONNECTED:
+            // Subscribe from the MQTT task so it is in place before any command arrives
+            if (esp_mqtt_client_subscribe(client, deviceTopicCommand, 0) >= 0) {
+                Serial.printf("✓ Subscribed to: %s\n", deviceTopicCommand);
+            } else {
+                Serial.println("✗ Failed to subscribe to command topic");
+            }
+
+            // Backoff starts over; a later connection loss retries within the base window
+            backoffAttempt = 0;
+            connectCount++;
+            lastBackoffMs = backoffDelay(0);
+            clientConfig.network.reconnect_timeout_ms = lastBackoffMs;
+            esp_mqtt_set_config(client, &clientConfig);
+
+            connected = true;
+            break;
+
+        case MQTT_EVENT_DISCONNECTED:
+            connected = false;
+            break;
+
+        case MQTT_EVENT_PUBLISHED:
+            // PUBACK (QoS 1) / PUBCOMP (QoS 2)
+            ackInFlight(event->msg_id);
+            break;
+
+        case MQTT_EVENT_DELETED:
+            // Outbox expiry dropped an unacknowledged message
+            expireInFlight(event->msg_id);
+            break;
+
+        case MQTT_EVENT_ERROR:
+            if (event->error_handle != nullptr &&
+                event->error_handle->error_type == MQTT_ERROR_TYPE_CONNECTION_REFUSED) {
+                Serial.printf("MQTT connection refused, code=%d\n",
+                             event->error_handle->connect_return_code);
+            }
+            break;
+
+        case MQTT_EVENT_DATA: {
+            Serial.printf("MQTT message received on topic: %.*s\n", event->topic_len, event->topic);
+
+            // Commands are small - ignore fragmented or oversized payloads
+            if (event->data_len != event->total_data_len ||
+                event->data_len >= MQTT_COMMAND_MAX_LENGTH) {
+                Serial.printf("✗ Command too large (%d bytes) - ignored\n", event->total_data_len);
+                break;
+            }
+
+            // Null-terminate payload
+            InboundMessage message;
+            message.length = event->data_len;
+            message.receivedUs = esp_timer_get_time();
+            memcpy(message.payload, event->data, event->data_len);
+            message.payload[event->data_len] = '\0';
 
-    // Null-terminate payload
-    char message[length + 1];
-    memcpy(message, payload, length);
-    message[length] = '\0';
+            Serial.printf("Payload: %s\n", message.payload);
 
-    Serial.printf("Payload: %s\n", message);
+            if (xQueueSend(inboundQueue, &message, 0) != pdTRUE) {
+                droppedCommands++;
+                Serial.println("✗ Command queue full - command dropped");
+            }
+            break;
+        }
 
-    if (instance != nullptr) {
-        instance->handleCommand(message);
+        default:
+            break;
     }
 }
 
-void MQTTClientManager::handleCommand(const char* payload) {
-    // Parse JSON command
-    JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, payload);
+void MQTTClientManager::handleCommand(const char* payload, size_t length, int64_t receivedUs) {
+    // Parse straight from the inbound message into the fixed pool, keeping
+    // only the fields the handlers read
+    int64_t startUs = esp_timer_get_time();
+    commandPool.reset();
+    JsonDocument doc(&commandPool);
+    DeserializationError error = deserializeJson(doc, payload, length,
+                                                 DeserializationOption::Filter(commandFilter));
+
+    lastParseUs = (uint32_t)(esp_timer_get_time() - startUs);
+    if (lastParseUs > maxParseUs) {
+        maxParseUs = lastParseUs;
+    }
+    commandCount++;
 
     if (error) {
+        rejectedCommands++;
         Serial.printf("JSON parse error: %s\n", error.c_str());
         return;
     }
 
-    // Extract command fields
     const char* command = doc["command"] | "";
+    Serial.printf("Received command: %s (parsed in %lu us)\n", command, lastParseUs);
 
-    Serial.printf("Received command: %s\n", command);
+    // Commands with a request_id get a response on devices/{MAC}/response
+    currentRequestId = doc["request_id"];
+    currentReceivedUs = receivedUs;
 
-    // Handle flash_identify command
-    if (strcmp(command, "flash_identify") == 0) {
-        uint16_t duration = doc["duration"] | 10;
-        Serial.printf("Flash identify command: %d seconds\n", duration);
+    JsonPoolScope scope(messageArena);
+    JsonDocument response(&messageArena);
+    JsonObject result = response.to<JsonObject>();
+    CommandResult outcome = commands.dispatch(command, doc.as<JsonObjectConst>(), result);
 
-        if (flashCallback != nullptr) {
-            flashCallback();
-        }
-        return;
+    if (outcome == CMD_RESULT_UNKNOWN) {
+        rejectedCommands++;
+        result["error"] = "unknown_command";
+        Serial.printf("Unknown command: %s\n", command);
     }
 
-    // Handle get_status command
-    if (strcmp(command, "get_status") == 0) {
-        Serial.println("Get status command - publishing current status");
-        // Status will be published in main loop's next heartbeat
-        return;
+    if (outcome != CMD_RESULT_PENDING) {
+        publishResponse(currentRequestId, CommandDispatcher::lookup(command), outcome,
+                        result, receivedUs);
     }
+    currentRequestId = nullptr;
+}
 
-    // Handle set_line_state command (from API)
-    if (strcmp(command, "set_line_state") == 0) {
-        const char* stateStr = doc["state"] | "";
+bool MQTTClientManager::publishResponse(const char* requestId, CommandId command, CommandResult outcome,
+                                        JsonObjectConst result, int64_t receivedUs) {
+    if (requestId == nullptr || requestId[0] == '\0') {
+        return false;
+    }
 
-        Serial.printf("Set line state command: %s\n", stateStr);
+    JsonPoolScope scope(messageArena);
+    JsonDocument doc(&messageArena);
+    doc["device_id"] = deviceMAC;
+    doc["request_id"] = requestId;
+    doc["command"] = CommandDispatcher::nameOf(command);
+    doc["ok"] = (outcome == CMD_RESULT_OK);
+    doc["result"] = result;
+    doc["latency_us"] = (uint32_t)(esp_timer_get_time() - receivedUs);  // Arrival -> response
 
-        // Parse state string to enum
-        LineState newState = LINE_STATE_UNKNOWN;
-        if (strcmp(stateStr, "ON") == 0) {
-            newState = LINE_STATE_ON;
-        } else if (strcmp(stateStr, "OFF") == 0) {
-            newState = LINE_STATE_OFF;
-        } else if (strcmp(stateStr, "MAINTENANCE") == 0) {
-            newState = LINE_STATE_MAINTENANCE;
-        } else if (strcmp(stateStr, "ERROR") == 0) {
-            newState = LINE_STATE_ERROR;
-        } else {
-            Serial.printf("Invalid state: %s\n", stateStr);
-            return;
+    uint64_t nowUs = esp_timer_get_time();
+    addTimestamp(doc, timeService.toEpochUs(nowUs), nowUs);
+
+    bool success = publishDocument(deviceTopicResponse, doc, MQTT_QOS_RESPONSE) >= 0;
+    if (success) {
+        responseCount++;
+    } else {
+        Serial.printf("✗ Failed to publish response for request %s\n", requestId);
+    }
+    return success;
+}
+
+uint16_t MQTTClientManager::deferResponse(CommandId command) {
+    if (currentRequestId == nullptr || currentRequestId[0] == '\0') {
+        return 0;
+    }
+
+    for (uint8_t i = 0; i < MQTT_PENDING_RESPONSES; i++) {
+        PendingResponse& pending = pendingResponses[i];
+        if (pending.tag != 0) {
+            continue;
+        }
+
+        // Tags wrap but skip 0 (= no response wanted)
+        if (++nextRequestTag == 0) {
+            nextRequestTag = 1;
         }
 
-        // Update line state (will trigger callback which publishes status)
-        lineState.setState(newState, "mqtt");
+        pending.tag = nextRequestTag;
+        pending.command = command;
+        pending.receivedUs = currentReceivedUs;
+        pending.deadline = millis() + MQTT_RESPONSE_TIMEOUT;
+        strncpy(pending.requestId, currentRequestId, sizeof(pending.requestId) - 1);
+        pending.requestId[sizeof(pending.requestId) - 1] = '\0';
+        return pending.tag;
+    }
+
+    return 0;
+}
+
+void MQTTClientManager::completeCommand(uint16_t requestTag, LineState oldState, LineState newState, uint64_t appliedUs) {
+    for (uint8_t i = 0; i < MQTT_PENDING_RESPONSES; i++) {
+        PendingResponse& pending = pendingResponses[i];
+        if (pending.tag != requestTag || requestTag == 0) {
+            continue;
+        }
 
+        JsonPoolScope scope(messageArena);
+        JsonDocument doc(&messageArena);
+        JsonObject result = doc.to<JsonObject>();
+        result["previous_state"] = LineStateManager::stateToString(oldState);
+        result["state"] = LineStateManager::stateToString(newState);
+        result["apply_latency_us"] = (uint32_t)((int64_t)appliedUs - pending.receivedUs);  // Arrival -> applied
+
+        // The state machine may refuse a transition - report what was applied
+        result["changed"] = (newState != oldState);
+
+        publishResponse(pending.requestId, pending.command, CMD_RESULT_OK, result, pending.receivedUs);
+        pending.tag = 0;
         return;
     }
+}
+
+void MQTTClientManager::expirePendingResponses() {
+    unsigned long now = millis();
+
+    for (uint8_t i = 0; i < MQTT_PENDING_RESPONSES; i++) {
+        PendingResponse& pending = pendingResponses[i];
+        if (pending.tag == 0 || (long)(now - pending.deadline) < 0) {
+            continue;
+        }
+
+        JsonPoolScope scope(messageArena);
+        JsonDocument doc(&messageArena);
+        JsonObject result = doc.to<JsonObject>();
+        result["error"] = "timeout";
+
+        publishResponse(pending.requestId, pending.command, CMD_RESULT_ERROR, result, pending.receivedUs);
+        pending.tag = 0;
+        responseTimeouts++;
+    }
+}
+
+CommandResult MQTTClientManager::onFlashIdentify(void* context, JsonObjectConst command, JsonObject result) {
+    MQTTClientManager* self = static_cast<MQTTClientManager*>(context);
+
+    // Report the duration actually used (0 / missing = default, clamped)
+    uint32_t duration = command["duration"] | (uint32_t)IDENTIFY_DEFAULT_DURATION;
+    if (duration == 0) {
+        duration = IDENTIFY_DEFAULT_DURATION;
+    } else if (duration > IDENTIFY_MAX_DURATION) {
+        duration = IDENTIFY_MAX_DURATION;
+    }
+    Serial.printf("Flash identify command: %lu seconds\n", duration);
+
+    if (self->flashCallback == nullptr) {
+        result["error"] = "not_supported";
+        return CMD_RESULT_ERROR;
+    }
+
+    self->flashCallback((uint16_t)duration);
+    result["duration"] = duration;
+    return CMD_RESULT_OK;
+}
+
+CommandResult MQTTClientManager::onGetStatus(void* context, JsonObjectConst command, JsonObject result) {
+    MQTTClientManager* self = static_cast<MQTTClientManager*>(context);
+
+    Serial.println("Get status command - publishing current status");
+
+    // Full keyframe now, not at the next (possibly stretched) heartbeat
+    uint8_t inputState = inputs.getAllInputs();
+    uint8_t outputState = outputs.getAllOutputs();
+    LineState state = lineState.getState();
+
+    self->keyframeValid = false;
+    bool published = self->publishStatus(inputState, outputState, networkManager.isConnected(), state);
+
+    result["line_state"] = LineStateManager::stateToString(state);
+    result["digital_inputs"] = inputState;
+    result["digital_outputs"] = outputState;
+    if (published) {
+        result["status_seq"] = self->statusSeq;
+    }
+    return CMD_RESULT_OK;
+}
+
+CommandResult MQTTClientManager::onSetLineState(void* context, JsonObjectConst command, JsonObject result) {
+    MQTTClientManager* self = static_cast<MQTTClientManager*>(context);
+    const char* stateStr = command["state"] | "";
+
+    Serial.printf("Set line state command: %s\n", stateStr);
+
+    // Parse state string to enum
+    LineState newState = LINE_STATE_UNKNOWN;
+    if (strcmp(stateStr, "ON") == 0) {
+        newState = LINE_STATE_ON;
+    } else if (strcmp(stateStr, "OFF") == 0) {
+        newState = LINE_STATE_OFF;
+    } else if (strcmp(stateStr, "MAINTENANCE") == 0) {
+        newState = LINE_STATE_MAINTENANCE;
+    } else if (strcmp(stateStr, "ERROR") == 0) {
+        newState = LINE_STATE_ERROR;
+    } else {
+        Serial.printf("Invalid state: %s\n", stateStr);
+        result["error"] = "invalid_state";
+        return CMD_RESULT_ERROR;
+    }
+
+    // Reply once the I/O task has applied it (COMMAND_APPLIED -> completeCommand).
+    // Tag 0 is "no response wanted" unless a request_id was given - then all
+    // pending slots are taken
+    bool wantsResponse = self->currentRequestId != nullptr && self->currentRequestId[0] != '\0';
+    uint16_t tag = self->deferResponse(CMD_SET_LINE_STATE);
+    if (tag == 0 && wantsResponse) {
+        result["error"] = "busy";
+        return CMD_RESULT_ERROR;
+    }
+
+    // Hand to the I/O task, which owns line state (its callback publishes status)
+    IOCommand ioCommand = {};
+    ioCommand.type = IOCommand::SET_LINE_STATE;
+    ioCommand.newState = newState;
+    ioCommand.requestTag = tag;
+    if (!ioTask.postCommand(ioCommand)) {
+        Serial.println("ERROR: I/O command queue full - set_line_state dropped");
+        for (uint8_t i = 0; i < MQTT_PENDING_RESPONSES; i++) {
+            if (self->pendingResponses[i].tag == tag) {
+                self->pendingResponses[i].tag = 0;
+            }
+        }
+        result["error"] = "io_queue_full";
+        return CMD_RESULT_ERROR;
+    }
 
-    Serial.printf("Unknown command: %s\n", command);
+    return (tag != 0) ? CMD_RESULT_PENDING : CMD_RESULT_OK;
 }
@@ -1,19 +1,77 @@
 #pragma once
 
 #include <Arduino.h>
-#include <PubSubClient.h>
-#include <WiFiClient.h>
 #include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include "config.h"
+#include "device_config.h"
 #include "state/line_state.h"
 #include "network/mdns_discovery.h"
+#include "event_store.h"
+#include "command_dispatch.h"
+#include "json_pool.h"
 
-// Forward declaration
+// Forward declarations
 class ConnectionManager;
+typedef struct esp_mqtt_client* esp_mqtt_client_handle_t;  // ESP-IDF mqtt_client.h
 
-// Callback function type for MQTT commands
-typedef void (*MQTTFlashCallback)();
+// Callback function type for MQTT commands (flash_identify duration in seconds)
+typedef void (*MQTTFlashCallback)(uint16_t durationSeconds);
 
-// MQTT Client Manager
+// Callback function type for broker connection state changes
+typedef void (*MQTTConnectionCallback)(bool connected);
+
+/**
+ * MQTT Client Manager
+ *
+ * Built on the ESP-IDF esp_mqtt client, which runs the connection, keepalive
+ * and socket I/O in its own task. Nothing here blocks loop():
+ * - connect() only starts (or restarts) the client - the TCP/MQTT handshake
+ *   and automatic reconnects happen in the MQTT task
+ * - publish*() hand the message to the client outbox (esp_mqtt_client_enqueue)
+ *   and return immediately; the MQTT task sends it
+ * - incoming commands and connection state changes are queued by the MQTT
+ *   task and handled from update(), in loop() context
+ *
+ * QoS is chosen per message class (DeviceConfig::Settings::mqttQoS). QoS 1
+ * events are tracked by packet id until the broker's PUBACK; until then
+ * esp_mqtt owns them and retransmits them from its outbox (also across a
+ * stop/start). Only when the outbox gives up on one (MQTT_EVENT_DELETED,
+ * after its expiry timeout) does it go back into the event store for replay,
+ * so there is never a second copy in flight. A slot with neither outcome
+ * after MQTT_ACK_TIMEOUT is released without a resend.
+ *
+ * The network callbacks run in the WiFi/Ethernet event task: disconnect()
+ * only raises a flag, and the client is stopped from update(), so the event
+ * store is only ever touched from loop(). Replayed events are published on
+ * devices/{MAC}/events, so they never override the current line state.
+ *
+ * Status heartbeats are delta-encoded: every STATUS_KEYFRAME_EVERY-th message
+ * (and the first after each connect) is a full keyframe on devices/{MAC}/status,
+ * with the diagnostics (I/O task, I2C, delivery, memory, clock) attached; the
+ * ones in between go to devices/{MAC}/status-delta and only carry device
+ * state fields that differ from that keyframe (removed fields as null), so a
+ * lost QoS 0 delta never corrupts the subscriber's view. Diagnostics are not
+ * part of the diff - they change on every message. While line
+ * state, I/O and network are unchanged the heartbeat interval doubles up to
+ * HEARTBEAT_INTERVAL_MAX. Liveness comes from the broker connection, not
+ * from heartbeat frequency.
+ *
+ * Lifecycle: each connection registers a retained last will ("death") on
+ * devices/{MAC}/lifecycle and publishes a retained "birth" there once connected,
+ * so the broker flags a dead device after the keepalive timeout. Both carry
+ * boot_seq (NVS counter, +1 per boot) and session_seq (+1 per connection
+ * attempt within a boot); subscribers order lifecycle messages by that pair.
+ *
+ * Reconnects use exponential backoff with full jitter: the delay after the
+ * n-th failed attempt is uniform in [MQTT_BACKOFF_MIN, min(MQTT_BACKOFF_MAX,
+ * MQTT_BACKOFF_BASE * 2^n)], from a PRNG seeded with the MAC, so a fleet that
+ * loses the broker together does not come back in lockstep. After connect,
+ * only the birth goes out at once; the announcement and event replay wait
+ * for a random offset within MQTT_POST_CONNECT_WINDOW.
+ */
 class MQTTClientManager {
 public:
     MQTTClientManager();
@@ -21,13 +79,15 @@ public:
     // Initialize MQTT client with MAC address
     void begin(const char* macAddress);
 
-    // Connect to MQTT broker
+    // Start connecting to MQTT broker (any task, non-blocking - update() resolves
+    // the broker and starts the client; result reported via callback)
     bool connect();
 
-    // Disconnect from broker
+    // Disconnect from broker (any task, non-blocking - update() sends the death
+    // message and stops the client once it is out)
     void disconnect();
 
-    // Update MQTT client (call in loop)
+    // Update MQTT client (call in loop) - dispatches commands, state changes and replay
     void update();
 
     // Check if connected
@@ -36,35 +96,290 @@ public:
     // Publish device announcement (discovery)
     bool publishAnnouncement();
 
-    // Publish status event (with line state)
+    // Publish status heartbeat (with line state) - keyframe or delta, see class comment
     bool publishStatus(uint8_t inputs, uint8_t outputs, bool networkConnected, LineState lineState = LINE_STATE_UNKNOWN);
 
-    // Publish input change event
-    bool publishInputChange(uint8_t channel, bool state, uint8_t allInputs);
+    // Current heartbeat interval (HEARTBEAT_INTERVAL, stretched while stable)
+    uint32_t getHeartbeatInterval() const { return heartbeatInterval; }
+
+    // Publish input change event (queued for replay if the broker is unreachable)
+    // edgeTimeUs: esp_timer time of the captured edge (0 = use current time)
+    bool publishInputChange(uint8_t channel, bool state, uint8_t allInputs, uint64_t edgeTimeUs = 0);
+
+    // Publish line state change as a status event (queued for replay if the broker is unreachable)
+    // timestampUs: esp_timer time of the transition (0 = use current time)
+    bool publishLineStateChange(uint8_t inputs, uint8_t outputs, LineState lineState, uint64_t timestampUs = 0);
+
+    // Publish pulse counter totals and rates (compact periodic message)
+    bool publishCounters();
 
     // Set flash identification callback
     void setFlashCallback(MQTTFlashCallback callback);
 
+    // Set connection state callback (called from update())
+    void setConnectionCallback(MQTTConnectionCallback callback);
+
     // Set network manager reference (for connectivity checks)
     void setNetworkManager(ConnectionManager* manager);
 
+    // Offline event queue (pending/queued/dropped/replayed counters)
+    const EventStore& getEventStore() const { return eventStore; }
+
+    // QoS delivery statistics
+    uint8_t getInFlightCount() const;
+    uint32_t getAckedCount() const { return ackedCount; }
+    uint32_t getRetransmitCount() const { return retransmitCount; }
+    uint32_t getUnconfirmedCount() const { return unconfirmedCount; }
+
+    // Connect statistics (since boot)
+    uint32_t getConnectAttempts() const { return connectAttempts; }
+    uint32_t getConnectCount() const { return connectCount; }
+
+    // Lifecycle sequence numbers (see class comment)
+    uint32_t getBootSeq() const { return bootSeq; }
+    uint32_t getSessionSeq() const { return sessionSeq; }
+
+    // Response for a command handed to the I/O task (COMMAND_APPLIED event)
+    void completeCommand(uint16_t requestTag, LineState oldState, LineState newState, uint64_t appliedUs);
+
+    // Replace the handler for a command (built-in handlers are registered in begin())
+    void registerCommandHandler(CommandId id, CommandHandler handler, void* context);
+
+    // Outbound payload volume (all topics)
+    uint32_t getBytesSent() const { return bytesSent; }
+    uint32_t getBytesPerHour() const;
+
 private:
-    WiFiClient ethClient;
-    PubSubClient mqttClient;
+    // Incoming command copied out of the MQTT task
+    struct InboundMessage {
+        uint16_t length;
+        int64_t receivedUs;          // esp_timer time of arrival (response latency)
+        char payload[MQTT_COMMAND_MAX_LENGTH];
+    };
+
+    // Command whose response waits for the I/O task (tag 0 = free slot)
+    struct PendingResponse {
+        uint16_t tag;
+        CommandId command;
+        int64_t receivedUs;
+        unsigned long deadline;
+        char requestId[MQTT_REQUEST_ID_MAX_LENGTH];
+    };
+
+    // QoS > 0 event waiting for its PUBACK (msgId 0 = free slot)
+    struct InFlightEvent {
+        int msgId;
+        unsigned long sentAt;
+        bool expired;                // Dropped by the outbox - requeue from loop
+        EventRecord record;
+    };
+
+    esp_mqtt_client_handle_t client;
+    QueueHandle_t inboundQueue;      // MQTT task -> loop (commands)
+    volatile bool connected;         // Written by MQTT task
+    bool reportedConnected;          // Last state reported through connectionCallback
+    bool started;
     MQTTFlashCallback flashCallback;
+    MQTTConnectionCallback connectionCallback;
     ConnectionManager* networkManagerPtr;
-    unsigned long lastReconnectAttempt;
-    unsigned long reconnectInterval;
     MDNSDiscovery* mdnsDiscovery;  // mDNS discovery handler
+    volatile bool discoveryRunning;  // One-shot discovery task active
+    volatile bool brokerResolved;    // brokerHost/brokerPort set (discovery task or loop)
+    char brokerHost[64];
+    uint16_t brokerPort;
+    // Credentials as read in createClient() - clientConfig points here, so
+    // esp_mqtt_set_config() on reconnect never reads live (web-edited) settings
+    char brokerUser[sizeof(DeviceConfig::Settings::mqttUser)];
+    char brokerPassword[sizeof(DeviceConfig::Settings::mqttPassword)];
+    EventStore eventStore;         // Store-and-forward queue for state changes / input events
+    unsigned long lastReplay;
+    volatile uint32_t droppedCommands;
+
+    // Command parsing: filtered into a fixed pool, dispatched by name
+    alignas(8) uint8_t commandPoolBuffer[MQTT_COMMAND_POOL_SIZE];
+    JsonPoolAllocator commandPool;
+    JsonDocument commandFilter;      // Fields handlers read - everything else is skipped
+    CommandDispatcher commands;
+    uint32_t commandCount;
+    uint32_t rejectedCommands;       // Parse errors / unknown commands
+    uint32_t lastParseUs;
+    uint32_t maxParseUs;
+
+    // Request / response (loop context only)
+    const char* currentRequestId;    // request_id of the command being dispatched (nullptr = none)
+    int64_t currentReceivedUs;
+    PendingResponse pendingResponses[MQTT_PENDING_RESPONSES];
+    uint16_t nextRequestTag;
+    uint32_t responseCount;
+    uint32_t responseTimeouts;
+
+    InFlightEvent inFlight[MQTT_INFLIGHT_MAX];
+    portMUX_TYPE inFlightLock;       // Slots are freed by the MQTT task on PUBACK
+    volatile uint32_t ackedCount;
+    uint32_t retransmitCount;        // Expired from the outbox, queued for replay
+    uint32_t unconfirmedCount;       // Released after MQTT_ACK_TIMEOUT without an outcome
+
+    // Outgoing messages: documents and payloads come from the arena and are
+    // released when the publishing function returns (JsonPoolScope)
+    JsonPoolAllocator messageArena;
+
+    // Status heartbeat (delta encoding + adaptive interval)
+    JsonPoolAllocator keyframePool;  // Declared before statusKeyframe, which uses it
+    JsonDocument statusKeyframe;     // Last keyframe content (deltas are relative to it)
+    bool keyframeValid;
+    uint32_t statusSeq;
+    uint32_t keyframeSeq;
+    uint16_t deltasSinceKeyframe;
+    uint32_t heartbeatInterval;
+    bool lastCoreValid;              // Fields that decide "stable"
+    uint8_t lastInputs;
+    uint8_t lastOutputs;
+    LineState lastLineState;
+    bool lastNetworkConnected;
+
+    // Lifecycle (birth / last will)
+    uint32_t bootSeq;
+    volatile uint32_t sessionSeq;    // Advanced by the MQTT task before each connect
+    char willPayload[160];
+
+    // Reconnect backoff (PRNG and attempt counter are used by both tasks)
+    portMUX_TYPE backoffLock;
+    uint32_t randomState;            // xorshift32, seeded from the MAC
+    volatile uint8_t backoffAttempt; // Failed attempts since the last connect
+    volatile uint32_t lastBackoffMs;
+    volatile uint32_t connectAttempts;
+    volatile uint32_t connectCount;
+    bool restartPending;             // Delayed client start after a network outage
+    unsigned long restartAt;
+    volatile bool connectRequested;  // Set by connect() (event task), handled in update()
+    volatile bool disconnectRequested; // Set by disconnect() (event task), handled in update()
+    bool stopPending;                // Client stops once the death message is out
+    unsigned long stopAt;
+    bool announcePending;            // Post-connect pacing
+    unsigned long pacingUntil;
+    uint32_t lastPacingMs;
+
+    // Outbound volume (loop context only)
+    uint32_t bytesSent;
+    size_t lastPayloadBytes;         // Size of the last publishDocument() payload
+    uint32_t bytesThisHour;
+    uint32_t bytesLastHour;
+    unsigned long hourStart;
+    bool hourComplete;
 
     char deviceMAC[18];  // MAC address in format "XX:XX:XX:XX:XX:XX"
     char deviceTopicCommand[64];  // devices/{MAC}/command
     char deviceTopicStatus[64];   // devices/{MAC}/status
+    char deviceTopicStatusDelta[64]; // devices/{MAC}/status-delta
+    char deviceTopicResponse[64]; // devices/{MAC}/response
+    char deviceTopicLifecycle[64]; // devices/{MAC}/lifecycle
+
+    // Connect request from update(): resolve the broker on first use, then
+    // start (or schedule a jittered restart of) the client
+    bool startConnect();
+
+    // Broker resolution: mDNS cache / live query (blocking - runs in a one-shot
+    // task), falling back to the configured broker
+    void startDiscovery();
+    static void discoveryTask(void* param);
+    void resolveBroker();
+    void resolveConfiguredBroker();
 
-    // MQTT callback (static for PubSubClient)
-    static void onMessage(char* topic, byte* payload, unsigned int length);
-    static MQTTClientManager* instance;
+    // Create the esp_mqtt client for the resolved broker (first connect)
+    bool createClient();
+
+    // Start the esp_mqtt task (first connect, or delayed restart after an outage)
+    bool startClient();
+
+    // Send the death message and stop the client (loop, after disconnect())
+    void beginStop();
+
+    // Stop the esp_mqtt task (deferred by beginStop() until the outbox drained)
+    void stopClient();
+
+    // Birth / death payload for the current session (always JSON, formatted
+    // without a document - also called from the MQTT task)
+    size_t buildLifecyclePayload(bool online, char* buffer, size_t size);
+
+    // Before each connect (MQTT task): last will with the next session_seq,
+    // reconnect delay for the case this attempt fails
+    void prepareConnect();
+
+    // Jittered backoff for the given attempt, and the PRNG behind it
+    uint32_t backoffDelay(uint8_t attempt);
+    uint32_t nextRandom();
+
+    // Retained birth message (loop, after connect)
+    bool publishBirth();
+
+    // esp_mqtt event handler (runs in the MQTT task)
+    static void onMqttEvent(void* handlerArgs, const char* base, int32_t eventId, void* eventData);
+    void handleEvent(int32_t eventId, void* eventData);
+
+    // Hand a message to the client outbox (non-blocking)
+    // @return packet id (0 for QoS 0), -1 if not accepted
+    int publishRaw(const char* topic, const char* payload, size_t length, uint8_t qos, bool retain = false);
+
+    // QoS level configured for a message class
+    uint8_t qosFor(MQTTMessageClass messageClass) const;
+
+    // In-flight tracking for QoS > 0 events
+    bool trackInFlight(int msgId, const EventRecord& record);
+    void ackInFlight(int msgId);              // MQTT task: PUBACK
+    void expireInFlight(int msgId);           // MQTT task: dropped by the outbox
+    void requeueInFlight();                   // loop: expired -> event store, stale slots released
+
+    // Report connection state changes (loop context)
+    void checkConnectionState();
 
     // Message handling
-    void handleCommand(const char* payload);
+    void handleCommand(const char* payload, size_t length, int64_t receivedUs);
+
+    // Built-in command handlers (context = this)
+    static CommandResult onFlashIdentify(void* context, JsonObjectConst command, JsonObject result);
+    static CommandResult onGetStatus(void* context, JsonObjectConst command, JsonObject result);
+    static CommandResult onSetLineState(void* context, JsonObjectConst command, JsonObject result);
+
+    // Reply on devices/{MAC}/response (no-op for commands without request_id)
+    bool publishResponse(const char* requestId, CommandId command, CommandResult outcome,
+                         JsonObjectConst result, int64_t receivedUs);
+
+    // Park the current command's response until the I/O task reports back
+    // @return tag for the IOCommand (0 if no response is wanted or no slot is free)
+    uint16_t deferResponse(CommandId command);
+
+    // Reply "timeout" for deferred responses the I/O task never completed
+    void expirePendingResponses();
+
+    // Send an event now, or queue it (keeps order while a backlog is pending)
+    bool publishOrQueue(const EventRecord& record);
+
+    // Publish an event: live on input-change / status, replayed on events
+    bool publishEvent(const EventRecord& record, bool replayed);
+
+    // Replay up to EVENT_REPLAY_BATCH queued events (rate limited)
+    void replayQueued();
+
+    // Set timestamp (epoch ms when synced, else uptime ms) + time_synced flag
+    void addTimestamp(JsonDocument& doc, uint64_t epochUs, uint64_t timerUs);
+
+    // Serialize a document and hand it to the outbox - JSON, or MessagePack if
+    // configured and compact is set. The size is measured first and the payload
+    // serialized into an exactly-sized buffer, so nothing is ever truncated.
+    // @return packet id (0 for QoS 0), -1 if not accepted or too large
+    int publishDocument(const char* topic, JsonDocument& doc, uint8_t qos, bool retain = false, bool compact = true);
+
+    // Diagnostics carried by status keyframes (never diffed)
+    void addDiagnostics(JsonDocument& doc);
+    void addStatusMetrics(JsonDocument& doc);   // Counters + time, every status message
+
+    // Append pulse counter arrays (ch/total/ppm) to a message
+    void addCounters(JsonObject obj);
+
+    // Copy fields of current that differ from base into out (objects recursively)
+    // @return true if anything differs
+    static bool diffObject(JsonObjectConst current, JsonObjectConst base, JsonObject out);
+
+    // Count published payload bytes (rolling hourly window)
+    void recordBytesSent(size_t length);
 };
@@ -0,0 +1,30 @@
+#include "payload_buffer.h"
+
+PayloadBuffer::PayloadBuffer(JsonPoolAllocator& arena)
+    : arena(arena),
+      scope(arena),
+      buffer(stackBuffer),
+      measuredLength(0),
+      written(0) {
+    stackBuffer[0] = '\0';
+}
+
+PayloadBuffer::Status PayloadBuffer::serialize(JsonVariantConst doc, bool msgpack, size_t maxLength) {
+    measuredLength = msgpack ? measureMsgPack(doc) : measureJson(doc);
+    if (measuredLength > maxLength) {
+        return PAYLOAD_TOO_LARGE;
+    }
+
+    // Small payloads on the stack, larger ones in an exactly-sized arena block
+    if (measuredLength + 1 > sizeof(stackBuffer)) {
+        buffer = (char*)arena.allocate(measuredLength + 1);
+        if (buffer == nullptr) {
+            buffer = stackBuffer;
+            return PAYLOAD_NO_MEMORY;
+        }
+    }
+
+    written = msgpack ? serializeMsgPack(doc, buffer, measuredLength + 1)
+                      : serializeJson(doc, buffer, measuredLength + 1);
+    return PAYLOAD_OK;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "config.h"
+#include "json_pool.h"
+
+/**
+ * Serialized MQTT payload
+ *
+ * Measures a document first, then serializes it (JSON or MessagePack) into
+ * an exactly-sized buffer: on the stack up to MQTT_PAYLOAD_STACK_SIZE, above
+ * that a block of the message arena. Nothing is ever truncated - a payload
+ * over the limit, or one the arena cannot hold, is refused.
+ *
+ * Declare it as a local: the stack buffer lives in the object, and arena
+ * blocks are released when it goes out of scope (JsonPoolScope).
+ */
+class PayloadBuffer {
+public:
+    enum Status : uint8_t {
+        PAYLOAD_OK,
+        PAYLOAD_TOO_LARGE,   // Measured length over maxLength
+        PAYLOAD_NO_MEMORY    // Arena block not available
+    };
+
+    explicit PayloadBuffer(JsonPoolAllocator& arena);
+
+    PayloadBuffer(const PayloadBuffer&) = delete;
+    PayloadBuffer& operator=(const PayloadBuffer&) = delete;
+
+    /**
+     * Serialize a document (once per object)
+     * @param msgpack MessagePack instead of JSON
+     * @param maxLength Largest accepted payload (bytes)
+     */
+    Status serialize(JsonVariantConst doc, bool msgpack, size_t maxLength = MQTT_MAX_PAYLOAD_SIZE);
+
+    const char* data() const { return buffer; }
+    size_t length() const { return written; }
+    size_t measured() const { return measuredLength; }  // Set even if refused
+    bool onStack() const { return buffer == stackBuffer; }
+
+private:
+    JsonPoolAllocator& arena;
+    JsonPoolScope scope;         // Releases the arena block
+    char* buffer;
+    size_t measuredLength;
+    size_t written;
+    char stackBuffer[MQTT_PAYLOAD_STACK_SIZE];
+};
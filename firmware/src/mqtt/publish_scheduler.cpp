@@ -0,0 +1,60 @@
+#include "publish_scheduler.h"
+
+PublishScheduler::PublishScheduler()
+    : macHash(0) {
+    for (uint8_t i = 0; i < TASK_COUNT; i++) {
+        nextDue[i] = 0;
+        aligned[i] = false;
+    }
+}
+
+void PublishScheduler::begin(const char* macAddress) {
+    // FNV-1a over the MAC string
+    uint32_t hash = 2166136261UL;
+    for (const char* p = macAddress; *p; p++) {
+        hash = (hash ^ (uint8_t)*p) * 16777619UL;
+    }
+    macHash = hash;
+
+    realign();
+}
+
+void PublishScheduler::realign() {
+    for (uint8_t i = 0; i < TASK_COUNT; i++) {
+        aligned[i] = false;
+    }
+}
+
+uint32_t PublishScheduler::getPhase(Task task, uint32_t intervalMs) const {
+    if (intervalMs == 0) {
+        return 0;
+    }
+
+    // Different phase per task, so one device's messages don't coincide either
+    uint32_t h = macHash ^ ((uint32_t)(task + 1) * 2654435761UL);
+    h ^= h >> 16;
+    h *= 0x45d9f3bUL;
+    h ^= h >> 16;
+    return h % intervalMs;
+}
+
+bool PublishScheduler::due(Task task, uint32_t intervalMs) {
+    unsigned long now = millis();
+
+    if (!aligned[task]) {
+        nextDue[task] = now + getPhase(task, intervalMs);
+        aligned[task] = true;
+        return false;
+    }
+
+    if ((long)(now - nextDue[task]) < 0) {
+        return false;
+    }
+
+    // Next slot keeps the phase; skip slots missed while the loop was busy
+    nextDue[task] += intervalMs;
+    if ((long)(now - nextDue[task]) >= 0) {
+        nextDue[task] = now + intervalMs;
+    }
+    return true;
+}
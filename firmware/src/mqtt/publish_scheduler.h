@@ -0,0 +1,53 @@
+#pragma once
+
+#include <Arduino.h>
+#include "config.h"
+
+/**
+ * Periodic Publish Scheduler
+ *
+ * Spreads the periodic publishes of a fleet over time. Each device gets a
+ * fixed phase per message type, derived from a hash of its MAC, so devices
+ * powered up by the same breaker (or reconnected by the same broker restart)
+ * publish at different offsets instead of on the same boundaries.
+ *
+ * - The first due() after begin() or realign() only schedules: the message
+ *   goes out phase (0..interval) ms later, then every interval
+ * - Missed slots are skipped, never burst-published
+ * - The interval may change between calls (adaptive heartbeat); the next
+ *   slot is one new interval after the previous one
+ */
+class PublishScheduler {
+public:
+    enum Task : uint8_t {
+        TASK_HEARTBEAT,
+        TASK_ANNOUNCEMENT,
+        TASK_COUNTERS,
+        TASK_COUNT
+    };
+
+    PublishScheduler();
+
+    /**
+     * Derive per-task phases from the device MAC
+     */
+    void begin(const char* macAddress);
+
+    /**
+     * Restart all schedules at their phase offset (call after (re)connect)
+     */
+    void realign();
+
+    /**
+     * Check whether a periodic publish is due (advances the schedule if so)
+     */
+    bool due(Task task, uint32_t intervalMs);
+
+    // Phase of a task within the given interval (ms)
+    uint32_t getPhase(Task task, uint32_t intervalMs) const;
+
+private:
+    uint32_t macHash;
+    unsigned long nextDue[TASK_COUNT];
+    bool aligned[TASK_COUNT];
+};
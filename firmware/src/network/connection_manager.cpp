@@ -14,6 +14,7 @@ ConnectionManager::ConnectionManager()
       deviceWebServer(nullptr),
       activeInterface(INTERFACE_NONE),
       connected(false),
+      webFrontendStarted(false),
       connectionCallback(nullptr) {
 
     instance = this;
@@ -56,32 +57,22 @@ bool ConnectionManager::begin(const char* mac) {
         const DeviceConfig::Settings& settings = deviceConfig.getSettings();
 
         if (strlen(settings.wifiSSID) > 0 && !settings.wifiAPMode) {
-            // Attempt STA mode connection
+            // Attempt STA mode connection in the background - web server (or
+            // captive portal after AP fallback) is started from update()
             Serial.printf("Connecting to WiFi: %s\n", settings.wifiSSID);
-            bool success = wifiManager->connectSTA(
+            wifiManager->connectSTA(
                 settings.wifiSSID,
                 settings.wifiPassword,
                 WIFI_CONNECTION_TIMEOUT
             );
-
-            if (success) {
-                connected = true;
-                // Start always-on configuration web server
-                deviceWebServer->begin(80);
-                return true;
-            } else {
-                // Connection failed, WiFiManager will have entered AP mode
-                Serial.println("WiFi connection failed - in AP mode");
-                // Start captive portal for setup
-                captivePortal->begin(macToUse);
-                return true;  // Still successful initialization, just in AP mode
-            }
+            return true;
         } else {
             // No credentials or AP mode forced - start AP mode
             Serial.println("No WiFi credentials - starting AP mode");
             wifiManager->startAP();
             // Start captive portal for setup
             captivePortal->begin(macToUse);
+            webFrontendStarted = true;
             return true;
         }
 
@@ -98,9 +89,7 @@ bool ConnectionManager::begin(const char* mac) {
         ethManager->begin();
         ethManager->setConnectionCallback(onEthernetConnection);
 
-        // Start always-on configuration web server
-        // Wait a moment for Ethernet to be ready
-        delay(500);
+        // Start always-on configuration web server (listens once the link is up)
         deviceWebServer->begin(80);
 
         return true;
@@ -115,15 +104,16 @@ void ConnectionManager::update() {
     } else if (activeInterface == INTERFACE_WIFI && wifiManager) {
         wifiManager->update();
         connected = wifiManager->isConnected();
+
+        if (!webFrontendStarted) {
+            startWiFiFrontend();
+        }
     }
 
-    // Update web servers
+    // Captive portal (AP mode) - the device web server runs in its own task
     if (captivePortal) {
         captivePortal->update();
     }
-    if (deviceWebServer) {
-        deviceWebServer->update();
-    }
 }
 
 bool ConnectionManager::isConnected() {
@@ -144,6 +134,10 @@ IPAddress ConnectionManager::getIP() {
     return IPAddress(0, 0, 0, 0);
 }
 
+void ConnectionManager::formatIP(const IPAddress& ip, char* buffer, size_t size) {
+    snprintf(buffer, size, "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+}
+
 int ConnectionManager::getRSSI() {
     if (activeInterface == INTERFACE_WIFI && wifiManager) {
         return wifiManager->getRSSI();
@@ -209,6 +203,20 @@ void ConnectionManager::onWiFiConnection(bool connState) {
     }
 }
 
+void ConnectionManager::startWiFiFrontend() {
+    if (wifiManager->getMode() == WiFiManager::MODE_AP) {
+        // STA connection failed, WiFiManager has entered AP mode
+        Serial.println("WiFi connection failed - in AP mode");
+        // Start captive portal for setup
+        captivePortal->begin(deviceMAC);
+        webFrontendStarted = true;
+    } else if (wifiManager->getMode() == WiFiManager::MODE_STA && wifiManager->isConnected()) {
+        // Start always-on configuration web server
+        deviceWebServer->begin(80);
+        webFrontendStarted = true;
+    }
+}
+
 void ConnectionManager::ensureMutualExclusion() {
     // This is enforced in begin() by only initializing one interface
     // Runtime check to ensure both aren't active
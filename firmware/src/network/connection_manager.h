@@ -51,6 +51,13 @@ public:
      */
     IPAddress getIP();
 
+    /**
+     * Format an IP address as dotted quad without IPAddress::toString()
+     * (which returns a heap String)
+     * @param buffer Output buffer, at least 16 bytes
+     */
+    static void formatIP(const IPAddress& ip, char* buffer, size_t size);
+
     /**
      * Get currently active interface
      * @return INTERFACE_NONE, INTERFACE_ETHERNET, or INTERFACE_WIFI
@@ -114,6 +121,7 @@ private:
     DeviceWebServer* deviceWebServer;
     Interface activeInterface;
     bool connected;
+    bool webFrontendStarted;         // Web server / captive portal started for current WiFi mode
 
     void (*connectionCallback)(bool);
 
@@ -124,4 +132,7 @@ private:
 
     // Ensure only one interface is active
     void ensureMutualExclusion();
+
+    // Start web server (STA) or captive portal (AP) once WiFi has settled
+    void startWiFiFrontend();
 };
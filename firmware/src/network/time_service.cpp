@@ -0,0 +1,109 @@
+#include "time_service.h"
+#include <esp_sntp.h>
+#include <esp_timer.h>
+#include <sys/time.h>
+
+// Offsets above this are a clock step (first sync, server change), not drift
+static const int64_t STEP_THRESHOLD_US = 1000000;
+
+// Shortest interval over which a residual is attributed to drift
+static const uint64_t MIN_DRIFT_INTERVAL_US = 60000000ULL;
+
+TimeService* TimeService::instance = nullptr;
+
+TimeService::TimeService()
+    : started(false),
+      synced(false),
+      offsetUs(0),
+      syncTimerUs(0),
+      driftPPM(0.0f),
+      lastOffsetUs(0),
+      syncCount(0) {
+
+    instance = this;
+    server[0] = '\0';
+    portMUX_INITIALIZE(&lock);
+}
+
+void TimeService::begin(const char* ntpServer) {
+    if (started) {
+        return;
+    }
+
+    strncpy(server, ntpServer, sizeof(server) - 1);
+    server[sizeof(server) - 1] = '\0';
+
+    // Immediate mode: system time is stepped on each sync, so every callback
+    // is a clean sample of (epoch, esp_timer)
+    esp_sntp_setoperatingmode(ESP_SNTP_OPMODE_POLL);
+    esp_sntp_setservername(0, server);
+    sntp_set_sync_mode(SNTP_SYNC_MODE_IMMED);
+    sntp_set_sync_interval(NTP_SYNC_INTERVAL);
+    sntp_set_time_sync_notification_cb(onSync);
+    esp_sntp_init();
+
+    started = true;
+    Serial.printf("SNTP started (server: %s, interval: %d s)\n", server, NTP_SYNC_INTERVAL / 1000);
+}
+
+void TimeService::onSync(struct timeval* tv) {
+    uint64_t timerUs = esp_timer_get_time();
+    uint64_t epochUs = (uint64_t)tv->tv_sec * 1000000ULL + tv->tv_usec;
+
+    if (instance != nullptr) {
+        instance->applySync(epochUs, timerUs);
+    }
+}
+
+void TimeService::applySync(uint64_t epochUs, uint64_t timerUs) {
+    portENTER_CRITICAL(&lock);
+
+    if (synced) {
+        // Residual = how far the drift-corrected prediction was off
+        int64_t predicted = (int64_t)timerUs + offsetUs +
+                            (int64_t)((double)(int64_t)(timerUs - syncTimerUs) * driftPPM / 1e6);
+        int64_t residual = (int64_t)epochUs - predicted;
+        uint64_t elapsed = timerUs - syncTimerUs;
+
+        lastOffsetUs = (int32_t)constrain(residual, (int64_t)INT32_MIN, (int64_t)INT32_MAX);
+
+        if (residual > STEP_THRESHOLD_US || residual < -STEP_THRESHOLD_US) {
+            driftPPM = 0.0f;  // Clock step - restart drift estimation
+        } else if (elapsed >= MIN_DRIFT_INTERVAL_US) {
+            // Fold half of the observed rate error into the estimate (smooths SNTP jitter)
+            float residualPPM = (float)((double)residual * 1e6 / (double)elapsed);
+            driftPPM = constrain(driftPPM + residualPPM * 0.5f, -TIME_DRIFT_MAX_PPM, TIME_DRIFT_MAX_PPM);
+        }
+    }
+
+    offsetUs = (int64_t)epochUs - (int64_t)timerUs;
+    syncTimerUs = timerUs;
+    syncCount++;
+    synced = true;
+
+    portEXIT_CRITICAL(&lock);
+}
+
+uint64_t TimeService::toEpochUs(uint64_t timerUs) const {
+    if (!synced) {
+        return 0;
+    }
+
+    portENTER_CRITICAL(&lock);
+    int64_t elapsed = (int64_t)(timerUs - syncTimerUs);  // Negative for events before last sync
+    int64_t epochUs = (int64_t)timerUs + offsetUs + (int64_t)((double)elapsed * driftPPM / 1e6);
+    portEXIT_CRITICAL(&lock);
+
+    return (uint64_t)epochUs;
+}
+
+uint64_t TimeService::nowEpochUs() const {
+    return toEpochUs(esp_timer_get_time());
+}
+
+uint32_t TimeService::getLastSyncAgeMs() const {
+    if (!synced) {
+        return UINT32_MAX;
+    }
+    return (uint32_t)((esp_timer_get_time() - syncTimerUs) / 1000);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include "config.h"
+
+struct timeval;
+
+/**
+ * TimeService - SNTP-synchronized epoch clock
+ *
+ * Maps the monotonic esp_timer clock (used for all capture timestamps) to
+ * UTC epoch microseconds:
+ *
+ *   epochUs(t) = t + offset + (t - syncTimerUs) * driftPPM / 1e6
+ *
+ * Each SNTP sync (ESP-IDF esp_sntp, polled every NTP_SYNC_INTERVAL) measures
+ * how far the prediction was off and folds the residual into the drift
+ * estimate, so timestamps stay accurate between syncs. Because the mapping
+ * is applied to esp_timer values, events captured before the first sync are
+ * stamped correctly too, as long as they are converted in the same boot.
+ *
+ * Usage:
+ *   TimeService timeService;
+ *   timeService.begin("192.168.1.1");   // once the network is up
+ *
+ *   uint64_t epochUs = timeService.toEpochUs(edgeTimeUs);  // 0 until first sync
+ */
+class TimeService {
+public:
+    TimeService();
+
+    /**
+     * Start SNTP against the given server (no-op if already started)
+     */
+    void begin(const char* server);
+
+    // True once the first SNTP sync has completed
+    bool isSynced() const { return synced; }
+
+    /**
+     * Convert an esp_timer timestamp to epoch microseconds
+     * @return 0 if the clock has not been synced yet
+     */
+    uint64_t toEpochUs(uint64_t timerUs) const;
+
+    // Current epoch microseconds (0 if not synced)
+    uint64_t nowEpochUs() const;
+
+    // Sync quality
+    int32_t getLastOffsetUs() const { return lastOffsetUs; }  // Correction applied at last sync
+    float getDriftPPM() const { return driftPPM; }
+    uint32_t getLastSyncAgeMs() const;                         // UINT32_MAX if never synced
+    uint32_t getSyncCount() const { return syncCount; }
+    const char* getServer() const { return server; }
+
+private:
+    static TimeService* instance;
+    static void onSync(struct timeval* tv);   // Runs in the lwIP task
+
+    void applySync(uint64_t epochUs, uint64_t timerUs);
+
+    mutable portMUX_TYPE lock;
+    char server[64];                 // esp_sntp keeps a pointer to this
+    bool started;
+    volatile bool synced;
+
+    int64_t offsetUs;                // epoch - esp_timer at syncTimerUs
+    uint64_t syncTimerUs;            // esp_timer time of last sync
+    float driftPPM;                  // Local oscillator error (+ = esp_timer slow)
+    int32_t lastOffsetUs;
+    uint32_t syncCount;
+};
@@ -7,7 +7,8 @@ static const char* NVS_STATE_KEY = "current";
 
 LineStateManager::LineStateManager()
     : currentState(LINE_STATE_UNKNOWN),
-      changeCallback(nullptr) {
+      changeCallback(nullptr),
+      persistPending(false) {
 }
 
 void LineStateManager::begin() {
@@ -41,31 +42,33 @@ bool LineStateManager::setState(LineState newState, const char* source) {
 
     // Check if transition is allowed
     if (!isTransitionAllowed(currentState, newState)) {
-        Serial.printf("State transition blocked: %s -> %s\n",
-                     stateToString(currentState),
-                     stateToString(newState));
         return false;
     }
 
     LineState oldState = currentState;
     currentState = newState;
 
-    Serial.printf("State changed: %s -> %s (source: %s)\n",
-                 stateToString(oldState),
-                 stateToString(newState),
-                 source);
-
-    // Persist to NVS
-    saveState();
+    // Persisted (and logged via the state change event) from loop()
+    persistPending = true;
 
     // Notify callback
     if (changeCallback != nullptr) {
-        changeCallback(oldState, newState);
+        changeCallback(oldState, newState, source);
     }
 
     return true;
 }
 
+void LineStateManager::update() {
+    if (!persistPending) {
+        return;
+    }
+
+    // Cleared first - a change during the write is saved on the next call
+    persistPending = false;
+    saveState();
+}
+
 LineState LineStateManager::handleShortPress() {
     LineState newState;
 
@@ -12,7 +12,8 @@
  * - Initialized to UNKNOWN on boot
  * - Synchronized with MQTT commands from API
  * - Updated immediately on button press (firmware authority)
- * - Persisted to NVS for power-cycle resilience
+ * - Persisted to NVS for power-cycle resilience (by update() in loop() -
+ *   setState() runs in the I/O task, which must not wait for flash)
  */
 
 enum LineState {
@@ -23,8 +24,8 @@ enum LineState {
     LINE_STATE_ERROR = 4         // Error state (set by API only)
 };
 
-// State change callback type
-typedef void (*StateChangeCallback)(LineState oldState, LineState newState);
+// State change callback type (source: the setState() source string literal)
+typedef void (*StateChangeCallback)(LineState oldState, LineState newState, const char* source);
 
 class LineStateManager {
 public:
@@ -55,6 +56,11 @@ public:
      */
     bool setState(LineState newState, const char* source = "unknown");
 
+    /**
+     * Write a changed state to NVS (call from loop())
+     */
+    void update();
+
     /**
      * Handle short button press (toggle logic)
      * Implements:
@@ -85,8 +91,9 @@ public:
     bool isTransitionAllowed(LineState from, LineState to) const;
 
 private:
-    LineState currentState;
+    volatile LineState currentState;
     StateChangeCallback changeCallback;
+    volatile bool persistPending;    // Set by setState(), cleared by update()
 
     // NVS persistence
     void saveState();
@@ -17,6 +17,7 @@ typedef void (*CredentialsSavedCallback)(const char* ssid, const char* password)
  * Provides a web interface for WiFi configuration in AP mode.
  * Includes DNS server for captive portal redirection and
  * web server for configuration page with network scanner.
+ * The setup page is the prebuilt "/portal" web asset (web_assets.h).
  */
 class CaptivePortal {
 public:
@@ -80,13 +81,11 @@ private:
 
     // HTTP request handlers
     void handleRoot();
+    void handleInfo();
     void handleScan();
     void handleSave();
     void handleNotFound();
 
-    // HTML page generation
-    String generateSetupPage();
-    String generateSuccessPage();
     String getEncryptionType(wifi_auth_mode_t encryption);
 
     static const uint8_t DNS_PORT = 53;
@@ -0,0 +1,108 @@
+#include "chunked_response.h"
+#include <stdarg.h>
+
+ChunkedResponse::ChunkedResponse(httpd_req_t* req)
+    : req(req),
+      used(0),
+      bytesSent(0),
+      error(ESP_OK) {
+}
+
+void ChunkedResponse::begin(const char* contentType, const char* status) {
+    used = 0;
+    bytesSent = 0;
+    error = ESP_OK;
+    httpd_resp_set_status(req, status);
+    httpd_resp_set_type(req, contentType);
+}
+
+void ChunkedResponse::print(const char* text) {
+    size_t length = strlen(text);
+
+    // Large constant blocks: send in place rather than copying through the buffer
+    if (length > sizeof(buffer) - used) {
+        flush();
+        if (length >= sizeof(buffer)) {
+            if (error == ESP_OK) {
+                error = httpd_resp_send_chunk(req, text, length);
+                bytesSent += length;
+            }
+            return;
+        }
+    }
+
+    append(text, length);
+}
+
+void ChunkedResponse::printf(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer + used, sizeof(buffer) - used, format, args);
+    va_end(args);
+
+    if (length < 0) {
+        return;
+    }
+
+    // Didn't fit behind the buffered text - flush and format again
+    if ((size_t)length >= sizeof(buffer) - used && used > 0) {
+        flush();
+        va_start(args, format);
+        length = vsnprintf(buffer, sizeof(buffer), format, args);
+        va_end(args);
+        if (length < 0) {
+            return;
+        }
+    }
+
+    used += min((size_t)length, sizeof(buffer) - used - 1);
+}
+
+void ChunkedResponse::printJsonString(const char* text) {
+    append("\"", 1);
+    for (const char* p = text; *p; p++) {
+        if (*p == '"' || *p == '\\') {
+            char escaped[2] = { '\\', *p };
+            append(escaped, 2);
+        } else if ((uint8_t)*p < 0x20) {
+            char escaped[7];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", (uint8_t)*p);
+            append(escaped, 6);
+        } else {
+            append(p, 1);
+        }
+    }
+    append("\"", 1);
+}
+
+esp_err_t ChunkedResponse::end() {
+    flush();
+    if (error == ESP_OK) {
+        error = httpd_resp_send_chunk(req, nullptr, 0);  // Zero-length chunk terminates the response
+    }
+    return error;
+}
+
+void ChunkedResponse::append(const char* data, size_t length) {
+    while (length > 0) {
+        if (used == sizeof(buffer)) {
+            flush();
+        }
+        size_t count = min(length, sizeof(buffer) - used);
+        memcpy(buffer + used, data, count);
+        used += count;
+        data += count;
+        length -= count;
+    }
+}
+
+void ChunkedResponse::flush() {
+    if (used == 0) {
+        return;
+    }
+    if (error == ESP_OK) {
+        error = httpd_resp_send_chunk(req, buffer, used);
+        bytesSent += used;
+    }
+    used = 0;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <Arduino.h>
+#include <esp_http_server.h>
+#include "config.h"
+
+/**
+ * Chunked HTTP Response Writer
+ *
+ * Streams a response through httpd_resp_send_chunk() in chunks of up to
+ * WEB_CHUNK_SIZE bytes, buffered on the stack - responses are written piece
+ * by piece instead of being assembled in a heap String. Long constant text
+ * goes straight from flash without being copied.
+ *
+ * If the client goes away mid-response, further output is discarded and
+ * end() returns the send error.
+ */
+class ChunkedResponse {
+public:
+    explicit ChunkedResponse(httpd_req_t* req);
+
+    // Set status line and content type (sent with the first chunk)
+    void begin(const char* contentType, const char* status = HTTPD_200);
+
+    // Append text (constant text larger than the free buffer is sent directly)
+    void print(const char* text);
+
+    // Append formatted text (truncated to WEB_CHUNK_SIZE)
+    void printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+    // Append text as a quoted JSON string (configured values)
+    void printJsonString(const char* text);
+
+    // Flush and terminate the response
+    esp_err_t end();
+
+    size_t getBytesSent() const { return bytesSent; }
+
+private:
+    httpd_req_t* req;
+    char buffer[WEB_CHUNK_SIZE];
+    size_t used;
+    size_t bytesSent;
+    esp_err_t error;    // First send failure - stops further output
+
+    void append(const char* data, size_t length);
+    void flush();
+};
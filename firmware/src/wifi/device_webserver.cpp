@@ -1,13 +1,110 @@
 #include "device_webserver.h"
 #include "config.h"
+#include "web_assets.h"
+#include <lwip/sockets.h>
 
 extern DeviceConfig deviceConfig;
 extern char deviceMAC[18];
+extern volatile uint32_t loopMaxUs;
+
+DeviceWebServer* DeviceWebServer::instance = nullptr;
+
+// Same routes as before the move to esp_http_server. Static UI is gzipped in
+// flash (web_assets.h) and gets its values from /api/info.
+const DeviceWebServer::Route DeviceWebServer::ROUTES[] = {
+    { "/",              HTTP_GET,  &DeviceWebServer::handleAsset },
+    { "/config",        HTTP_GET,  &DeviceWebServer::handleAsset },
+    { "/wifi",          HTTP_GET,  &DeviceWebServer::handleAsset },
+    { "/ethernet",      HTTP_GET,  &DeviceWebServer::handleAsset },
+    { "/mqtt",          HTTP_GET,  &DeviceWebServer::handleAsset },
+    { "/device",        HTTP_GET,  &DeviceWebServer::handleAsset },
+    { "/style.css",     HTTP_GET,  &DeviceWebServer::handleAsset },
+    { "/app.js",        HTTP_GET,  &DeviceWebServer::handleAsset },
+    { "/save-wifi",     HTTP_POST, &DeviceWebServer::handleSaveWiFi },
+    { "/save-ethernet", HTTP_POST, &DeviceWebServer::handleSaveEthernet },
+    { "/save-mqtt",     HTTP_POST, &DeviceWebServer::handleSaveMQTT },
+    { "/save-device",   HTTP_POST, &DeviceWebServer::handleSaveDevice },
+    { "/reboot",        HTTP_POST, &DeviceWebServer::handleReboot },
+    { "/reset",         HTTP_POST, &DeviceWebServer::handleReset },
+    { "/status",        HTTP_GET,  &DeviceWebServer::handleStatus },
+    { "/api/info",      HTTP_GET,  &DeviceWebServer::handleInfo },
+};
+const size_t DeviceWebServer::ROUTE_COUNT = sizeof(ROUTES) / sizeof(ROUTES[0]);
+
+// Form helpers (application/x-www-form-urlencoded bodies)
+
+// Read the request body into buffer (NUL-terminated)
+// @return ESP_OK, ESP_ERR_TIMEOUT if the client stalled, ESP_FAIL otherwise
+static esp_err_t readForm(httpd_req_t* req, char* buffer, size_t size) {
+    if (req->content_len >= size) {
+        return ESP_FAIL;
+    }
+
+    size_t received = 0;
+    while (received < req->content_len) {
+        int result = httpd_req_recv(req, buffer + received, req->content_len - received);
+        if (result == HTTPD_SOCK_ERR_TIMEOUT) {
+            // No retry: the recv already waited WEB_REQUEST_TIMEOUT, and a
+            // stalled client must not hold the only server task
+            return ESP_ERR_TIMEOUT;
+        }
+        if (result <= 0) {
+            return ESP_FAIL;
+        }
+        received += result;
+    }
+    buffer[received] = '\0';
+    return ESP_OK;
+}
+
+// 408 for a stalled body - the connection is closed (rest of the body unread)
+static esp_err_t sendTimeout(httpd_req_t* req) {
+    httpd_resp_send_408(req);
+    return ESP_FAIL;
+}
+
+// Decode %XX and '+' in place
+static void urlDecode(char* text) {
+    char* out = text;
+    for (char* in = text; *in; in++) {
+        if (*in == '+') {
+            *out++ = ' ';
+        } else if (*in == '%' && isxdigit((uint8_t)in[1]) && isxdigit((uint8_t)in[2])) {
+            char hex[3] = { in[1], in[2], '\0' };
+            *out++ = (char)strtol(hex, nullptr, 16);
+            in += 2;
+        } else {
+            *out++ = *in;
+        }
+    }
+    *out = '\0';
+}
+
+// Get a decoded field - false if missing or longer than the buffer
+static bool formValue(const char* body, const char* key, char* value, size_t size) {
+    if (httpd_query_key_value(body, key, value, size) != ESP_OK) {
+        return false;
+    }
+    urlDecode(value);
+    return true;
+}
+
+static esp_err_t sendJSON(httpd_req_t* req, const char* status, const char* json) {
+    httpd_resp_set_status(req, status);
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_sendstr(req, json);
+}
 
 DeviceWebServer::DeviceWebServer()
-    : webServer(nullptr),
+    : server(nullptr),
       running(false),
-      serverPort(80) {
+      serverPort(80),
+      requestCount(0),
+      lastHeapDelta(0),
+      minHeapDelta(0),
+      openConnections(0),
+      peakConnections(0) {
+    instance = this;
 }
 
 DeviceWebServer::~DeviceWebServer() {
@@ -15,761 +112,318 @@ DeviceWebServer::~DeviceWebServer() {
 }
 
 bool DeviceWebServer::begin(uint16_t port) {
+    if (running) {
+        return true;
+    }
     serverPort = port;
 
     Serial.printf("Starting device web server on port %d...\n", serverPort);
 
-    webServer = new WebServer(serverPort);
-
-    // Register HTTP handlers
-    webServer->on("/", [this]() { handleRoot(); });
-    webServer->on("/config", [this]() { handleConfig(); });
-    webServer->on("/wifi", [this]() { handleWiFiConfig(); });
-    webServer->on("/ethernet", [this]() { handleEthernetConfig(); });
-    webServer->on("/mqtt", [this]() { handleMQTTConfig(); });
-    webServer->on("/device", [this]() { handleDeviceConfig(); });
-    webServer->on("/save-wifi", HTTP_POST, [this]() { handleSaveWiFi(); });
-    webServer->on("/save-ethernet", HTTP_POST, [this]() { handleSaveEthernet(); });
-    webServer->on("/save-mqtt", HTTP_POST, [this]() { handleSaveMQTT(); });
-    webServer->on("/save-device", HTTP_POST, [this]() { handleSaveDevice(); });
-    webServer->on("/reboot", HTTP_POST, [this]() { handleReboot(); });
-    webServer->on("/reset", HTTP_POST, [this]() { handleReset(); });
-    webServer->on("/status", [this]() { handleStatus(); });
-    webServer->onNotFound([this]() { handleNotFound(); });
-
-    webServer->begin();
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = serverPort;
+    config.core_id = WEB_TASK_CORE;
+    config.task_priority = WEB_TASK_PRIORITY;
+    config.stack_size = WEB_TASK_STACK_SIZE;
+    config.max_open_sockets = WEB_MAX_CONNECTIONS;
+    config.backlog_conn = WEB_BACKLOG;
+    config.lru_purge_enable = true;              // Full: close the idlest keep-alive connection
+    config.recv_wait_timeout = WEB_REQUEST_TIMEOUT;
+    config.send_wait_timeout = WEB_REQUEST_TIMEOUT;
+    config.keep_alive_enable = true;             // TCP keep-alive: reap vanished clients
+    config.max_uri_handlers = ROUTE_COUNT;
+    config.open_fn = onOpen;
+    config.close_fn = onClose;
+
+    esp_err_t err = httpd_start(&server, &config);
+    if (err != ESP_OK) {
+        Serial.printf("✗ Device web server failed to start: %s\n", esp_err_to_name(err));
+        server = nullptr;
+        return false;
+    }
+
+    for (size_t i = 0; i < ROUTE_COUNT; i++) {
+        httpd_uri_t uri = {};
+        uri.uri = ROUTES[i].uri;
+        uri.method = ROUTES[i].method;
+        uri.handler = dispatch;
+        uri.user_ctx = (void*)&ROUTES[i];
+        httpd_register_uri_handler(server, &uri);
+    }
+    httpd_register_err_handler(server, HTTPD_404_NOT_FOUND, onNotFound);
+
     running = true;
 
-    Serial.printf("✓ Device web server started\n");
+    Serial.printf("✓ Device web server started (core %d, %d connections)\n",
+                 WEB_TASK_CORE, WEB_MAX_CONNECTIONS);
     Serial.printf("  Access configuration at: http://<device-ip>:%d\n", serverPort);
 
     return true;
 }
 
 void DeviceWebServer::stop() {
-    if (webServer) {
-        webServer->stop();
-        delete webServer;
-        webServer = nullptr;
+    if (server) {
+        httpd_stop(server);
+        server = nullptr;
         running = false;
         Serial.println("Device web server stopped");
     }
 }
 
-void DeviceWebServer::update() {
-    if (webServer && running) {
-        webServer->handleClient();
-    }
-}
-
-// HTTP Handlers
-
-void DeviceWebServer::handleRoot() {
-    webServer->send(200, "text/html", generateHomePage());
+esp_err_t DeviceWebServer::dispatch(httpd_req_t* req) {
+    const Route* route = static_cast<const Route*>(req->user_ctx);
+    return instance->serve(req, route->handler);
 }
 
-void DeviceWebServer::handleConfig() {
-    webServer->send(200, "text/html", generateConfigPage());
+esp_err_t DeviceWebServer::onNotFound(httpd_req_t* req, httpd_err_code_t error) {
+    return instance->serve(req, &DeviceWebServer::handleNotFound);
 }
 
-void DeviceWebServer::handleWiFiConfig() {
-    webServer->send(200, "text/html", generateWiFiPage());
+esp_err_t DeviceWebServer::onOpen(httpd_handle_t handle, int sockfd) {
+    uint8_t open = ++instance->openConnections;
+    if (open > instance->peakConnections) {
+        instance->peakConnections = open;
+    }
+    return ESP_OK;
 }
 
-void DeviceWebServer::handleEthernetConfig() {
-    webServer->send(200, "text/html", generateEthernetPage());
+void DeviceWebServer::onClose(httpd_handle_t handle, int sockfd) {
+    if (instance->openConnections > 0) {
+        instance->openConnections--;
+    }
+    close(sockfd);  // Setting close_fn makes closing the socket our job
 }
 
-void DeviceWebServer::handleMQTTConfig() {
-    webServer->send(200, "text/html", generateMQTTPage());
-}
+esp_err_t DeviceWebServer::serve(httpd_req_t* req, Handler handler) {
+    uint32_t heapBefore = ESP.getFreeHeap();
+#if WEB_DEBUG
+    unsigned long startUs = micros();
+#endif
 
-void DeviceWebServer::handleDeviceConfig() {
-    webServer->send(200, "text/html", generateDevicePage());
-}
+    esp_err_t result = (this->*handler)(req);
 
-void DeviceWebServer::handleSaveWiFi() {
-    const DeviceConfig::Settings& currentSettings = deviceConfig.getSettings();
+    // Other tasks allocate meanwhile - the delta is indicative, not exact
+    lastHeapDelta = (int32_t)ESP.getFreeHeap() - (int32_t)heapBefore;
+    if (lastHeapDelta < minHeapDelta) {
+        minHeapDelta = lastHeapDelta;
+    }
+    requestCount++;
 
-    if (webServer->hasArg("ssid") && webServer->hasArg("password")) {
-        String ssid = webServer->arg("ssid");
-        String password = webServer->arg("password");
-        bool enabled = webServer->hasArg("enabled") && webServer->arg("enabled") == "on";
+#if WEB_DEBUG
+    Serial.printf("HTTP %s %luus heap %ld\n", req->uri, micros() - startUs, (long)lastHeapDelta);
+#endif
+    return result;
+}
 
-        if (deviceConfig.setWiFiCredentials(ssid.c_str(), password.c_str())) {
-            deviceConfig.enableWiFi(enabled);
-            deviceConfig.save();
+// HTTP Handlers
 
-            webServer->send(200, "application/json",
-                           "{\"success\":true,\"message\":\"WiFi configuration saved. Reboot to apply.\"}");
-        } else {
-            webServer->send(400, "application/json",
-                           "{\"success\":false,\"message\":\"Invalid WiFi configuration\"}");
-        }
-    } else {
-        webServer->send(400, "application/json",
-                       "{\"success\":false,\"message\":\"Missing required fields\"}");
+esp_err_t DeviceWebServer::handleAsset(httpd_req_t* req) {
+    const WebAsset* asset = findWebAsset(req->uri);
+    if (asset == nullptr) {
+        return handleNotFound(req);
     }
+    return sendWebAsset(req, asset);
 }
 
-void DeviceWebServer::handleSaveEthernet() {
-    if (webServer->hasArg("use_dhcp")) {
-        bool useDHCP = webServer->arg("use_dhcp") == "true";
-
-        if (useDHCP) {
-            deviceConfig.setNetworkMode(true);
-        } else if (webServer->hasArg("static_ip") && webServer->hasArg("gateway") &&
-                   webServer->hasArg("subnet") && webServer->hasArg("dns")) {
-            deviceConfig.setStaticIP(
-                webServer->arg("static_ip").c_str(),
-                webServer->arg("gateway").c_str(),
-                webServer->arg("subnet").c_str(),
-                webServer->arg("dns").c_str()
-            );
-        } else {
-            webServer->send(400, "application/json",
-                           "{\"success\":false,\"message\":\"Missing static IP configuration\"}");
-            return;
-        }
+esp_err_t DeviceWebServer::handleSaveWiFi(httpd_req_t* req) {
+    char body[WEB_FORM_MAX_SIZE];
+    char ssid[64];
+    char password[64];
+    char enabled[4] = "";
 
-        deviceConfig.save();
-        webServer->send(200, "application/json",
-                       "{\"success\":true,\"message\":\"Ethernet configuration saved. Reboot to apply.\"}");
-    } else {
-        webServer->send(400, "application/json",
-                       "{\"success\":false,\"message\":\"Missing required fields\"}");
+    esp_err_t form = readForm(req, body, sizeof(body));
+    if (form == ESP_ERR_TIMEOUT) {
+        return sendTimeout(req);
     }
-}
+    if (form == ESP_OK &&
+        formValue(body, "ssid", ssid, sizeof(ssid)) &&
+        formValue(body, "password", password, sizeof(password))) {
+        formValue(body, "enabled", enabled, sizeof(enabled));
 
-void DeviceWebServer::handleSaveMQTT() {
-    if (webServer->hasArg("broker") && webServer->hasArg("port")) {
-        String broker = webServer->arg("broker");
-        uint16_t port = webServer->arg("port").toInt();
-        String user = webServer->hasArg("user") ? webServer->arg("user") : "";
-        String password = webServer->hasArg("password") ? webServer->arg("password") : "";
+        if (deviceConfig.setWiFiCredentials(ssid, password)) {
+            deviceConfig.enableWiFi(strcmp(enabled, "on") == 0);
+            deviceConfig.save();
 
-        deviceConfig.setMQTTBroker(broker.c_str(), port);
-        if (user.length() > 0) {
-            deviceConfig.setMQTTAuth(user.c_str(), password.c_str());
+            return sendJSON(req, HTTPD_200,
+                            "{\"success\":true,\"message\":\"WiFi configuration saved. Reboot to apply.\"}");
         }
-        deviceConfig.save();
-
-        webServer->send(200, "application/json",
-                       "{\"success\":true,\"message\":\"MQTT configuration saved. Reboot to apply.\"}");
-    } else {
-        webServer->send(400, "application/json",
-                       "{\"success\":false,\"message\":\"Missing required fields\"}");
+        return sendJSON(req, HTTPD_400,
+                        "{\"success\":false,\"message\":\"Invalid WiFi configuration\"}");
     }
+    return sendJSON(req, HTTPD_400,
+                    "{\"success\":false,\"message\":\"Missing required fields\"}");
 }
 
-void DeviceWebServer::handleSaveDevice() {
-    if (webServer->hasArg("device_id")) {
-        String deviceID = webServer->arg("device_id");
+esp_err_t DeviceWebServer::handleSaveEthernet(httpd_req_t* req) {
+    char body[WEB_FORM_MAX_SIZE];
+    char useDHCP[8];
 
-        deviceConfig.setDeviceID(deviceID.c_str());
-        deviceConfig.save();
+    esp_err_t form = readForm(req, body, sizeof(body));
+    if (form == ESP_ERR_TIMEOUT) {
+        return sendTimeout(req);
+    }
+    if (form != ESP_OK ||
+        !formValue(body, "use_dhcp", useDHCP, sizeof(useDHCP))) {
+        return sendJSON(req, HTTPD_400,
+                        "{\"success\":false,\"message\":\"Missing required fields\"}");
+    }
 
-        webServer->send(200, "application/json",
-                       "{\"success\":true,\"message\":\"Device configuration saved.\"}");
+    if (strcmp(useDHCP, "true") == 0) {
+        deviceConfig.setNetworkMode(true);
     } else {
-        webServer->send(400, "application/json",
-                       "{\"success\":false,\"message\":\"Missing required fields\"}");
+        char staticIP[16];
+        char gateway[16];
+        char subnet[16];
+        char dns[16];
+
+        if (!formValue(body, "static_ip", staticIP, sizeof(staticIP)) ||
+            !formValue(body, "gateway", gateway, sizeof(gateway)) ||
+            !formValue(body, "subnet", subnet, sizeof(subnet)) ||
+            !formValue(body, "dns", dns, sizeof(dns))) {
+            return sendJSON(req, HTTPD_400,
+                            "{\"success\":false,\"message\":\"Missing static IP configuration\"}");
+        }
+        deviceConfig.setStaticIP(staticIP, gateway, subnet, dns);
     }
-}
 
-void DeviceWebServer::handleReboot() {
-    webServer->send(200, "application/json",
-                   "{\"success\":true,\"message\":\"Device rebooting in 3 seconds...\"}");
-
-    Serial.println("Reboot requested via web interface");
-    delay(3000);
-    ESP.restart();
+    deviceConfig.save();
+    return sendJSON(req, HTTPD_200,
+                    "{\"success\":true,\"message\":\"Ethernet configuration saved. Reboot to apply.\"}");
 }
 
-void DeviceWebServer::handleReset() {
-    webServer->send(200, "application/json",
-                   "{\"success\":true,\"message\":\"Configuration reset to defaults. Device will reboot.\"}");
+esp_err_t DeviceWebServer::handleSaveMQTT(httpd_req_t* req) {
+    char body[WEB_FORM_MAX_SIZE];
+    char broker[64];
+    char port[8];
+    char user[32] = "";
+    char password[64] = "";
 
-    Serial.println("Factory reset requested via web interface");
-    deviceConfig.resetToDefaults();
-    delay(3000);
-    ESP.restart();
-}
-
-void DeviceWebServer::handleStatus() {
-    const DeviceConfig::Settings& settings = deviceConfig.getSettings();
-
-    String json = "{";
-    json += "\"device_id\":\"" + String(deviceMAC) + "\",";
-    json += "\"uptime\":" + String(millis() / 1000) + ",";
-    json += "\"free_heap\":" + String(ESP.getFreeHeap()) + ",";
-    json += "\"connection_mode\":\"" + String(settings.connectionMode == MODE_WIFI ? "wifi" : "ethernet") + "\",";
-    json += "\"wifi_enabled\":" + String(settings.wifiEnabled ? "true" : "false");
-    json += "}";
-
-    webServer->send(200, "application/json", json);
-}
-
-void DeviceWebServer::handleNotFound() {
-    webServer->send(404, "text/plain", "404 Not Found");
-}
-
-// HTML Page Generators
-
-String DeviceWebServer::getCSS() {
-    return R"rawliteral(
-<style>
-    * { margin: 0; padding: 0; box-sizing: border-box; }
-    body {
-        font-family: -apple-system, BlinkMacSystemFont, 'Segoe UI', Arial, sans-serif;
-        background: #f5f5f5;
-        color: #333;
-    }
-    .header {
-        background: linear-gradient(135deg, #667eea 0%, #764ba2 100%);
-        color: white;
-        padding: 20px;
-        box-shadow: 0 2px 10px rgba(0,0,0,0.1);
-    }
-    .header h1 { font-size: 24px; margin-bottom: 5px; }
-    .header .subtitle { font-size: 14px; opacity: 0.9; }
-    .container { max-width: 800px; margin: 20px auto; padding: 0 20px; }
-    .nav {
-        background: white;
-        border-radius: 8px;
-        padding: 15px;
-        margin-bottom: 20px;
-        box-shadow: 0 2px 8px rgba(0,0,0,0.1);
-        display: flex;
-        gap: 10px;
-        flex-wrap: wrap;
-    }
-    .nav a {
-        padding: 10px 20px;
-        background: #667eea;
-        color: white;
-        text-decoration: none;
-        border-radius: 6px;
-        transition: background 0.3s;
-        font-size: 14px;
-    }
-    .nav a:hover { background: #5568d3; }
-    .nav a.active { background: #764ba2; }
-    .card {
-        background: white;
-        border-radius: 8px;
-        padding: 25px;
-        box-shadow: 0 2px 8px rgba(0,0,0,0.1);
-        margin-bottom: 20px;
-    }
-    .card h2 {
-        font-size: 20px;
-        margin-bottom: 20px;
-        color: #667eea;
-        border-bottom: 2px solid #f0f0f0;
-        padding-bottom: 10px;
-    }
-    .form-group { margin-bottom: 20px; }
-    .form-group label {
-        display: block;
-        margin-bottom: 8px;
-        font-weight: 500;
-        color: #555;
-    }
-    .form-group input[type="text"],
-    .form-group input[type="password"],
-    .form-group input[type="number"] {
-        width: 100%;
-        padding: 12px;
-        border: 2px solid #ddd;
-        border-radius: 6px;
-        font-size: 14px;
-        transition: border-color 0.3s;
-    }
-    .form-group input:focus {
-        outline: none;
-        border-color: #667eea;
-    }
-    .form-group input[type="checkbox"] {
-        width: 20px;
-        height: 20px;
-        margin-right: 10px;
-        cursor: pointer;
-    }
-    .checkbox-label {
-        display: flex;
-        align-items: center;
-        cursor: pointer;
-    }
-    .btn {
-        padding: 12px 24px;
-        background: #667eea;
-        color: white;
-        border: none;
-        border-radius: 6px;
-        font-size: 14px;
-        font-weight: 600;
-        cursor: pointer;
-        transition: background 0.3s;
-        margin-right: 10px;
-    }
-    .btn:hover { background: #5568d3; }
-    .btn-success { background: #48bb78; }
-    .btn-success:hover { background: #38a169; }
-    .btn-danger { background: #f56565; }
-    .btn-danger:hover { background: #e53e3e; }
-    .btn-secondary { background: #718096; }
-    .btn-secondary:hover { background: #4a5568; }
-    .info-box {
-        background: #ebf8ff;
-        border-left: 4px solid #4299e1;
-        padding: 15px;
-        border-radius: 4px;
-        margin-bottom: 20px;
-        font-size: 14px;
-    }
-    .warning-box {
-        background: #fffaf0;
-        border-left: 4px solid #ed8936;
-        padding: 15px;
-        border-radius: 4px;
-        margin-bottom: 20px;
-        font-size: 14px;
-    }
-    .status-badge {
-        display: inline-block;
-        padding: 4px 12px;
-        border-radius: 12px;
-        font-size: 12px;
-        font-weight: 600;
-        margin-left: 10px;
-    }
-    .status-badge.online { background: #c6f6d5; color: #22543d; }
-    .status-badge.offline { background: #fed7d7; color: #742a2a; }
-    .message {
-        padding: 12px;
-        border-radius: 6px;
-        margin-bottom: 15px;
-        display: none;
+    esp_err_t form = readForm(req, body, sizeof(body));
+    if (form == ESP_ERR_TIMEOUT) {
+        return sendTimeout(req);
     }
-    .message.success { background: #c6f6d5; color: #22543d; display: block; }
-    .message.error { background: #fed7d7; color: #742a2a; display: block; }
-    table {
-        width: 100%;
-        border-collapse: collapse;
-        margin-top: 10px;
+    if (form != ESP_OK ||
+        !formValue(body, "broker", broker, sizeof(broker)) ||
+        !formValue(body, "port", port, sizeof(port))) {
+        return sendJSON(req, HTTPD_400,
+                        "{\"success\":false,\"message\":\"Missing required fields\"}");
     }
-    table th, table td {
-        padding: 12px;
-        text-align: left;
-        border-bottom: 1px solid #eee;
-    }
-    table th {
-        background: #f7fafc;
-        font-weight: 600;
-        color: #4a5568;
-    }
-</style>
-)rawliteral";
-}
+    formValue(body, "user", user, sizeof(user));
+    formValue(body, "password", password, sizeof(password));
 
-String DeviceWebServer::getHTMLHeader(const char* title) {
-    String html = "<!DOCTYPE html><html><head>";
-    html += "<meta charset='UTF-8'>";
-    html += "<meta name='viewport' content='width=device-width, initial-scale=1.0'>";
-    html += "<title>" + String(title) + " - ESP32 Configuration</title>";
-    html += getCSS();
-    html += "</head><body>";
-    html += "<div class='header'>";
-    html += "<h1>ESP32-S3 Device Configuration</h1>";
-    html += "<div class='subtitle'>MAC: " + String(deviceMAC) + " | Firmware: " + String(FIRMWARE_VERSION) + "</div>";
-    html += "</div>";
-    return html;
-}
-
-String DeviceWebServer::getHTMLFooter() {
-    return "</body></html>";
-}
+    deviceConfig.setMQTTBroker(broker, (uint16_t)atoi(port));
+    if (strlen(user) > 0) {
+        deviceConfig.setMQTTAuth(user, password);
+    }
+    deviceConfig.save();
 
-String DeviceWebServer::getNavigation() {
-    return R"rawliteral(
-<div class='nav'>
-    <a href='/'>Home</a>
-    <a href='/wifi'>WiFi</a>
-    <a href='/ethernet'>Ethernet</a>
-    <a href='/mqtt'>MQTT</a>
-    <a href='/device'>Device</a>
-</div>
-)rawliteral";
+    return sendJSON(req, HTTPD_200,
+                    "{\"success\":true,\"message\":\"MQTT configuration saved. Reboot to apply.\"}");
 }
 
-String DeviceWebServer::generateHomePage() {
-    const DeviceConfig::Settings& settings = deviceConfig.getSettings();
+esp_err_t DeviceWebServer::handleSaveDevice(httpd_req_t* req) {
+    char body[WEB_FORM_MAX_SIZE];
+    char deviceID[32];
 
-    String html = getHTMLHeader("Home");
-    html += "<div class='container'>";
-    html += getNavigation();
-
-    html += "<div class='card'>";
-    html += "<h2>Device Overview</h2>";
-    html += "<table>";
-    html += "<tr><th>Property</th><th>Value</th></tr>";
-    html += "<tr><td>Device ID</td><td>" + String(settings.deviceID) + "</td></tr>";
-    html += "<tr><td>MAC Address</td><td>" + String(deviceMAC) + "</td></tr>";
-    html += "<tr><td>Device Type</td><td>" + String(DEVICE_TYPE) + "</td></tr>";
-    html += "<tr><td>Firmware Version</td><td>" + String(FIRMWARE_VERSION) + "</td></tr>";
-    html += "<tr><td>Uptime</td><td>" + String(millis() / 1000) + " seconds</td></tr>";
-    html += "<tr><td>Free Heap</td><td>" + String(ESP.getFreeHeap()) + " bytes</td></tr>";
-    html += "</table>";
-    html += "</div>";
-
-    html += "<div class='card'>";
-    html += "<h2>Network Status</h2>";
-    html += "<table>";
-    html += "<tr><th>Setting</th><th>Value</th></tr>";
-    html += "<tr><td>Connection Mode</td><td>" + String(settings.connectionMode == MODE_WIFI ? "WiFi" : "Ethernet") + "</td></tr>";
-
-    if (settings.connectionMode == MODE_WIFI) {
-        html += "<tr><td>WiFi SSID</td><td>" + String(settings.wifiSSID) + "</td></tr>";
-        html += "<tr><td>WiFi Enabled</td><td>" + String(settings.wifiEnabled ? "Yes" : "No") + "</td></tr>";
-    } else {
-        html += "<tr><td>Network Mode</td><td>" + String(settings.useDHCP ? "DHCP" : "Static IP") + "</td></tr>";
-        if (!settings.useDHCP) {
-            html += "<tr><td>Static IP</td><td>" + String(settings.staticIP) + "</td></tr>";
-            html += "<tr><td>Gateway</td><td>" + String(settings.gateway) + "</td></tr>";
-        }
+    esp_err_t form = readForm(req, body, sizeof(body));
+    if (form == ESP_ERR_TIMEOUT) {
+        return sendTimeout(req);
+    }
+    if (form != ESP_OK ||
+        !formValue(body, "device_id", deviceID, sizeof(deviceID))) {
+        return sendJSON(req, HTTPD_400,
+                        "{\"success\":false,\"message\":\"Missing required fields\"}");
     }
 
-    html += "</table>";
-    html += "</div>";
-
-    html += "<div class='card'>";
-    html += "<h2>Quick Actions</h2>";
-    html += "<button class='btn btn-secondary' onclick='location.href=\"/config\"'>Full Configuration</button>";
-    html += "<button class='btn btn-danger' onclick='if(confirm(\"Reboot device?\")) rebootDevice()'>Reboot Device</button>";
-    html += "</div>";
-
-    html += "</div>";
-
-    html += "<script>";
-    html += "function rebootDevice() {";
-    html += "  fetch('/reboot', {method: 'POST'})";
-    html += "    .then(r => r.json())";
-    html += "    .then(d => alert(d.message));";
-    html += "}";
-    html += "</script>";
-
-    html += getHTMLFooter();
-    return html;
-}
+    deviceConfig.setDeviceID(deviceID);
+    deviceConfig.save();
 
-String DeviceWebServer::generateConfigPage() {
-    String html = getHTMLHeader("Configuration");
-    html += "<div class='container'>";
-    html += getNavigation();
-
-    html += "<div class='card'>";
-    html += "<h2>Configuration Menu</h2>";
-    html += "<p>Select a category to configure:</p>";
-    html += "<div style='margin-top: 20px;'>";
-    html += "<a href='/wifi'><button class='btn' style='width: 100%; margin-bottom: 10px;'>WiFi Configuration</button></a>";
-    html += "<a href='/ethernet'><button class='btn' style='width: 100%; margin-bottom: 10px;'>Ethernet Configuration</button></a>";
-    html += "<a href='/mqtt'><button class='btn' style='width: 100%; margin-bottom: 10px;'>MQTT Configuration</button></a>";
-    html += "<a href='/device'><button class='btn' style='width: 100%; margin-bottom: 10px;'>Device Information</button></a>";
-    html += "</div>";
-    html += "</div>";
-
-    html += "<div class='card'>";
-    html += "<h2>System Actions</h2>";
-    html += "<button class='btn btn-secondary' onclick='if(confirm(\"Reboot device?\")) rebootDevice()'>Reboot Device</button>";
-    html += "<button class='btn btn-danger' onclick='if(confirm(\"Reset to factory defaults?\")) resetDevice()'>Factory Reset</button>";
-    html += "</div>";
-
-    html += "</div>";
-
-    html += "<script>";
-    html += "function rebootDevice() {";
-    html += "  fetch('/reboot', {method: 'POST'}).then(r => r.json()).then(d => alert(d.message));";
-    html += "}";
-    html += "function resetDevice() {";
-    html += "  fetch('/reset', {method: 'POST'}).then(r => r.json()).then(d => alert(d.message));";
-    html += "}";
-    html += "</script>";
-
-    html += getHTMLFooter();
-    return html;
+    return sendJSON(req, HTTPD_200,
+                    "{\"success\":true,\"message\":\"Device configuration saved.\"}");
 }
 
-String DeviceWebServer::generateWiFiPage() {
-    const DeviceConfig::Settings& settings = deviceConfig.getSettings();
+esp_err_t DeviceWebServer::handleReboot(httpd_req_t* req) {
+    sendJSON(req, HTTPD_200,
+             "{\"success\":true,\"message\":\"Device rebooting in 3 seconds...\"}");
 
-    String html = getHTMLHeader("WiFi Configuration");
-    html += "<div class='container'>";
-    html += getNavigation();
-
-    html += "<div class='info-box'>";
-    html += "Configure WiFi settings. Device will need to reboot to apply changes.";
-    html += "</div>";
-
-    html += "<div id='message' class='message'></div>";
-
-    html += "<div class='card'>";
-    html += "<h2>WiFi Configuration</h2>";
-    html += "<form id='wifiForm' onsubmit='saveWiFi(event)'>";
-
-    html += "<div class='form-group'>";
-    html += "<label class='checkbox-label'>";
-    html += "<input type='checkbox' name='enabled' " + String(settings.wifiEnabled ? "checked" : "") + ">";
-    html += " Enable WiFi";
-    html += "</label>";
-    html += "</div>";
-
-    html += "<div class='form-group'>";
-    html += "<label>Network SSID:</label>";
-    html += "<input type='text' name='ssid' value='" + String(settings.wifiSSID) + "' maxlength='32' required>";
-    html += "</div>";
-
-    html += "<div class='form-group'>";
-    html += "<label>Password:</label>";
-    html += "<input type='password' name='password' placeholder='Leave empty to keep current' maxlength='63'>";
-    html += "<small style='color: #888;'>Min 8 characters for WPA2, or empty for open networks</small>";
-    html += "</div>";
-
-    html += "<button type='submit' class='btn btn-success'>Save WiFi Configuration</button>";
-    html += "<button type='button' class='btn btn-secondary' onclick='location.href=\"/\"'>Cancel</button>";
-    html += "</form>";
-    html += "</div>";
-
-    html += "<div class='card'>";
-    html += "<h2>Current Status</h2>";
-    html += "<p><strong>Connection Mode:</strong> " + String(settings.connectionMode == MODE_WIFI ? "WiFi" : "Ethernet") + "</p>";
-    html += "<p><strong>WiFi Enabled:</strong> " + String(settings.wifiEnabled ? "Yes" : "No") + "</p>";
-    if (strlen(settings.wifiSSID) > 0) {
-        html += "<p><strong>Configured SSID:</strong> " + String(settings.wifiSSID) + "</p>";
-    }
-    html += "</div>";
-
-    html += "</div>";
-
-    html += "<script>";
-    html += "function saveWiFi(e) {";
-    html += "  e.preventDefault();";
-    html += "  const form = e.target;";
-    html += "  const data = new URLSearchParams(new FormData(form));";
-    html += "  fetch('/save-wifi', {method: 'POST', body: data})";
-    html += "    .then(r => r.json())";
-    html += "    .then(d => {";
-    html += "      const msg = document.getElementById('message');";
-    html += "      msg.textContent = d.message;";
-    html += "      msg.className = 'message ' + (d.success ? 'success' : 'error');";
-    html += "      if (d.success) setTimeout(() => location.href='/', 2000);";
-    html += "    });";
-    html += "}";
-    html += "</script>";
-
-    html += getHTMLFooter();
-    return html;
+    Serial.println("Reboot requested via web interface");
+    delay(3000);  // Server task only - the main loop keeps running until the restart
+    ESP.restart();
+    return ESP_OK;
 }
 
-String DeviceWebServer::generateEthernetPage() {
-    const DeviceConfig::Settings& settings = deviceConfig.getSettings();
+esp_err_t DeviceWebServer::handleReset(httpd_req_t* req) {
+    sendJSON(req, HTTPD_200,
+             "{\"success\":true,\"message\":\"Configuration reset to defaults. Device will reboot.\"}");
 
-    String html = getHTMLHeader("Ethernet Configuration");
-    html += "<div class='container'>";
-    html += getNavigation();
-
-    html += "<div class='info-box'>";
-    html += "Configure Ethernet network settings. Device will need to reboot to apply changes.";
-    html += "</div>";
-
-    html += "<div id='message' class='message'></div>";
-
-    html += "<div class='card'>";
-    html += "<h2>Ethernet Configuration</h2>";
-    html += "<form id='ethForm' onsubmit='saveEthernet(event)'>";
-
-    html += "<div class='form-group'>";
-    html += "<label class='checkbox-label'>";
-    html += "<input type='checkbox' name='use_dhcp' id='useDHCP' " + String(settings.useDHCP ? "checked" : "") + " onchange='toggleStaticIP()'>";
-    html += " Use DHCP (automatic IP)";
-    html += "</label>";
-    html += "</div>";
-
-    html += "<div id='staticIPFields' style='display: " + String(settings.useDHCP ? "none" : "block") + ";'>";
-
-    html += "<div class='form-group'>";
-    html += "<label>Static IP Address:</label>";
-    html += "<input type='text' name='static_ip' value='" + String(settings.staticIP) + "' placeholder='192.168.1.100'>";
-    html += "</div>";
-
-    html += "<div class='form-group'>";
-    html += "<label>Gateway:</label>";
-    html += "<input type='text' name='gateway' value='" + String(settings.gateway) + "' placeholder='192.168.1.1'>";
-    html += "</div>";
-
-    html += "<div class='form-group'>";
-    html += "<label>Subnet Mask:</label>";
-    html += "<input type='text' name='subnet' value='" + String(settings.subnet) + "' placeholder='255.255.255.0'>";
-    html += "</div>";
-
-    html += "<div class='form-group'>";
-    html += "<label>DNS Server:</label>";
-    html += "<input type='text' name='dns' value='" + String(settings.dnsServer) + "' placeholder='8.8.8.8'>";
-    html += "</div>";
-
-    html += "</div>";
-
-    html += "<button type='submit' class='btn btn-success'>Save Ethernet Configuration</button>";
-    html += "<button type='button' class='btn btn-secondary' onclick='location.href=\"/\"'>Cancel</button>";
-    html += "</form>";
-    html += "</div>";
-
-    html += "</div>";
-
-    html += "<script>";
-    html += "function toggleStaticIP() {";
-    html += "  const checked = document.getElementById('useDHCP').checked;";
-    html += "  document.getElementById('staticIPFields').style.display = checked ? 'none' : 'block';";
-    html += "}";
-    html += "function saveEthernet(e) {";
-    html += "  e.preventDefault();";
-    html += "  const form = e.target;";
-    html += "  const formData = new FormData(form);";
-    html += "  const data = new URLSearchParams();";
-    html += "  data.append('use_dhcp', formData.get('use_dhcp') ? 'true' : 'false');";
-    html += "  if (formData.get('use_dhcp') !== 'on') {";
-    html += "    data.append('static_ip', formData.get('static_ip'));";
-    html += "    data.append('gateway', formData.get('gateway'));";
-    html += "    data.append('subnet', formData.get('subnet'));";
-    html += "    data.append('dns', formData.get('dns'));";
-    html += "  }";
-    html += "  fetch('/save-ethernet', {method: 'POST', body: data})";
-    html += "    .then(r => r.json())";
-    html += "    .then(d => {";
-    html += "      const msg = document.getElementById('message');";
-    html += "      msg.textContent = d.message;";
-    html += "      msg.className = 'message ' + (d.success ? 'success' : 'error');";
-    html += "    });";
-    html += "}";
-    html += "</script>";
-
-    html += getHTMLFooter();
-    return html;
+    Serial.println("Factory reset requested via web interface");
+    deviceConfig.resetToDefaults();
+    delay(3000);
+    ESP.restart();
+    return ESP_OK;
 }
 
-String DeviceWebServer::generateMQTTPage() {
+esp_err_t DeviceWebServer::handleStatus(httpd_req_t* req) {
     const DeviceConfig::Settings& settings = deviceConfig.getSettings();
 
-    String html = getHTMLHeader("MQTT Configuration");
-    html += "<div class='container'>";
-    html += getNavigation();
-
-    html += "<div class='info-box'>";
-    html += "Configure MQTT broker connection. Device will need to reboot to apply changes.";
-    html += "</div>";
-
-    html += "<div id='message' class='message'></div>";
-
-    html += "<div class='card'>";
-    html += "<h2>MQTT Broker Configuration</h2>";
-    html += "<form id='mqttForm' onsubmit='saveMQTT(event)'>";
-
-    html += "<div class='form-group'>";
-    html += "<label>Broker Address:</label>";
-    html += "<input type='text' name='broker' value='" + String(settings.mqttBroker) + "' required placeholder='10.221.21.100'>";
-    html += "</div>";
-
-    html += "<div class='form-group'>";
-    html += "<label>Port:</label>";
-    html += "<input type='number' name='port' value='" + String(settings.mqttPort) + "' required placeholder='1883'>";
-    html += "</div>";
-
-    html += "<div class='form-group'>";
-    html += "<label>Username (optional):</label>";
-    html += "<input type='text' name='user' value='" + String(settings.mqttUser) + "' placeholder='Leave empty if not required'>";
-    html += "</div>";
-
-    html += "<div class='form-group'>";
-    html += "<label>Password (optional):</label>";
-    html += "<input type='password' name='password' placeholder='Leave empty to keep current or if not required'>";
-    html += "</div>";
-
-    html += "<button type='submit' class='btn btn-success'>Save MQTT Configuration</button>";
-    html += "<button type='button' class='btn btn-secondary' onclick='location.href=\"/\"'>Cancel</button>";
-    html += "</form>";
-    html += "</div>";
-
-    html += "</div>";
-
-    html += "<script>";
-    html += "function saveMQTT(e) {";
-    html += "  e.preventDefault();";
-    html += "  const data = new URLSearchParams(new FormData(e.target));";
-    html += "  fetch('/save-mqtt', {method: 'POST', body: data})";
-    html += "    .then(r => r.json())";
-    html += "    .then(d => {";
-    html += "      const msg = document.getElementById('message');";
-    html += "      msg.textContent = d.message;";
-    html += "      msg.className = 'message ' + (d.success ? 'success' : 'error');";
-    html += "    });";
-    html += "}";
-    html += "</script>";
-
-    html += getHTMLFooter();
-    return html;
+    // Longest loop() iteration since the previous /status request
+    uint32_t loopMax = loopMaxUs;
+    loopMaxUs = 0;
+
+    ChunkedResponse out(req);
+    out.begin("application/json");
+    out.printf("{\"device_id\":\"%s\",\"uptime\":%lu,\"free_heap\":%lu,"
+               "\"connection_mode\":\"%s\",\"wifi_enabled\":%s,"
+               "\"loop\":{\"max_us\":%lu},"
+               "\"http\":{\"requests\":%lu,\"last_heap_delta\":%ld,\"min_heap_delta\":%ld,"
+               "\"connections\":%u,\"peak_connections\":%u,\"max_connections\":%u}}",
+               deviceMAC, millis() / 1000, (unsigned long)ESP.getFreeHeap(),
+               settings.connectionMode == MODE_WIFI ? "wifi" : "ethernet",
+               settings.wifiEnabled ? "true" : "false",
+               (unsigned long)loopMax,
+               (unsigned long)requestCount, (long)lastHeapDelta, (long)minHeapDelta,
+               openConnections, peakConnections, WEB_MAX_CONNECTIONS);
+    return out.end();
 }
 
-String DeviceWebServer::generateDevicePage() {
-    const DeviceConfig::Settings& settings = deviceConfig.getSettings();
+esp_err_t DeviceWebServer::handleInfo(httpd_req_t* req) {
+    DeviceConfig::Settings settings;
+    deviceConfig.copySettings(settings);  // Not held while the response is sent
+
+    // Values the static pages fill in (passwords are never sent back)
+    ChunkedResponse out(req);
+    out.begin("application/json");
+    out.print("{\"device_id\":");
+    out.printJsonString(settings.deviceID);
+    out.printf(",\"mac\":\"%s\",\"device_type\":\"%s\",\"firmware\":\"%s\","
+               "\"uptime\":%lu,\"free_heap\":%lu,"
+               "\"connection_mode\":\"%s\",\"wifi_enabled\":%s,\"use_dhcp\":%s,",
+               deviceMAC, DEVICE_TYPE, FIRMWARE_VERSION,
+               millis() / 1000, (unsigned long)ESP.getFreeHeap(),
+               settings.connectionMode == MODE_WIFI ? "wifi" : "ethernet",
+               settings.wifiEnabled ? "true" : "false",
+               settings.useDHCP ? "true" : "false");
+    out.print("\"wifi_ssid\":");
+    out.printJsonString(settings.wifiSSID);
+    out.print(",\"static_ip\":");
+    out.printJsonString(settings.staticIP);
+    out.print(",\"gateway\":");
+    out.printJsonString(settings.gateway);
+    out.print(",\"subnet\":");
+    out.printJsonString(settings.subnet);
+    out.print(",\"dns\":");
+    out.printJsonString(settings.dnsServer);
+    out.print(",\"mqtt_broker\":");
+    out.printJsonString(settings.mqttBroker);
+    out.printf(",\"mqtt_port\":%u,\"mqtt_user\":", settings.mqttPort);
+    out.printJsonString(settings.mqttUser);
+    out.printf(",\"chip_model\":\"%s\",\"cpu_mhz\":%lu,\"flash_size\":%lu,\"psram_size\":%lu}",
+               ESP.getChipModel(), (unsigned long)ESP.getCpuFreqMHz(),
+               (unsigned long)ESP.getFlashChipSize(), (unsigned long)ESP.getPsramSize());
+    return out.end();
+}
 
-    String html = getHTMLHeader("Device Information");
-    html += "<div class='container'>";
-    html += getNavigation();
-
-    html += "<div id='message' class='message'></div>";
-
-    html += "<div class='card'>";
-    html += "<h2>Device Information</h2>";
-    html += "<form id='deviceForm' onsubmit='saveDevice(event)'>";
-
-    html += "<div class='form-group'>";
-    html += "<label>Device ID:</label>";
-    html += "<input type='text' name='device_id' value='" + String(settings.deviceID) + "' required maxlength='32'>";
-    html += "</div>";
-
-    html += "<button type='submit' class='btn btn-success'>Save Device Configuration</button>";
-    html += "<button type='button' class='btn btn-secondary' onclick='location.href=\"/\"'>Cancel</button>";
-    html += "</form>";
-    html += "</div>";
-
-    html += "<div class='card'>";
-    html += "<h2>Hardware Information</h2>";
-    html += "<table>";
-    html += "<tr><th>Property</th><th>Value</th></tr>";
-    html += "<tr><td>MAC Address</td><td>" + String(deviceMAC) + "</td></tr>";
-    html += "<tr><td>Chip Model</td><td>" + String(ESP.getChipModel()) + "</td></tr>";
-    html += "<tr><td>CPU Frequency</td><td>" + String(ESP.getCpuFreqMHz()) + " MHz</td></tr>";
-    html += "<tr><td>Flash Size</td><td>" + String(ESP.getFlashChipSize()) + " bytes</td></tr>";
-    html += "<tr><td>PSRAM Size</td><td>" + String(ESP.getPsramSize()) + " bytes</td></tr>";
-    html += "</table>";
-    html += "</div>";
-
-    html += "</div>";
-
-    html += "<script>";
-    html += "function saveDevice(e) {";
-    html += "  e.preventDefault();";
-    html += "  const data = new URLSearchParams(new FormData(e.target));";
-    html += "  fetch('/save-device', {method: 'POST', body: data})";
-    html += "    .then(r => r.json())";
-    html += "    .then(d => {";
-    html += "      const msg = document.getElementById('message');";
-    html += "      msg.textContent = d.message;";
-    html += "      msg.className = 'message ' + (d.success ? 'success' : 'error');";
-    html += "    });";
-    html += "}";
-    html += "</script>";
-
-    html += getHTMLFooter();
-    return html;
+esp_err_t DeviceWebServer::handleNotFound(httpd_req_t* req) {
+    httpd_resp_set_status(req, HTTPD_404);
+    httpd_resp_set_type(req, "text/plain");
+    return httpd_resp_sendstr(req, "404 Not Found");
 }
@@ -1,8 +1,9 @@
 #pragma once
 
 #include <Arduino.h>
-#include <WebServer.h>
+#include <esp_http_server.h>
 #include "../device_config.h"
+#include "chunked_response.h"
 
 /**
  * Device Web Server
@@ -10,6 +11,23 @@
  * Always-on web server for device configuration accessible at device IP.
  * Provides web-based UI for configuring WiFi, Ethernet, MQTT, and device settings.
  * Runs on port 80 when not in AP mode, or port 8080 to avoid conflicts.
+ *
+ * Built on the ESP-IDF HTTP server (esp_http_server), which runs in its own
+ * task (WEB_TASK_*) - the main loop never waits on a browser. Up to
+ * WEB_MAX_CONNECTIONS clients stay open with HTTP keep-alive; when all are
+ * in use, the least recently used connection is closed for a new one. A
+ * client that stalls mid-request gets a 408 and is dropped after
+ * WEB_REQUEST_TIMEOUT.
+ * Handlers run one at a time in the server task.
+ *
+ * The UI pages are static gzipped assets with ETags (web_assets.h); the
+ * device values they show come from /api/info. JSON responses are streamed
+ * through a fixed WEB_CHUNK_SIZE buffer rather than built as Strings. Every
+ * route is wrapped by serve(), which records the heap delta of the request.
+ *
+ * Save handlers write DeviceConfig from the server task through its setters,
+ * which hold the settings lock (see DeviceConfig); /api/info reads a copy.
+ * Changed network/MQTT settings only take effect after a reboot.
  */
 class DeviceWebServer {
 public:
@@ -17,61 +35,76 @@ public:
     ~DeviceWebServer();
 
     /**
-     * Start the web server
+     * Start the web server task
      * @param port Port to listen on (default 80, use 8080 if captive portal active)
      * @return true if started successfully
      */
     bool begin(uint16_t port = 80);
 
     /**
-     * Stop the web server
+     * Stop the web server (closes all connections)
      */
     void stop();
 
-    /**
-     * Update (call in main loop)
-     * Handles HTTP requests
-     */
-    void update();
-
     /**
      * Check if server is running
      * @return true if server is active
      */
     bool isRunning() const { return running; }
 
+    /**
+     * Per-request heap statistics (free heap after - before, in bytes)
+     */
+    uint32_t getRequestCount() const { return requestCount; }
+    int32_t getLastHeapDelta() const { return lastHeapDelta; }
+    int32_t getMinHeapDelta() const { return minHeapDelta; }
+
+    /**
+     * Open client connections (current / highest seen)
+     */
+    uint8_t getOpenConnections() const { return openConnections; }
+    uint8_t getPeakConnections() const { return peakConnections; }
+
 private:
-    WebServer* webServer;
+    typedef esp_err_t (DeviceWebServer::*Handler)(httpd_req_t* req);
+
+    // Route table entry (registered with the server, passed back as user_ctx)
+    struct Route {
+        const char* uri;
+        httpd_method_t method;
+        Handler handler;
+    };
+    static const Route ROUTES[];
+    static const size_t ROUTE_COUNT;
+
+    httpd_handle_t server;
     bool running;
     uint16_t serverPort;
+    volatile uint32_t requestCount;
+    volatile int32_t lastHeapDelta;
+    volatile int32_t minHeapDelta;    // Worst (most negative) delta seen
+    volatile uint8_t openConnections;
+    volatile uint8_t peakConnections;
 
-    // HTTP request handlers
-    void handleRoot();
-    void handleConfig();
-    void handleWiFiConfig();
-    void handleEthernetConfig();
-    void handleMQTTConfig();
-    void handleDeviceConfig();
-    void handleSaveWiFi();
-    void handleSaveEthernet();
-    void handleSaveMQTT();
-    void handleSaveDevice();
-    void handleReboot();
-    void handleReset();
-    void handleStatus();
-    void handleNotFound();
+    // Run a route handler and measure its heap delta
+    esp_err_t serve(httpd_req_t* req, Handler handler);
 
-    // HTML page generation
-    String generateHomePage();
-    String generateConfigPage();
-    String generateWiFiPage();
-    String generateEthernetPage();
-    String generateMQTTPage();
-    String generateDevicePage();
+    // esp_http_server callbacks (server task)
+    static esp_err_t dispatch(httpd_req_t* req);
+    static esp_err_t onNotFound(httpd_req_t* req, httpd_err_code_t error);
+    static esp_err_t onOpen(httpd_handle_t handle, int sockfd);
+    static void onClose(httpd_handle_t handle, int sockfd);
+    static DeviceWebServer* instance;
 
-    // Shared HTML components
-    String getHTMLHeader(const char* title);
-    String getHTMLFooter();
-    String getNavigation();
-    String getCSS();
+    // HTTP request handlers
+    esp_err_t handleAsset(httpd_req_t* req);
+    esp_err_t handleSaveWiFi(httpd_req_t* req);
+    esp_err_t handleSaveEthernet(httpd_req_t* req);
+    esp_err_t handleSaveMQTT(httpd_req_t* req);
+    esp_err_t handleSaveDevice(httpd_req_t* req);
+    esp_err_t handleReboot(httpd_req_t* req);
+    esp_err_t handleReset(httpd_req_t* req);
+    esp_err_t handleStatus(httpd_req_t* req);
+    esp_err_t handleInfo(httpd_req_t* req);
+    esp_err_t handleNotFound(httpd_req_t* req);
 };
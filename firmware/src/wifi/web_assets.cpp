@@ -0,0 +1,48 @@
+#include "web_assets.h"
+#include "web_assets_data.h"
+
+const char* WEB_ASSET_HEADERS[] = { "If-None-Match" };
+const size_t WEB_ASSET_HEADER_COUNT = sizeof(WEB_ASSET_HEADERS) / sizeof(WEB_ASSET_HEADERS[0]);
+
+static const size_t WEB_ASSET_COUNT = sizeof(WEB_ASSET_TABLE) / sizeof(WEB_ASSET_TABLE[0]);
+
+const WebAsset* findWebAsset(const char* path) {
+    for (size_t i = 0; i < WEB_ASSET_COUNT; i++) {
+        if (strcmp(WEB_ASSET_TABLE[i].path, path) == 0) {
+            return &WEB_ASSET_TABLE[i];
+        }
+    }
+    return nullptr;
+}
+
+void sendWebAsset(WebServer* server, const WebAsset* asset) {
+    server->sendHeader("ETag", asset->etag);
+    server->sendHeader("Cache-Control", "no-cache");
+
+    // If-None-Match may list several tags - any match means the copy is current
+    if (server->hasHeader("If-None-Match") &&
+        strstr(server->header("If-None-Match").c_str(), asset->etag) != nullptr) {
+        server->send(304);
+        return;
+    }
+
+    server->sendHeader("Content-Encoding", "gzip");
+    server->send_P(200, asset->contentType, (const char*)asset->data, asset->length);
+}
+
+esp_err_t sendWebAsset(httpd_req_t* req, const WebAsset* asset) {
+    httpd_resp_set_hdr(req, "ETag", asset->etag);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+
+    // A list too long for the buffer is treated as no match (full response)
+    char ifNoneMatch[64];
+    if (httpd_req_get_hdr_value_str(req, "If-None-Match", ifNoneMatch, sizeof(ifNoneMatch)) == ESP_OK &&
+        strstr(ifNoneMatch, asset->etag) != nullptr) {
+        httpd_resp_set_status(req, "304 Not Modified");
+        return httpd_resp_send(req, nullptr, 0);
+    }
+
+    httpd_resp_set_type(req, asset->contentType);
+    httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    return httpd_resp_send(req, (const char*)asset->data, asset->length);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WebServer.h>
+#include <esp_http_server.h>
+
+/**
+ * Prebuilt Web UI Assets
+ *
+ * The configuration UI (firmware/webui/) is gzipped at build time by
+ * scripts/build_web_assets.py into web_assets_data.h and served from flash
+ * as-is with Content-Encoding: gzip - no per-request generation.
+ *
+ * Each asset carries a strong ETag (hash of the compressed bytes). Pages are
+ * sent with Cache-Control: no-cache, so browsers revalidate on every view and
+ * get a body-less 304 until the firmware changes. Device values are not baked
+ * into the pages; they are fetched from a JSON endpoint.
+ */
+struct WebAsset {
+    const char* path;         // URL path ("/", "/wifi", "/style.css", ...)
+    const char* contentType;
+    const uint8_t* data;      // gzip stream (PROGMEM)
+    size_t length;
+    const char* etag;         // Quoted, e.g. "\"1a2b3c4d5e6f7a8b\""
+};
+
+/**
+ * Look up an asset by URL path
+ * @return Asset, or nullptr if there is none for this path
+ */
+const WebAsset* findWebAsset(const char* path);
+
+/**
+ * Send an asset (200 with gzip body, or 304 if the client's copy matches)
+ * The server must collect If-None-Match (see WEB_ASSET_HEADERS)
+ */
+void sendWebAsset(WebServer* server, const WebAsset* asset);
+
+/**
+ * Same, for the esp_http_server device web server
+ */
+esp_err_t sendWebAsset(httpd_req_t* req, const WebAsset* asset);
+
+// Request headers to pass to WebServer::collectHeaders()
+extern const char* WEB_ASSET_HEADERS[];
+extern const size_t WEB_ASSET_HEADER_COUNT;
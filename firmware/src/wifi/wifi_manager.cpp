@@ -9,7 +9,10 @@ WiFiManager::WiFiManager()
       connCallback(nullptr),
       lastReconnectAttempt(0),
       reconnectDelay(WIFI_RECONNECT_INITIAL_DELAY),
-      reconnectAttempts(0) {
+      reconnectAttempts(0),
+      connecting(false),
+      connectStart(0),
+      connectTimeout(WIFI_CONNECTION_TIMEOUT) {
 
     instance = this;
 }
@@ -46,37 +49,12 @@ bool WiFiManager::connectSTA(const char* ssid, const char* password, uint32_t ti
     currentMode = MODE_STA;
     connected = false;
 
-    // Wait for connection with timeout
-    unsigned long startTime = millis();
-    while (!connected && (millis() - startTime) < timeout) {
-        delay(100);
-
-        if (WiFi.status() == WL_CONNECTED) {
-            connected = true;
-            Serial.println("✓ WiFi connected");
-            Serial.printf("  IP Address: %s\n", WiFi.localIP().toString().c_str());
-            Serial.printf("  RSSI: %d dBm\n", WiFi.RSSI());
-
-            // Reset reconnection state
-            reconnectAttempts = 0;
-            reconnectDelay = WIFI_RECONNECT_INITIAL_DELAY;
-
-            if (connCallback) {
-                connCallback(true);
-            }
-
-            return true;
-        }
-    }
+    // Completion is reported by the GOT_IP event; timeout is checked in update()
+    connecting = true;
+    connectStart = millis();
+    connectTimeout = timeout;
 
-    // Connection failed
-    Serial.println("✗ WiFi connection timeout");
-    Serial.println("  Entering AP mode for setup...");
-
-    // Enter AP mode as fallback
-    enterAPMode();
-
-    return false;
+    return true;
 }
 
 bool WiFiManager::startAP(const char* ssid, const char* password) {
@@ -149,6 +127,24 @@ void WiFiManager::stop() {
 }
 
 void WiFiManager::update() {
+    // Initial connection attempt in progress
+    if (currentMode == MODE_STA && connecting) {
+        if (connected) {
+            connecting = false;
+            Serial.println("✓ WiFi connected");
+            Serial.printf("  IP Address: %s\n", WiFi.localIP().toString().c_str());
+            Serial.printf("  RSSI: %d dBm\n", WiFi.RSSI());
+        } else if (millis() - connectStart >= connectTimeout) {
+            connecting = false;
+            Serial.println("✗ WiFi connection timeout");
+            Serial.println("  Entering AP mode for setup...");
+
+            // Enter AP mode as fallback
+            enterAPMode();
+        }
+        return;
+    }
+
     // Only handle reconnection in STA mode
     if (currentMode == MODE_STA && !connected) {
         // Check if it's time to attempt reconnection
@@ -31,11 +31,13 @@ public:
     bool begin();
 
     /**
-     * Connect to WiFi network in Station mode
+     * Connect to WiFi network in Station mode (non-blocking)
+     * Connection completes in the background (callback on GOT_IP); update()
+     * falls back to AP mode if not connected within the timeout
      * @param ssid Network SSID
      * @param password Network password (empty for open networks)
      * @param timeout Connection timeout in milliseconds
-     * @return true if connected successfully
+     * @return true if the connection attempt was started
      */
     bool connectSTA(const char* ssid, const char* password, uint32_t timeout = WIFI_CONNECTION_TIMEOUT);
 
@@ -105,6 +107,11 @@ private:
     unsigned long reconnectDelay;
     uint8_t reconnectAttempts;
 
+    // Initial connection attempt (connectSTA)
+    bool connecting;
+    unsigned long connectStart;
+    uint32_t connectTimeout;
+
     // Stored credentials for auto-reconnect
     String staSsid;
     String staPassword;
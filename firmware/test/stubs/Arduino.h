@@ -0,0 +1,20 @@
+#pragma once
+
+// Minimal Arduino API for the native test environment ([env:native])
+//
+// Only what the host-testable modules use. millis() reads a clock the tests
+// advance themselves, so schedules can be simulated without waiting.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#define IRAM_ATTR
+
+namespace ArduinoStub {
+inline unsigned long nowMs = 0;   // Simulated millis()
+}
+
+inline unsigned long millis() { return ArduinoStub::nowMs; }
@@ -0,0 +1,209 @@
+// CommandDispatcher and the filtered command parse: lookup, dispatch, fuzzed
+// payloads and a parse + lookup latency benchmark (native env: pio test -e native)
+
+#include <unity.h>
+#include <chrono>
+#include <random>
+#include <string>
+#include "config.h"
+#include "mqtt/command_dispatch.h"
+#include "mqtt/json_pool.h"
+
+// Same pool and filter as MQTTClientManager::handleCommand()
+alignas(8) static uint8_t poolBuffer[MQTT_COMMAND_POOL_SIZE];
+static JsonPoolAllocator commandPool(poolBuffer, sizeof(poolBuffer));
+static JsonDocument commandFilter;
+
+void setUp() {
+    commandPool.reset();
+}
+
+void tearDown() {}
+
+static DeserializationError parseCommand(JsonDocument& doc, const char* payload, size_t length) {
+    commandPool.reset();
+    return deserializeJson(doc, payload, length, DeserializationOption::Filter(commandFilter));
+}
+
+static CommandResult recordHandler(void* context, JsonObjectConst command, JsonObject result) {
+    *static_cast<int*>(context) += 1;
+    result["state"] = command["state"];
+    return CMD_RESULT_OK;
+}
+
+void test_lookup_known_names() {
+    for (uint8_t id = 0; id < CMD_COUNT; id++) {
+        const char* name = CommandDispatcher::nameOf((CommandId)id);
+        TEST_ASSERT_EQUAL_UINT8(id, CommandDispatcher::lookup(name));
+
+        // Lookup compares content, not the table pointer
+        std::string copy(name);
+        TEST_ASSERT_EQUAL_UINT8(id, CommandDispatcher::lookup(copy.c_str()));
+    }
+    TEST_ASSERT_EQUAL_STRING("unknown", CommandDispatcher::nameOf(CMD_COUNT));
+}
+
+void test_lookup_rejects_unknown_and_near_misses() {
+    const char* rejected[] = {
+        "", "get", "get_statu", "get_status ", " get_status", "GET_STATUS",
+        "get_status\x01", "flash_identify2", "set_line_stat", "reboot",
+    };
+    for (const char* name : rejected) {
+        TEST_ASSERT_EQUAL_UINT8(CMD_COUNT, CommandDispatcher::lookup(name));
+    }
+    TEST_ASSERT_EQUAL_UINT8(CMD_COUNT, CommandDispatcher::lookup(nullptr));
+}
+
+void test_dispatch_runs_registered_handler() {
+    CommandDispatcher dispatcher;
+    int calls = 0;
+    dispatcher.registerHandler(CMD_SET_LINE_STATE, recordHandler, &calls);
+
+    const char payload[] = "{\"command\":\"set_line_state\",\"state\":\"running\"}";
+    JsonDocument doc(&commandPool);
+    TEST_ASSERT_TRUE(parseCommand(doc, payload, sizeof(payload) - 1) == DeserializationError::Ok);
+
+    JsonDocument response;
+    JsonObject result = response.to<JsonObject>();
+    TEST_ASSERT_EQUAL_UINT8(CMD_RESULT_OK, dispatcher.dispatch(doc["command"], doc.as<JsonObjectConst>(), result));
+    TEST_ASSERT_EQUAL_INT(1, calls);
+    TEST_ASSERT_EQUAL_STRING("running", result["state"].as<const char*>());
+
+    // Known name without a handler, unknown name
+    TEST_ASSERT_EQUAL_UINT8(CMD_RESULT_UNKNOWN, dispatcher.dispatch("get_status", doc.as<JsonObjectConst>(), result));
+    TEST_ASSERT_EQUAL_UINT8(CMD_RESULT_UNKNOWN, dispatcher.dispatch("reboot", doc.as<JsonObjectConst>(), result));
+    TEST_ASSERT_EQUAL_INT(1, calls);
+}
+
+void test_filter_drops_fields_handlers_do_not_read() {
+    const char payload[] =
+        "{\"command\":\"flash_identify\",\"duration\":15,\"request_id\":\"r-42\","
+        "\"padding\":\"xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx\","
+        "\"nested\":{\"a\":[1,2,3,{\"b\":true}]},\"numbers\":[1,2,3,4,5,6,7,8]}";
+    JsonDocument doc(&commandPool);
+    TEST_ASSERT_TRUE(parseCommand(doc, payload, sizeof(payload) - 1) == DeserializationError::Ok);
+
+    TEST_ASSERT_EQUAL_UINT32(3, doc.size());
+    TEST_ASSERT_EQUAL_STRING("flash_identify", doc["command"].as<const char*>());
+    TEST_ASSERT_EQUAL_UINT32(15, doc["duration"].as<uint32_t>());
+    TEST_ASSERT_EQUAL_STRING("r-42", doc["request_id"].as<const char*>());
+    TEST_ASSERT_TRUE(doc["padding"].isNull());
+    TEST_ASSERT_TRUE(doc["nested"].isNull());
+
+    // Skipped fields take no pool memory: same use as the bare command
+    size_t filteredUsed = commandPool.getUsed();
+    const char bare[] = "{\"command\":\"flash_identify\",\"duration\":15,\"request_id\":\"r-42\"}";
+    JsonDocument bareDoc(&commandPool);
+    TEST_ASSERT_TRUE(parseCommand(bareDoc, bare, sizeof(bare) - 1) == DeserializationError::Ok);
+    TEST_ASSERT_EQUAL_UINT32(commandPool.getUsed(), filteredUsed);
+}
+
+void test_fuzzed_payloads_stay_in_the_pool() {
+    // Mutations of valid commands plus random bytes; the payload is not
+    // NUL-terminated, as in the MQTT buffer. Nothing may crash or escape
+    // the fixed pool, and any parsed command must still look up safely.
+    const char* seeds[] = {
+        "{\"command\":\"flash_identify\",\"duration\":10}",
+        "{\"command\":\"get_status\",\"request_id\":\"abc\"}",
+        "{\"command\":\"set_line_state\",\"state\":\"maintenance\",\"request_id\":\"x\"}",
+        "{\"command\":[\"get_status\"],\"state\":{\"a\":1},\"duration\":-1e400}",
+    };
+    const char alphabet[] = "{}[]\":,\\0123456789.eE+-truefalsnl_abcdxyz \t\n\x01\xff";
+
+    std::mt19937 rng(2024);
+    uint32_t parsed = 0;
+    uint32_t known = 0;
+    char payload[MQTT_COMMAND_MAX_LENGTH];
+
+    for (int iteration = 0; iteration < 200000; iteration++) {
+        size_t length;
+        if (iteration % 4 == 3) {
+            length = rng() % sizeof(payload);
+            for (size_t i = 0; i < length; i++) {
+                payload[i] = (char)rng();
+            }
+        } else {
+            const char* seed = seeds[rng() % 4];
+            length = strlen(seed);
+            memcpy(payload, seed, length);
+            int mutations = 1 + rng() % 4;
+            for (int m = 0; m < mutations && length > 0; m++) {
+                size_t at = rng() % length;
+                switch (rng() % 3) {
+                    case 0:  // Replace
+                        payload[at] = alphabet[rng() % (sizeof(alphabet) - 1)];
+                        break;
+                    case 1:  // Truncate
+                        length = at;
+                        break;
+                    default:  // Duplicate a span (nesting, repeated keys)
+                        size_t span = 1 + rng() % 16;
+                        if (at + span <= length && length + span <= sizeof(payload)) {
+                            memmove(payload + at + span, payload + at, length - at);
+                            length += span;
+                        }
+                        break;
+                }
+            }
+        }
+
+        JsonDocument doc(&commandPool);
+        DeserializationError error = parseCommand(doc, payload, length);
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(sizeof(poolBuffer), commandPool.getUsed());
+        if (!error) {
+            parsed++;
+            const char* command = doc["command"] | "";
+            if (CommandDispatcher::lookup(command) != CMD_COUNT) {
+                known++;
+            }
+        }
+    }
+
+    char line[96];
+    snprintf(line, sizeof(line), "200000 payloads: %u parsed, %u known commands, %u pool failures",
+             (unsigned)parsed, (unsigned)known, (unsigned)commandPool.getFailCount());
+    TEST_MESSAGE(line);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, known);
+}
+
+void test_benchmark_parse_and_lookup() {
+    const char payload[] =
+        "{\"command\":\"set_line_state\",\"state\":\"running\",\"request_id\":\"7f3e2a\","
+        "\"issued_by\":\"line-controller\",\"meta\":{\"shift\":2,\"operator\":\"n/a\"}}";
+    const int iterations = 200000;
+    volatile uint8_t sink = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        JsonDocument doc(&commandPool);
+        parseCommand(doc, payload, sizeof(payload) - 1);
+        sink ^= CommandDispatcher::lookup(doc["command"] | "");
+    }
+    double parseNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations;
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        sink ^= CommandDispatcher::lookup((i & 1) ? "set_line_state" : "reboot_now");
+    }
+    double lookupNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations;
+    (void)sink;
+
+    char line[128];
+    snprintf(line, sizeof(line), "filtered parse + lookup %.0f ns/command, lookup alone %.1f ns",
+             parseNs, lookupNs);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_EQUAL_UINT32(0, commandPool.getFailCount());
+}
+
+int main() {
+    CommandDispatcher::buildFilter(commandFilter);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_lookup_known_names);
+    RUN_TEST(test_lookup_rejects_unknown_and_near_misses);
+    RUN_TEST(test_dispatch_runs_registered_handler);
+    RUN_TEST(test_filter_drops_fields_handlers_do_not_read);
+    RUN_TEST(test_fuzzed_payloads_stay_in_the_pool);
+    RUN_TEST(test_benchmark_parse_and_lookup);
+    return UNITY_END();
+}
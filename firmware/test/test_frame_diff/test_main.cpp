@@ -0,0 +1,135 @@
+// FrameDiff: bytes sent to the SSD1306 per display update scenario
+// (native env: pio test -e native)
+
+#include <unity.h>
+#include <string.h>
+#include "config.h"
+#include "display/frame_diff.h"
+
+// Same chunking as DisplayManager (I2CRequest::MAX_DATA - 1)
+static const uint8_t CHUNK_SIZE = 32;
+static const size_t FRAME_SIZE = DISPLAY_WIDTH * DISPLAY_HEIGHT / 8;
+
+static uint8_t current[FRAME_SIZE];
+static uint8_t sent[FRAME_SIZE];
+
+void setUp() {
+    for (size_t i = 0; i < FRAME_SIZE; i++) {
+        current[i] = (uint8_t)(i * 7);
+    }
+    memcpy(sent, current, FRAME_SIZE);
+}
+
+void tearDown() {}
+
+// Draw one 6-pixel text cell (text size 1) at a column of a page
+static void drawGlyph(uint8_t page, uint8_t column, uint8_t seed) {
+    for (uint8_t x = 0; x < 6; x++) {
+        current[page * DISPLAY_WIDTH + column + x] ^= (uint8_t)(seed + x) | 0x01;
+    }
+}
+
+static void report(const char* scenario, const FrameDiff& diff) {
+    char line[128];
+    snprintf(line, sizeof(line), "%-22s %4u bytes, %2u transfers",
+             scenario, (unsigned)diff.getBytes(), (unsigned)diff.getRequests());
+    TEST_MESSAGE(line);
+}
+
+void test_first_frame_is_sent_in_full() {
+    FrameDiff diff(CHUNK_SIZE);
+    diff.compare(current, sent, false, 0);
+    report("first frame", diff);
+
+    // Every page: window + 128 columns in 4 chunks, each with a control byte
+    const uint32_t chunks = (DISPLAY_WIDTH + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    TEST_ASSERT_EQUAL_UINT32(FrameDiff::PAGES * (1 + chunks), diff.getRequests());
+    TEST_ASSERT_EQUAL_UINT32(FrameDiff::PAGES * (FrameDiff::WINDOW_BYTES + DISPLAY_WIDTH + chunks),
+                             diff.getBytes());
+    for (uint8_t page = 0; page < FrameDiff::PAGES; page++) {
+        TEST_ASSERT_TRUE(diff.changed(page));
+        TEST_ASSERT_EQUAL_UINT8(0, diff.firstColumn(page));
+        TEST_ASSERT_EQUAL_UINT8(DISPLAY_WIDTH - 1, diff.lastColumn(page));
+    }
+}
+
+void test_unchanged_frame_sends_nothing() {
+    FrameDiff diff(CHUNK_SIZE);
+    TEST_ASSERT_EQUAL_UINT32(0, diff.compare(current, sent, true, 0));
+    report("no change", diff);
+
+    TEST_ASSERT_EQUAL_UINT32(0, diff.getBytes());
+    for (uint8_t page = 0; page < FrameDiff::PAGES; page++) {
+        TEST_ASSERT_FALSE(diff.changed(page));
+    }
+}
+
+void test_uptime_tick_sends_one_window() {
+    // Seconds digit of "Uptime: ..." (y = 32 -> page 4), one glyph
+    drawGlyph(4, 102, 0x3c);
+
+    FrameDiff diff(CHUNK_SIZE);
+    diff.compare(current, sent, true, 0);
+    report("uptime tick (1 digit)", diff);
+
+    TEST_ASSERT_EQUAL_UINT32(2, diff.getRequests());
+    TEST_ASSERT_EQUAL_UINT32(FrameDiff::WINDOW_BYTES + 6 + 1, diff.getBytes());
+    TEST_ASSERT_EQUAL_UINT8(102, diff.firstColumn(4));
+    TEST_ASSERT_EQUAL_UINT8(107, diff.lastColumn(4));
+}
+
+void test_uptime_and_rssi_change() {
+    // Minute rollover (three digits) and a new RSSI value on page 1
+    drawGlyph(4, 66, 0x11);
+    drawGlyph(4, 90, 0x22);
+    drawGlyph(4, 102, 0x33);
+    drawGlyph(1, 42, 0x44);
+    drawGlyph(1, 48, 0x55);
+
+    FrameDiff diff(CHUNK_SIZE);
+    diff.compare(current, sent, true, 0);
+    report("minute + rssi", diff);
+
+    // Page 4: columns 66..107 (42 bytes, 2 chunks); page 1: 42..53 (12 bytes, 1 chunk)
+    TEST_ASSERT_EQUAL_UINT32(2 + 3, diff.getRequests());
+    TEST_ASSERT_EQUAL_UINT32((FrameDiff::WINDOW_BYTES + 42 + 2) + (FrameDiff::WINDOW_BYTES + 12 + 1),
+                             diff.getBytes());
+    TEST_ASSERT_FALSE(diff.changed(0));
+    TEST_ASSERT_TRUE(diff.changed(1));
+    TEST_ASSERT_TRUE(diff.changed(4));
+}
+
+void test_failed_page_is_resent_in_full() {
+    // Nothing changed, but the bus task reported page 6 failed
+    FrameDiff diff(CHUNK_SIZE);
+    diff.compare(current, sent, true, 1 << 6);
+    report("resend failed page", diff);
+
+    const uint32_t chunks = (DISPLAY_WIDTH + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    TEST_ASSERT_EQUAL_UINT32(1 + chunks, diff.getRequests());
+    TEST_ASSERT_EQUAL_UINT32(FrameDiff::WINDOW_BYTES + DISPLAY_WIDTH + chunks, diff.getBytes());
+    TEST_ASSERT_EQUAL_UINT8(0, diff.firstColumn(6));
+    TEST_ASSERT_EQUAL_UINT8(DISPLAY_WIDTH - 1, diff.lastColumn(6));
+}
+
+void test_changed_edge_columns() {
+    // First and last column of a page: the range spans the whole page
+    current[3 * DISPLAY_WIDTH] ^= 0xff;
+    current[3 * DISPLAY_WIDTH + DISPLAY_WIDTH - 1] ^= 0xff;
+
+    FrameDiff diff(CHUNK_SIZE);
+    diff.compare(current, sent, true, 0);
+    TEST_ASSERT_EQUAL_UINT8(0, diff.firstColumn(3));
+    TEST_ASSERT_EQUAL_UINT8(DISPLAY_WIDTH - 1, diff.lastColumn(3));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_first_frame_is_sent_in_full);
+    RUN_TEST(test_unchanged_frame_sends_nothing);
+    RUN_TEST(test_uptime_tick_sends_one_window);
+    RUN_TEST(test_uptime_and_rssi_change);
+    RUN_TEST(test_failed_page_is_resent_in_full);
+    RUN_TEST(test_changed_edge_columns);
+    return UNITY_END();
+}
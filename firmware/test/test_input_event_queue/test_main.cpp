@@ -0,0 +1,140 @@
+// InputEventQueue: ordering, overflow accounting and 1 kHz edge bursts
+// delivered through a fake ISR (native env: pio test -e native)
+
+#include <unity.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "config.h"
+#include "gpio/input_event_queue.h"
+
+typedef InputEventQueue<INPUT_EVENT_QUEUE_SIZE> EdgeQueue;
+
+static EdgeQueue* queue;
+
+// Fake GPIO ISR: same call the real onEdgeISR makes
+static bool fakeISR(uint8_t channel, uint8_t level, uint64_t timestampUs) {
+    return queue->push(channel, level, timestampUs);
+}
+
+void setUp() {
+    queue = new EdgeQueue();
+}
+
+void tearDown() {
+    delete queue;
+}
+
+void test_events_come_out_in_order() {
+    for (uint16_t i = 0; i < 100; i++) {
+        TEST_ASSERT_TRUE(fakeISR(i % 8, i & 1, 1000ULL + i));
+    }
+    TEST_ASSERT_EQUAL(100, queue->size());
+
+    InputEdgeEvent event;
+    for (uint16_t i = 0; i < 100; i++) {
+        TEST_ASSERT_TRUE(queue->pop(event));
+        TEST_ASSERT_EQUAL(i % 8, event.channel);
+        TEST_ASSERT_EQUAL(i & 1, event.level);
+        TEST_ASSERT_EQUAL_UINT64(1000ULL + i, event.timestampUs);
+    }
+    TEST_ASSERT_FALSE(queue->pop(event));
+    TEST_ASSERT_TRUE(queue->isEmpty());
+}
+
+void test_full_queue_drops_and_counts() {
+    const uint16_t capacity = EdgeQueue::capacity();
+    for (uint16_t i = 0; i < capacity + 5; i++) {
+        fakeISR(0, i & 1, i);
+    }
+
+    TEST_ASSERT_EQUAL(capacity, queue->size());
+    TEST_ASSERT_EQUAL_UINT32(5, queue->getDroppedCount());
+    TEST_ASSERT_EQUAL(capacity, queue->getHighWaterMark());
+
+    // The oldest events survive, the overflow is lost
+    InputEdgeEvent event;
+    TEST_ASSERT_TRUE(queue->pop(event));
+    TEST_ASSERT_EQUAL_UINT64(0, event.timestampUs);
+}
+
+void test_1khz_edges_survive_a_consumer_stall() {
+    // One edge per ms for 2 s (simulated), drained once per 1 ms I/O tick -
+    // except for a 200 ms stall in the middle
+    const uint32_t durationMs = 2000;
+    const uint32_t stallStartMs = 900;
+    const uint32_t stallMs = 200;
+    TEST_ASSERT_LESS_THAN(EdgeQueue::capacity(), stallMs);
+
+    uint32_t received = 0;
+    InputEdgeEvent event;
+
+    for (uint32_t ms = 0; ms < durationMs; ms++) {
+        uint64_t edgeUs = (uint64_t)ms * 1000 + 137;  // Edges are not tick-aligned
+        fakeISR(ms % 8, (ms / 8) & 1, edgeUs);
+
+        bool stalled = ms >= stallStartMs && ms < stallStartMs + stallMs;
+        if (stalled) {
+            continue;
+        }
+        while (queue->pop(event)) {
+            TEST_ASSERT_EQUAL_UINT64((uint64_t)received * 1000 + 137, event.timestampUs);
+            TEST_ASSERT_EQUAL(received % 8, event.channel);
+            received++;
+        }
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(durationMs, received);
+    TEST_ASSERT_EQUAL_UINT32(0, queue->getDroppedCount());
+    TEST_ASSERT_GREATER_OR_EQUAL(stallMs, queue->getHighWaterMark());
+}
+
+void test_concurrent_isr_and_consumer() {
+    // Real concurrency: a producer thread plays the ISR (bursts of 8 edges -
+    // all channels switching together - every 8 ms, 1 kHz on average) while
+    // the consumer drains on a 1 ms tick, as the I/O task does
+    const uint32_t bursts = 60;
+    const uint32_t total = bursts * 8;
+    std::atomic<bool> done(false);
+
+    std::thread isr([&]() {
+        auto next = std::chrono::steady_clock::now();
+        uint64_t sequence = 0;
+        for (uint32_t b = 0; b < bursts; b++) {
+            for (uint8_t channel = 0; channel < 8; channel++) {
+                fakeISR(channel, b & 1, sequence++);
+            }
+            next += std::chrono::milliseconds(8);
+            std::this_thread::sleep_until(next);
+        }
+        done = true;
+    });
+
+    // Checked after join() - a failing assert must not unwind past the thread
+    uint64_t expected = 0;
+    uint32_t outOfOrder = 0;
+    InputEdgeEvent event;
+    while (!done || !queue->isEmpty()) {
+        while (queue->pop(event)) {
+            if (event.timestampUs != expected || event.channel != expected % 8) {
+                outOfOrder++;
+            }
+            expected++;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    isr.join();
+
+    TEST_ASSERT_EQUAL_UINT32(0, outOfOrder);
+    TEST_ASSERT_EQUAL_UINT64(total, expected);
+    TEST_ASSERT_EQUAL_UINT32(0, queue->getDroppedCount());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_events_come_out_in_order);
+    RUN_TEST(test_full_queue_drops_and_counts);
+    RUN_TEST(test_1khz_edges_survive_a_consumer_stall);
+    RUN_TEST(test_concurrent_isr_and_consumer);
+    return UNITY_END();
+}
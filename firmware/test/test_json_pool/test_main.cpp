@@ -0,0 +1,208 @@
+// JsonPoolAllocator: bump/rewind behaviour, heap fallback, and PayloadBuffer
+// (the publishDocument() path) for payloads over 4 KB (native env: pio test -e native)
+
+#include <unity.h>
+#include <string>
+#include "config.h"
+#include "mqtt/json_pool.h"
+#include "mqtt/payload_buffer.h"
+
+alignas(8) static uint8_t small[256];
+alignas(8) static uint8_t messageRegion[MQTT_MESSAGE_ARENA_SIZE];
+
+void setUp() {}
+void tearDown() {}
+
+// Status keyframe with enough diagnostics to pass 4 KB
+static void buildLargeStatus(JsonDocument& doc, int entries) {
+    doc["device_id"] = "AA:BB:CC:DD:EE:FF";
+    doc["boot_seq"] = 12;
+    doc["line_state"] = "running";
+    JsonArray history = doc["history"].to<JsonArray>();
+    for (int i = 0; i < entries; i++) {
+        JsonObject entry = history.add<JsonObject>();
+        entry["seq"] = i;
+        entry["event"] = (i & 1) ? "input_change" : "line_state";
+        entry["timestamp"] = 1760620000000ULL + i * 1000ULL;
+        char note[32];
+        snprintf(note, sizeof(note), "channel %d settled", i % 8);  // Copied into the pool
+        entry["note"] = note;
+    }
+}
+
+void test_bump_allocation_is_aligned() {
+    JsonPoolAllocator pool(small, sizeof(small));
+    uint8_t* a = (uint8_t*)pool.allocate(3);
+    uint8_t* b = (uint8_t*)pool.allocate(5);
+    TEST_ASSERT_NOT_NULL(a);
+    TEST_ASSERT_NOT_NULL(b);
+    TEST_ASSERT_EQUAL_UINT32(0, (uintptr_t)a % 8);
+    TEST_ASSERT_EQUAL_UINT32(0, (uintptr_t)b % 8);
+    TEST_ASSERT_EQUAL_UINT32(16, b - a);           // 8-byte header + 8 bytes
+    TEST_ASSERT_EQUAL_UINT32(32, pool.getUsed());
+
+    pool.reset();
+    TEST_ASSERT_EQUAL_UINT32(0, pool.getUsed());
+    TEST_ASSERT_EQUAL_UINT32(32, pool.getHighWater());
+}
+
+void test_only_the_last_block_is_freed_or_grown_in_place() {
+    JsonPoolAllocator pool(small, sizeof(small));
+    void* a = pool.allocate(16);
+    void* b = pool.allocate(16);
+
+    // Last block grows in place
+    TEST_ASSERT_TRUE(pool.reallocate(b, 40) == b);
+    TEST_ASSERT_EQUAL_UINT32(24 + 48, pool.getUsed());
+
+    // An earlier block cannot move back - freeing it waits for the reset
+    pool.deallocate(a);
+    TEST_ASSERT_EQUAL_UINT32(72, pool.getUsed());
+    pool.deallocate(b);
+    TEST_ASSERT_EQUAL_UINT32(24, pool.getUsed());
+
+    // Growing a block that is no longer last copies it
+    void* c = pool.allocate(8);
+    memset(a, 0x5a, 16);
+    uint8_t* moved = (uint8_t*)pool.reallocate(a, 32);
+    TEST_ASSERT_TRUE(moved != a);
+    TEST_ASSERT_EQUAL_HEX8(0x5a, moved[15]);
+    (void)c;
+}
+
+void test_scopes_rewind_nested_allocations() {
+    JsonPoolAllocator pool(small, sizeof(small));
+    pool.allocate(8);
+    size_t outer = pool.getUsed();
+    {
+        JsonPoolScope scope(pool);
+        pool.allocate(24);
+        {
+            JsonPoolScope inner(pool);
+            pool.allocate(40);
+        }
+        TEST_ASSERT_EQUAL_UINT32(outer + 32, pool.getUsed());
+    }
+    TEST_ASSERT_EQUAL_UINT32(outer, pool.getUsed());
+}
+
+void test_exhausted_pool_fails_without_fallback() {
+    JsonPoolAllocator pool(small, sizeof(small));
+    TEST_ASSERT_NULL(pool.allocate(sizeof(small)));
+    TEST_ASSERT_EQUAL_UINT32(1, pool.getFailCount());
+    TEST_ASSERT_EQUAL_UINT32(0, pool.getFallbackCount());
+
+    // A document that does not fit reports NoMemory instead of overrunning
+    JsonDocument doc(&pool);
+    const char json[] = "{\"command\":\"get_status\"}";
+    TEST_ASSERT_TRUE(deserializeJson(doc, json) == DeserializationError::NoMemory);
+}
+
+void test_heap_fallback_keeps_content() {
+    JsonPoolAllocator pool(small, sizeof(small), true);
+    std::string expected;
+    std::string actual;
+    {
+        JsonDocument reference;
+        buildLargeStatus(reference, 20);
+        serializeJson(reference, expected);
+    }
+    {
+        JsonPoolScope scope(pool);
+        JsonDocument doc(&pool);
+        buildLargeStatus(doc, 20);
+        TEST_ASSERT_FALSE(doc.overflowed());
+        serializeJson(doc, actual);
+    }
+    TEST_ASSERT_TRUE(pool.getFallbackCount() > 0);
+    TEST_ASSERT_EQUAL_UINT32(pool.getFallbackCount(), pool.getFailCount());
+    TEST_ASSERT_TRUE(expected == actual);
+}
+
+void test_small_payload_stays_on_the_stack() {
+    JsonPoolAllocator arena(messageRegion, sizeof(messageRegion), true);
+    JsonDocument doc(&arena);
+    doc["device_id"] = "AA:BB:CC:DD:EE:FF";
+    doc["line_state"] = "running";
+
+    size_t before = arena.getUsed();
+    PayloadBuffer payload(arena);
+    TEST_ASSERT_EQUAL_UINT8(PayloadBuffer::PAYLOAD_OK, payload.serialize(doc, false));
+    TEST_ASSERT_TRUE(payload.onStack());
+    TEST_ASSERT_EQUAL_UINT32(before, arena.getUsed());
+    TEST_ASSERT_EQUAL_STRING("{\"device_id\":\"AA:BB:CC:DD:EE:FF\",\"line_state\":\"running\"}", payload.data());
+}
+
+void test_payload_over_4kb_is_published_whole() {
+    JsonPoolAllocator arena(messageRegion, sizeof(messageRegion), true);
+    JsonPoolScope scope(arena);
+    JsonDocument doc(&arena);
+    buildLargeStatus(doc, 80);
+    TEST_ASSERT_FALSE(doc.overflowed());
+
+    std::string reference;
+    serializeJson(doc, reference);
+    size_t documentUsed = arena.getUsed();
+
+    {
+        PayloadBuffer payload(arena);
+        TEST_ASSERT_EQUAL_UINT8(PayloadBuffer::PAYLOAD_OK, payload.serialize(doc, false));
+        char line[96];
+        snprintf(line, sizeof(line), "payload %u bytes, arena high water %u of %u",
+                 (unsigned)payload.length(), (unsigned)arena.getHighWater(), (unsigned)arena.getCapacity());
+        TEST_MESSAGE(line);
+
+        TEST_ASSERT_FALSE(payload.onStack());
+        TEST_ASSERT_GREATER_THAN_UINT32(4096, payload.length());
+        TEST_ASSERT_EQUAL_UINT32(payload.measured(), payload.length());
+        TEST_ASSERT_TRUE(reference == std::string(payload.data(), payload.length()));  // No truncation
+        TEST_ASSERT_EQUAL_UINT32(0, arena.getFallbackCount());  // Document and payload fit the arena
+    }
+    // Arena block released with the payload
+    TEST_ASSERT_EQUAL_UINT32(documentUsed, arena.getUsed());
+
+    // MessagePack: measured length is exactly what gets written
+    PayloadBuffer packed(arena);
+    TEST_ASSERT_EQUAL_UINT8(PayloadBuffer::PAYLOAD_OK, packed.serialize(doc, true));
+    TEST_ASSERT_EQUAL_UINT32(measureMsgPack(doc), packed.length());
+    TEST_ASSERT_LESS_THAN_UINT32(reference.size(), packed.length());
+}
+
+void test_payload_over_limit_is_refused() {
+    JsonPoolAllocator arena(messageRegion, sizeof(messageRegion), true);
+    JsonPoolScope scope(arena);
+    JsonDocument doc(&arena);
+    buildLargeStatus(doc, 400);
+
+    size_t before = arena.getUsed();
+    PayloadBuffer payload(arena);
+    TEST_ASSERT_EQUAL_UINT8(PayloadBuffer::PAYLOAD_TOO_LARGE, payload.serialize(doc, false));
+    TEST_ASSERT_GREATER_THAN_UINT32(MQTT_MAX_PAYLOAD_SIZE, payload.measured());
+    TEST_ASSERT_EQUAL_UINT32(0, payload.length());
+    TEST_ASSERT_EQUAL_UINT32(before, arena.getUsed());  // Refused before allocating
+}
+
+void test_payload_without_arena_space_is_refused() {
+    // Message arena without heap fallback, too small for the payload block
+    JsonPoolAllocator arena(small, sizeof(small));
+    JsonDocument doc;
+    buildLargeStatus(doc, 20);
+
+    PayloadBuffer payload(arena);
+    TEST_ASSERT_EQUAL_UINT8(PayloadBuffer::PAYLOAD_NO_MEMORY, payload.serialize(doc, false));
+    TEST_ASSERT_EQUAL_UINT32(0, payload.length());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_bump_allocation_is_aligned);
+    RUN_TEST(test_only_the_last_block_is_freed_or_grown_in_place);
+    RUN_TEST(test_scopes_rewind_nested_allocations);
+    RUN_TEST(test_exhausted_pool_fails_without_fallback);
+    RUN_TEST(test_heap_fallback_keeps_content);
+    RUN_TEST(test_small_payload_stays_on_the_stack);
+    RUN_TEST(test_payload_over_4kb_is_published_whole);
+    RUN_TEST(test_payload_over_limit_is_refused);
+    RUN_TEST(test_payload_without_arena_space_is_refused);
+    return UNITY_END();
+}
@@ -0,0 +1,148 @@
+// Payload encoding: size and serialize time of MessagePack against JSON for
+// the status, input-change and counter messages (native env: pio test -e native)
+
+#include <unity.h>
+#include <chrono>
+#include "config.h"
+#include "mqtt/json_pool.h"
+
+static uint8_t arena[MQTT_DOCUMENT_ARENA_SIZE];
+static JsonPoolAllocator pool(arena, sizeof(arena));
+
+static const char* DEVICE_ID = "AA:BB:CC:DD:EE:FF";
+static const uint64_t EPOCH_US = 1760620000123456ULL;
+
+void setUp() {}
+void tearDown() {}
+
+// Same fields and order as MQTTClientManager::addTimestamp()
+static void addTimestamp(JsonDocument& doc) {
+    doc["timestamp"] = EPOCH_US / 1000;
+    doc["epoch_us"] = EPOCH_US;
+    doc["time_synced"] = true;
+}
+
+// Live status event (publishEvent, line state change)
+static void buildStatus(JsonDocument& doc) {
+    doc["device_id"] = DEVICE_ID;
+    doc["seq"] = 4711;
+    doc["line_state"] = "running";
+    doc["digital_inputs"] = 0x05;
+    doc["digital_outputs"] = 0x02;
+    doc["network_connected"] = true;
+    doc["assigned_line"] = nullptr;
+    addTimestamp(doc);
+    doc["timestamp_us"] = 86400123456ULL;
+}
+
+// Live input change (publishEvent, input change)
+static void buildInputChange(JsonDocument& doc) {
+    doc["device_id"] = DEVICE_ID;
+    doc["seq"] = 4712;
+    doc["channel"] = 3;
+    doc["state"] = true;
+    doc["all_inputs"] = 0x0d;
+    addTimestamp(doc);
+    doc["timestamp_us"] = 86400223456ULL;
+}
+
+// Counters with four channels (publishCounters / addCounters)
+static void buildCounters(JsonDocument& doc) {
+    doc["device_id"] = DEVICE_ID;
+    JsonArray channels = doc["ch"].to<JsonArray>();
+    JsonArray totals = doc["total"].to<JsonArray>();
+    JsonArray rates = doc["ppm"].to<JsonArray>();
+    for (uint8_t ch = 0; ch < 4; ch++) {
+        channels.add(ch);
+        totals.add(125000UL + ch * 3301UL);
+        rates.add(42.5f + ch);
+    }
+    addTimestamp(doc);
+}
+
+struct Encoded {
+    size_t jsonBytes;
+    size_t msgpackBytes;
+    double jsonNs;
+    double msgpackNs;
+};
+
+static Encoded encode(const char* name, void (*build)(JsonDocument&)) {
+    const int iterations = 20000;
+    JsonPoolScope scope(pool);
+    JsonDocument doc(&pool);
+    build(doc);
+    TEST_ASSERT_FALSE(doc.overflowed());
+
+    Encoded result;
+    char buffer[MQTT_MAX_PAYLOAD_SIZE];
+    size_t written = 0;
+
+    // Same sequence as publishDocument(): measure, then serialize into length + 1
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        result.jsonBytes = measureJson(doc);
+        written = serializeJson(doc, buffer, result.jsonBytes + 1);
+    }
+    result.jsonNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations;
+    TEST_ASSERT_EQUAL_UINT32(result.jsonBytes, written);
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        result.msgpackBytes = measureMsgPack(doc);
+        written = serializeMsgPack(doc, buffer, result.msgpackBytes + 1);
+    }
+    result.msgpackNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations;
+    TEST_ASSERT_EQUAL_UINT32(result.msgpackBytes, written);
+
+    char line[160];
+    snprintf(line, sizeof(line), "%-12s json %3u B %6.0f ns, msgpack %3u B %6.0f ns (%.0f%% of json size)",
+             name, (unsigned)result.jsonBytes, result.jsonNs, (unsigned)result.msgpackBytes,
+             result.msgpackNs, 100.0 * result.msgpackBytes / result.jsonBytes);
+    TEST_MESSAGE(line);
+    return result;
+}
+
+void test_msgpack_round_trips_to_the_same_document() {
+    JsonPoolScope scope(pool);
+    JsonDocument doc(&pool);
+    buildStatus(doc);
+
+    uint8_t packed[MQTT_MAX_PAYLOAD_SIZE];
+    size_t length = serializeMsgPack(doc, packed, sizeof(packed));
+    TEST_ASSERT_EQUAL_UINT32(measureMsgPack(doc), length);
+
+    // The API converts MessagePack to JSON before decoding - must be identical
+    JsonDocument decoded(&pool);
+    TEST_ASSERT_TRUE(deserializeMsgPack(decoded, packed, length) == DeserializationError::Ok);
+
+    char expected[MQTT_MAX_PAYLOAD_SIZE];
+    char actual[MQTT_MAX_PAYLOAD_SIZE];
+    serializeJson(doc, expected, sizeof(expected));
+    serializeJson(decoded, actual, sizeof(actual));
+    TEST_ASSERT_EQUAL_STRING(expected, actual);
+
+    // 64-bit timestamps survive the binary encoding
+    TEST_ASSERT_TRUE(decoded["epoch_us"].as<uint64_t>() == EPOCH_US);
+}
+
+void test_msgpack_is_smaller_for_every_message_class() {
+    Encoded status = encode("status", buildStatus);
+    Encoded input = encode("input_change", buildInputChange);
+    Encoded counters = encode("counters", buildCounters);
+
+    TEST_ASSERT_LESS_THAN(status.jsonBytes, status.msgpackBytes);
+    TEST_ASSERT_LESS_THAN(input.jsonBytes, input.msgpackBytes);
+    TEST_ASSERT_LESS_THAN(counters.jsonBytes, counters.msgpackBytes);
+
+    // The JSON forms fit the payload limit publishDocument() enforces
+    TEST_ASSERT_LESS_OR_EQUAL(MQTT_MAX_PAYLOAD_SIZE, status.jsonBytes);
+    TEST_ASSERT_LESS_OR_EQUAL(MQTT_MAX_PAYLOAD_SIZE, counters.jsonBytes);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_msgpack_round_trips_to_the_same_document);
+    RUN_TEST(test_msgpack_is_smaller_for_every_message_class);
+    return UNITY_END();
+}
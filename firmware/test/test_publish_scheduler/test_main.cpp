@@ -0,0 +1,183 @@
+// PublishScheduler: phase properties and a 500-device fleet simulation of the
+// per-second broker message rate (native env: pio test -e native)
+
+#include <unity.h>
+#include <vector>
+#include "config.h"
+#include "mqtt/publish_scheduler.h"
+
+static const int FLEET_SIZE = 500;
+static const unsigned long LOOP_STEP_MS = 10;        // loop() period in the simulation
+static const unsigned long SIMULATED_MS = 600000;    // 10 minutes
+
+void setUp() {
+    ArduinoStub::nowMs = 0;
+}
+
+void tearDown() {}
+
+// Consecutive MACs, as in one delivery batch of boards
+static void fleetMAC(int index, char* buffer, size_t size) {
+    snprintf(buffer, size, "24:6F:28:%02X:%02X:%02X",
+             (index >> 16) & 0xff, (index >> 8) & 0xff, index & 0xff);
+}
+
+struct RateStats {
+    double mean;
+    double variance;
+    uint32_t peak;
+};
+
+static RateStats rateStats(const std::vector<uint32_t>& perSecond) {
+    RateStats stats = {0, 0, 0};
+    for (uint32_t count : perSecond) {
+        stats.mean += count;
+        if (count > stats.peak) {
+            stats.peak = count;
+        }
+    }
+    stats.mean /= perSecond.size();
+    for (uint32_t count : perSecond) {
+        stats.variance += (count - stats.mean) * (count - stats.mean);
+    }
+    stats.variance /= perSecond.size();
+    return stats;
+}
+
+static void report(const char* name, const RateStats& stats) {
+    char line[128];
+    snprintf(line, sizeof(line), "%-8s mean %.1f msg/s, variance %9.1f, peak %u msg/s",
+             name, stats.mean, stats.variance, (unsigned)stats.peak);
+    TEST_MESSAGE(line);
+}
+
+void test_phase_is_deterministic_and_within_interval() {
+    PublishScheduler a;
+    PublishScheduler b;
+    a.begin("24:6F:28:00:01:02");
+    b.begin("24:6F:28:00:01:02");
+
+    for (uint8_t task = 0; task < PublishScheduler::TASK_COUNT; task++) {
+        PublishScheduler::Task t = (PublishScheduler::Task)task;
+        TEST_ASSERT_EQUAL_UINT32(a.getPhase(t, HEARTBEAT_INTERVAL), b.getPhase(t, HEARTBEAT_INTERVAL));
+        TEST_ASSERT_LESS_THAN_UINT32(HEARTBEAT_INTERVAL, a.getPhase(t, HEARTBEAT_INTERVAL));
+        TEST_ASSERT_LESS_THAN_UINT32(ANNOUNCEMENT_INTERVAL, a.getPhase(t, ANNOUNCEMENT_INTERVAL));
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, a.getPhase(PublishScheduler::TASK_HEARTBEAT, 0));
+
+    // Tasks of one device get different offsets
+    TEST_ASSERT_TRUE(a.getPhase(PublishScheduler::TASK_HEARTBEAT, HEARTBEAT_INTERVAL) !=
+                     a.getPhase(PublishScheduler::TASK_ANNOUNCEMENT, HEARTBEAT_INTERVAL));
+}
+
+void test_first_due_schedules_at_phase_then_every_interval() {
+    PublishScheduler scheduler;
+    scheduler.begin("24:6F:28:00:00:07");
+    uint32_t phase = scheduler.getPhase(PublishScheduler::TASK_HEARTBEAT, HEARTBEAT_INTERVAL);
+
+    ArduinoStub::nowMs = 5000;
+    TEST_ASSERT_FALSE(scheduler.due(PublishScheduler::TASK_HEARTBEAT, HEARTBEAT_INTERVAL));
+
+    if (phase > 0) {
+        ArduinoStub::nowMs = 5000 + phase - 1;
+        TEST_ASSERT_FALSE(scheduler.due(PublishScheduler::TASK_HEARTBEAT, HEARTBEAT_INTERVAL));
+    }
+    ArduinoStub::nowMs = 5000 + phase;
+    TEST_ASSERT_TRUE(scheduler.due(PublishScheduler::TASK_HEARTBEAT, HEARTBEAT_INTERVAL));
+    TEST_ASSERT_FALSE(scheduler.due(PublishScheduler::TASK_HEARTBEAT, HEARTBEAT_INTERVAL));
+
+    ArduinoStub::nowMs = 5000 + phase + HEARTBEAT_INTERVAL;
+    TEST_ASSERT_TRUE(scheduler.due(PublishScheduler::TASK_HEARTBEAT, HEARTBEAT_INTERVAL));
+}
+
+void test_missed_slots_are_skipped() {
+    PublishScheduler scheduler;
+    scheduler.begin("24:6F:28:00:00:08");
+    uint32_t phase = scheduler.getPhase(PublishScheduler::TASK_COUNTERS, COUNTER_PUBLISH_INTERVAL);
+
+    scheduler.due(PublishScheduler::TASK_COUNTERS, COUNTER_PUBLISH_INTERVAL);
+    ArduinoStub::nowMs = phase;
+    TEST_ASSERT_TRUE(scheduler.due(PublishScheduler::TASK_COUNTERS, COUNTER_PUBLISH_INTERVAL));
+
+    // Loop stalled for five intervals: one publish, not five
+    ArduinoStub::nowMs = phase + 5 * COUNTER_PUBLISH_INTERVAL + 1;
+    TEST_ASSERT_TRUE(scheduler.due(PublishScheduler::TASK_COUNTERS, COUNTER_PUBLISH_INTERVAL));
+    TEST_ASSERT_FALSE(scheduler.due(PublishScheduler::TASK_COUNTERS, COUNTER_PUBLISH_INTERVAL));
+}
+
+void test_realign_restarts_at_phase_after_reconnect() {
+    PublishScheduler scheduler;
+    scheduler.begin("24:6F:28:00:00:09");
+    uint32_t phase = scheduler.getPhase(PublishScheduler::TASK_HEARTBEAT, HEARTBEAT_INTERVAL);
+
+    scheduler.due(PublishScheduler::TASK_HEARTBEAT, HEARTBEAT_INTERVAL);
+    ArduinoStub::nowMs = 100000;
+    scheduler.realign();
+    TEST_ASSERT_FALSE(scheduler.due(PublishScheduler::TASK_HEARTBEAT, HEARTBEAT_INTERVAL));
+
+    ArduinoStub::nowMs = 100000 + phase;
+    TEST_ASSERT_TRUE(scheduler.due(PublishScheduler::TASK_HEARTBEAT, HEARTBEAT_INTERVAL));
+}
+
+void test_fleet_rate_is_smooth() {
+    // All devices powered by the same breaker: same boot and connect time.
+    // Each loop() checks heartbeat and announcement, as in main.cpp.
+    std::vector<PublishScheduler> fleet(FLEET_SIZE);
+    for (int i = 0; i < FLEET_SIZE; i++) {
+        char mac[18];
+        fleetMAC(i, mac, sizeof(mac));
+        fleet[i].begin(mac);
+    }
+
+    std::vector<uint32_t> phased(SIMULATED_MS / 1000, 0);
+    std::vector<uint32_t> aligned(SIMULATED_MS / 1000, 0);
+    std::vector<unsigned long> lastHeartbeat(FLEET_SIZE, 0);
+    std::vector<unsigned long> lastAnnouncement(FLEET_SIZE, 0);
+
+    for (unsigned long now = 0; now < SIMULATED_MS; now += LOOP_STEP_MS) {
+        ArduinoStub::nowMs = now;
+        uint32_t second = now / 1000;
+
+        for (int i = 0; i < FLEET_SIZE; i++) {
+            phased[second] += fleet[i].due(PublishScheduler::TASK_HEARTBEAT, HEARTBEAT_INTERVAL);
+            phased[second] += fleet[i].due(PublishScheduler::TASK_ANNOUNCEMENT, ANNOUNCEMENT_INTERVAL);
+
+            // Former main.cpp timers: last* start at 0 on every device
+            if (now - lastHeartbeat[i] >= HEARTBEAT_INTERVAL) {
+                lastHeartbeat[i] = now;
+                aligned[second]++;
+            }
+            if (now - lastAnnouncement[i] >= ANNOUNCEMENT_INTERVAL) {
+                lastAnnouncement[i] = now;
+                aligned[second]++;
+            }
+        }
+    }
+
+    // Skip the first announcement interval - phased schedules start within it
+    phased.erase(phased.begin(), phased.begin() + ANNOUNCEMENT_INTERVAL / 1000);
+    aligned.erase(aligned.begin(), aligned.begin() + ANNOUNCEMENT_INTERVAL / 1000);
+    RateStats phasedStats = rateStats(phased);
+    RateStats alignedStats = rateStats(aligned);
+    report("aligned", alignedStats);
+    report("phased", phasedStats);
+
+    // Same load on average, 500 / 30 s + 500 / 60 s = 25 msg/s
+    double expected = FLEET_SIZE * (1000.0 / HEARTBEAT_INTERVAL + 1000.0 / ANNOUNCEMENT_INTERVAL);
+    TEST_ASSERT_TRUE(phasedStats.mean > expected * 0.95 && phasedStats.mean < expected * 1.05);
+    TEST_ASSERT_TRUE(alignedStats.mean > expected * 0.95 && alignedStats.mean < expected * 1.05);
+
+    // Phased: no bursts, variance orders of magnitude below the aligned fleet
+    TEST_ASSERT_TRUE(phasedStats.variance * 100 < alignedStats.variance);
+    TEST_ASSERT_LESS_THAN_UINT32(3 * expected, phasedStats.peak);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_phase_is_deterministic_and_within_interval);
+    RUN_TEST(test_first_due_schedules_at_phase_then_every_interval);
+    RUN_TEST(test_missed_slots_are_skipped);
+    RUN_TEST(test_realign_restarts_at_phase_after_reconnect);
+    RUN_TEST(test_fleet_rate_is_smooth);
+    return UNITY_END();
+}
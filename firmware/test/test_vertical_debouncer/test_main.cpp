@@ -0,0 +1,176 @@
+// VerticalDebouncer: debounce behaviour and a benchmark against the former
+// per-channel path (native env: pio test -e native)
+
+#include <unity.h>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "config.h"
+#include "gpio/vertical_debouncer.h"
+
+// The debouncer DigitalInputManager used before: per-channel state, last
+// reading and debounce timer, one pin at a time
+struct PerChannelDebouncer {
+    bool inputState[8];
+    bool lastReading[8];
+    unsigned long lastDebounceTime[8];
+    unsigned long debounceDelay;
+
+    explicit PerChannelDebouncer(unsigned long delayMs) : debounceDelay(delayMs) {
+        for (int i = 0; i < 8; i++) {
+            inputState[i] = false;
+            lastReading[i] = false;
+            lastDebounceTime[i] = 0;
+        }
+    }
+
+    uint8_t sample(uint8_t raw, unsigned long nowMs) {
+        uint8_t changed = 0;
+        for (int i = 0; i < 8; i++) {
+            bool reading = (raw >> i) & 0x01;
+            if (reading != lastReading[i]) {
+                lastDebounceTime[i] = nowMs;
+            }
+            if (nowMs - lastDebounceTime[i] > debounceDelay && reading != inputState[i]) {
+                inputState[i] = reading;
+                changed |= 1 << i;
+            }
+            lastReading[i] = reading;
+        }
+        return changed;
+    }
+
+    uint8_t getState() const {
+        uint8_t mask = 0;
+        for (int i = 0; i < 8; i++) {
+            mask |= (inputState[i] ? 1 : 0) << i;
+        }
+        return mask;
+    }
+};
+
+void setUp() {}
+void tearDown() {}
+
+void test_change_commits_after_samples_consecutive_samples() {
+    VerticalDebouncer debouncer;
+    debouncer.reset(0x00);
+
+    for (uint8_t i = 1; i < VerticalDebouncer::SAMPLES; i++) {
+        TEST_ASSERT_EQUAL_HEX8(0x00, debouncer.sample(0x01));
+        TEST_ASSERT_EQUAL_HEX8(0x00, debouncer.getState());
+    }
+    TEST_ASSERT_EQUAL_HEX8(0x01, debouncer.sample(0x01));
+    TEST_ASSERT_EQUAL_HEX8(0x01, debouncer.getState());
+
+    // Stable input: no further changes
+    TEST_ASSERT_EQUAL_HEX8(0x00, debouncer.sample(0x01));
+}
+
+void test_bounce_resets_the_count() {
+    VerticalDebouncer debouncer;
+    debouncer.reset(0x00);
+
+    // Contact bounce: never SAMPLES agreeing samples in a row
+    for (int i = 0; i < 100; i++) {
+        uint8_t raw = (i % (VerticalDebouncer::SAMPLES - 1) == 0) ? 0x00 : 0x80;
+        TEST_ASSERT_EQUAL_HEX8(0x00, debouncer.sample(raw));
+    }
+    TEST_ASSERT_EQUAL_HEX8(0x00, debouncer.getState());
+}
+
+void test_channels_are_independent() {
+    VerticalDebouncer debouncer;
+    debouncer.reset(0x00);
+
+    // CH1 bounces every sample while CH4 switches cleanly
+    uint8_t changes = 0;
+    for (uint8_t i = 0; i < VerticalDebouncer::SAMPLES; i++) {
+        changes |= debouncer.sample(0x08 | (i & 1));
+    }
+    TEST_ASSERT_EQUAL_HEX8(0x08, changes);
+    TEST_ASSERT_EQUAL_HEX8(0x08, debouncer.getState());
+}
+
+void test_matches_per_channel_path_on_noisy_input() {
+    // Random 8-channel signal: stable segments with bursts of bounce. Both
+    // debouncers must agree on the state once each segment has settled.
+    const unsigned long intervalMs = INPUT_SAMPLE_INTERVAL_US / 1000;
+    const unsigned long windowMs = VerticalDebouncer::SAMPLES * intervalMs;
+
+    std::mt19937 rng(1234);
+    VerticalDebouncer vertical;
+    PerChannelDebouncer reference(windowMs - intervalMs);
+    vertical.reset(0x00);
+
+    unsigned long nowMs = 0;
+    uint8_t level = 0x00;
+    for (int segment = 0; segment < 500; segment++) {
+        level = (uint8_t)rng();
+
+        // Bounce: a few samples of noise on the changing channels
+        int bounce = rng() % VerticalDebouncer::SAMPLES;
+        for (int i = 0; i < bounce; i++) {
+            uint8_t noisy = level ^ ((uint8_t)rng() & (uint8_t)rng());
+            vertical.sample(noisy);
+            reference.sample(noisy, nowMs);
+            nowMs += intervalMs;
+        }
+
+        // Stable for twice the window
+        for (unsigned long i = 0; i < 2 * VerticalDebouncer::SAMPLES; i++) {
+            vertical.sample(level);
+            reference.sample(level, nowMs);
+            nowMs += intervalMs;
+        }
+
+        TEST_ASSERT_EQUAL_HEX8(level, vertical.getState());
+        TEST_ASSERT_EQUAL_HEX8(level, reference.getState());
+    }
+}
+
+void test_benchmark_against_per_channel_path() {
+    const uint32_t samples = 2000000;
+    std::vector<uint8_t> input(4096);
+    std::mt19937 rng(42);
+    for (size_t i = 0; i < input.size(); i++) {
+        // Mostly stable with occasional flips, like real inputs
+        input[i] = (rng() % 16 == 0) ? (uint8_t)rng() : (i ? input[i - 1] : 0);
+    }
+
+    VerticalDebouncer vertical;
+    vertical.reset(0);
+    volatile uint8_t sink = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < samples; i++) {
+        sink ^= vertical.sample(input[i & 4095]);
+    }
+    double verticalNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / samples;
+
+    PerChannelDebouncer reference(DEBOUNCE_DELAY);
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < samples; i++) {
+        sink ^= reference.sample(input[i & 4095], i / 8);
+    }
+    double perChannelNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / samples;
+
+    char line[128];
+    snprintf(line, sizeof(line), "vertical %.2f ns/sample, per-channel %.2f ns/sample (%.1fx)",
+             verticalNs, perChannelNs, perChannelNs / verticalNs);
+    TEST_MESSAGE(line);
+    (void)sink;
+
+    // Host timings only indicate the ratio; the vertical path must not be slower
+    TEST_ASSERT_TRUE(verticalNs <= perChannelNs);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_change_commits_after_samples_consecutive_samples);
+    RUN_TEST(test_bounce_resets_the_count);
+    RUN_TEST(test_channels_are_independent);
+    RUN_TEST(test_matches_per_channel_path_on_noisy_input);
+    RUN_TEST(test_benchmark_against_per_channel_path);
+    return UNITY_END();
+}
@@ -0,0 +1,103 @@
+// Configuration UI script (shared by all pages)
+//
+// Pages are static and served gzipped from flash with an ETag, so the
+// browser revalidates them with a 304. Device values come from /api/info:
+//   data-info="key"      element text / input value / checkbox state
+//   data-format="..."    yesno | mode | dhcp | seconds | bytes | mhz
+//   data-when="..."      shown only when wifi | ethernet | static | ssid
+
+const FORMATS = {
+  yesno: v => (v ? 'Yes' : 'No'),
+  mode: v => (v === 'wifi' ? 'WiFi' : 'Ethernet'),
+  dhcp: v => (v ? 'DHCP' : 'Static IP'),
+  seconds: v => v + ' seconds',
+  bytes: v => v + ' bytes',
+  mhz: v => v + ' MHz',
+};
+
+const CONDITIONS = {
+  wifi: info => info.connection_mode === 'wifi',
+  ethernet: info => info.connection_mode !== 'wifi',
+  static: info => info.connection_mode !== 'wifi' && !info.use_dhcp,
+  ssid: info => info.wifi_ssid.length > 0,
+};
+
+function applyInfo(info) {
+  document.querySelectorAll('[data-info]').forEach(el => {
+    const value = info[el.dataset.info];
+    if (value === undefined) return;
+    if (el.type === 'checkbox') {
+      el.checked = !!value;
+    } else if (el.tagName === 'INPUT') {
+      el.value = value;
+    } else {
+      const format = FORMATS[el.dataset.format];
+      el.textContent = format ? format(value) : value;
+    }
+  });
+  document.querySelectorAll('[data-when]').forEach(el => {
+    el.style.display = CONDITIONS[el.dataset.when](info) ? '' : 'none';
+  });
+}
+
+function loadInfo() {
+  return fetch('/api/info')
+    .then(r => r.json())
+    .then(info => {
+      applyInfo(info);
+      return info;
+    });
+}
+
+function showResult(d) {
+  const msg = document.getElementById('message');
+  msg.textContent = d.message;
+  msg.className = 'message ' + (d.success ? 'success' : 'error');
+}
+
+function postForm(url, data, redirect) {
+  return fetch(url, {method: 'POST', body: data})
+    .then(r => r.json())
+    .then(d => {
+      showResult(d);
+      if (d.success && redirect) setTimeout(() => location.href = '/', 2000);
+    });
+}
+
+function submitForm(e, url, redirect) {
+  e.preventDefault();
+  postForm(url, new URLSearchParams(new FormData(e.target)), redirect);
+}
+
+function toggleStaticIP() {
+  const checked = document.getElementById('useDHCP').checked;
+  document.getElementById('staticIPFields').style.display = checked ? 'none' : 'block';
+}
+
+function saveEthernet(e) {
+  e.preventDefault();
+  const formData = new FormData(e.target);
+  const data = new URLSearchParams();
+  data.append('use_dhcp', formData.get('use_dhcp') ? 'true' : 'false');
+  if (formData.get('use_dhcp') !== 'on') {
+    data.append('static_ip', formData.get('static_ip'));
+    data.append('gateway', formData.get('gateway'));
+    data.append('subnet', formData.get('subnet'));
+    data.append('dns', formData.get('dns'));
+  }
+  postForm('/save-ethernet', data, false);
+}
+
+function rebootDevice() {
+  fetch('/reboot', {method: 'POST'}).then(r => r.json()).then(d => alert(d.message));
+}
+
+function resetDevice() {
+  fetch('/reset', {method: 'POST'}).then(r => r.json()).then(d => alert(d.message));
+}
+
+window.addEventListener('load', () => {
+  loadInfo().then(() => {
+    if (document.getElementById('staticIPFields')) toggleStaticIP();
+  });
+});